@@ -0,0 +1,108 @@
+//ordering overhead and parallelism benchmark for src/CommandExecutor
+//usage: rnbo-bench-executor [jobs] [job microseconds]
+//
+//submits a burst of jobs that each spin for a fixed time and reports how long the executor takes to run them all
+//keys decide what can overlap: jobs on different instances can run together, jobs on the same resource
+//and jobs with the empty key can't, so those should take about as long as running everything in one thread
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CommandExecutor.h"
+
+namespace {
+	const std::vector<unsigned int> worker_counts = { 0, 1, 2, 4 };
+	const unsigned int instances = 8;
+
+	struct Scenario {
+		std::string name;
+		std::function<std::vector<std::string>(size_t job)> keys;
+	};
+
+	const std::vector<Scenario> scenarios = {
+		{ "instances", [](size_t job) { return std::vector<std::string>{ "instance/" + std::to_string(job % instances) }; } },
+		{ "same key", [](size_t) { return std::vector<std::string>{ "db/sets" }; } },
+		{ "global", [](size_t) { return std::vector<std::string>{ std::string() }; } },
+	};
+
+	void spin(std::chrono::microseconds duration) {
+		auto end = std::chrono::steady_clock::now() + duration;
+		while (std::chrono::steady_clock::now() < end) {
+		}
+	}
+
+	double run(const Scenario& scenario, unsigned int workers, size_t jobs, std::chrono::microseconds work) {
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::atomic<size_t> done = 0;
+
+		CommandExecutor executor(workers, [&mutex, &condition] {
+			std::lock_guard<std::mutex> guard(mutex);
+			condition.notify_one();
+		});
+
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < jobs; i++) {
+			executor.submit(scenario.keys(i), CommandExecutor::Thread::Worker, [&done, work] {
+				spin(work);
+				done.fetch_add(1, std::memory_order_release);
+			});
+		}
+
+		if (workers == 0) {
+			//everything runs in the calling thread, like the controller with no workers configured
+			executor.runController();
+		} else {
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [&done, jobs] { return done.load(std::memory_order_acquire) == jobs; });
+		}
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+int main(int argc, char * argv[]) {
+	size_t jobs = 2000;
+	std::chrono::microseconds work(50);
+	if (argc > 1) {
+		jobs = std::strtoul(argv[1], nullptr, 10);
+	}
+	if (argc > 2) {
+		work = std::chrono::microseconds(std::strtoul(argv[2], nullptr, 10));
+	}
+
+	const double serial = static_cast<double>(jobs) * std::chrono::duration<double>(work).count();
+	std::cout << jobs << " jobs of " << work.count() << "us, " << serial * 1e3 << "ms if run back to back, "
+		<< std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+	std::cout << std::left << std::setw(12) << "keys"
+		<< std::right << std::setw(8) << "workers"
+		<< std::setw(12) << "ms"
+		<< std::setw(12) << "speedup"
+		<< std::setw(16) << "overhead us/job"
+		<< std::endl;
+
+	for (const auto& scenario: scenarios) {
+		for (auto workers: worker_counts) {
+			double seconds = run(scenario, workers, jobs, work);
+			//time beyond the ideal split of the work across the threads that can run it
+			unsigned int parallel = std::min({workers, scenario.name == "instances" ? instances : 1u, std::max(1u, std::thread::hardware_concurrency())});
+			double ideal = serial / std::max(1u, parallel);
+			std::cout << std::left << std::setw(12) << scenario.name
+				<< std::right << std::setw(8) << workers
+				<< std::setw(12) << std::fixed << std::setprecision(2) << seconds * 1e3
+				<< std::setw(12) << std::setprecision(2) << serial / seconds
+				<< std::setw(16) << std::setprecision(2) << std::max(0.0, seconds - ideal) * 1e6 / static_cast<double>(jobs)
+				<< std::endl;
+		}
+	}
+	return 0;
+}
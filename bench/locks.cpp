@@ -0,0 +1,131 @@
+//build lock contention benchmark for the instance subtrees of src/Controller
+//usage: rnbo-bench-locks [rounds per thread] [params per instance]
+//
+//every thread owns an instance and, round after round, attaches its subtree under /rnbo/inst, builds its parameters,
+//loads a few presets into them and removes the subtree again, like instances being loaded and unloaded
+//with the split locks only attaching and removing take the build lock and the rest holds the instance's own lock,
+//with the single lock that replaced everything is done under the one build lock, as before
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ossia/network/base/node.hpp>
+#include <ossia/network/base/node_functions.hpp>
+#include <ossia/network/base/parameter.hpp>
+#include <ossia/network/generic/generic_device.hpp>
+#include <ossia/network/local/local.hpp>
+
+namespace {
+	const std::vector<unsigned int> thread_counts = { 1, 2, 4, 8 };
+	const unsigned int loads_per_round = 4;
+
+	//the build lock guarding everything, as it was
+	class SingleLock {
+		public:
+			SingleLock(unsigned int) { }
+			std::mutex& build() { return mBuild; }
+			std::mutex& instance(unsigned int) { return mBuild; }
+		private:
+			std::mutex mBuild;
+	};
+
+	//the build lock for attaching and removing subtrees and a lock per instance for the rest
+	class SplitLocks {
+		public:
+			SplitLocks(unsigned int instances) : mInstances(instances) { }
+			std::mutex& build() { return mBuild; }
+			std::mutex& instance(unsigned int index) { return mInstances[index]; }
+		private:
+			std::mutex mBuild;
+			std::vector<std::mutex> mInstances;
+	};
+
+	template <typename Locks>
+	double run(unsigned int threads, size_t rounds, unsigned int params) {
+		ossia::net::generic_device device(std::make_unique<ossia::net::multiplex_protocol>(), "rnbo-bench");
+		auto& inst = ossia::net::create_node(device.get_root_node(), "/rnbo/inst");
+		Locks locks(threads);
+
+		auto start = std::chrono::steady_clock::now();
+		std::vector<std::thread> workers;
+		for (unsigned int t = 0; t < threads; t++) {
+			workers.emplace_back([&inst, &locks, t, rounds, params] {
+				const std::string name = std::to_string(t);
+				for (size_t r = 0; r < rounds; r++) {
+					ossia::net::node_base * node = nullptr;
+					{
+						std::lock_guard<std::mutex> guard(locks.build());
+						node = inst.create_child(name);
+					}
+
+					std::vector<ossia::net::parameter_base *> built;
+					{
+						std::lock_guard<std::mutex> guard(locks.instance(t));
+						auto paramsNode = node->create_child("params");
+						for (unsigned int p = 0; p < params; p++) {
+							auto child = paramsNode->create_child("p" + std::to_string(p));
+							built.push_back(child->create_parameter(ossia::val_type::FLOAT));
+							built.push_back(child->create_child("normalized")->create_parameter(ossia::val_type::FLOAT));
+						}
+					}
+
+					for (unsigned int l = 0; l < loads_per_round; l++) {
+						std::lock_guard<std::mutex> guard(locks.instance(t));
+						for (auto param: built) {
+							param->push_value(static_cast<float>(l));
+						}
+					}
+
+					{
+						std::lock_guard<std::mutex> guard(locks.build());
+						inst.remove_child(name);
+					}
+				}
+			});
+		}
+		for (auto& w: workers) {
+			w.join();
+		}
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+int main(int argc, char * argv[]) {
+	size_t rounds = 50;
+	unsigned int params = 500;
+	if (argc > 1) {
+		rounds = std::max<size_t>(1, std::strtoul(argv[1], nullptr, 10));
+	}
+	if (argc > 2) {
+		params = static_cast<unsigned int>(std::max<unsigned long>(1, std::strtoul(argv[2], nullptr, 10)));
+	}
+
+	std::cout << rounds << " rounds per thread of building " << params << " params and loading " << loads_per_round << " presets, "
+		<< std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+	std::cout << std::right << std::setw(8) << "threads"
+		<< std::setw(12) << "single ms"
+		<< std::setw(12) << "split ms"
+		<< std::setw(12) << "rounds/s"
+		<< std::setw(10) << "speedup"
+		<< std::endl;
+
+	for (auto threads: thread_counts) {
+		double single = run<SingleLock>(threads, rounds, params);
+		double split = run<SplitLocks>(threads, rounds, params);
+		std::cout << std::right << std::setw(8) << threads
+			<< std::setw(12) << std::fixed << std::setprecision(2) << single * 1e3
+			<< std::setw(12) << std::setprecision(2) << split * 1e3
+			<< std::setw(12) << std::setprecision(0) << static_cast<double>(rounds * threads) / split
+			<< std::setw(10) << std::setprecision(2) << single / split
+			<< std::endl;
+	}
+	return 0;
+}
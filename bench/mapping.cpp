@@ -0,0 +1,186 @@
+//mapped OSC benchmark for the path from incoming OSC to the parameters it is mapped to
+//usage: rnbo-bench-mapping [messages per second] [seconds] [mapped addresses]
+//
+//a network thread queues mapped updates at a fixed rate into a queue sized like the controller's, the main loop
+//wakes for them, resolves each local address to its parameters and pushes the value, like Controller::processEvents
+//reports how long updates wait between being queued and reaching their parameter and how many are dropped,
+//resolving through OSCRouteCache is compared against running find_nodes for every update, as was done before it
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <boost/container/small_vector.hpp>
+
+#include <ossia/network/base/node.hpp>
+#include <ossia/network/base/node_functions.hpp>
+#include <ossia/network/base/parameter.hpp>
+#include <ossia/network/generic/generic_device.hpp>
+#include <ossia/network/local/local.hpp>
+
+#include "OSCRouteCache.h"
+#include "Queue.h"
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+	using Resolve = std::function<const std::vector<ossia::net::parameter_base *>&(std::string_view)>;
+
+	//the same as the controller's mOSCMappedUpdateQueue and its process period
+	const size_t queue_capacity = 8192;
+	const std::chrono::milliseconds process_poll_period(10);
+	const unsigned int instances = 8;
+	const unsigned int params_per_instance = 250;
+
+	struct Update {
+		std::string addr;
+		ossia::value value;
+		Clock::time_point queued;
+	};
+
+	struct Result {
+		size_t sent = 0;
+		size_t dropped = 0;
+		std::vector<double> latency; //microseconds, for every update that reached its parameter
+		double busy = 0.0; //seconds the main loop spent handling updates
+	};
+
+	Result run(const std::vector<std::string>& addrs, const Resolve& resolve, double rate, double seconds) {
+		Queue<Update> queue(queue_capacity);
+		std::atomic<bool> done = false;
+		Result result;
+
+		std::thread network([&queue, &addrs, &done, &result, rate, seconds] {
+			const size_t count = static_cast<size_t>(rate * seconds);
+			const auto start = Clock::now();
+			for (size_t i = 0; i < count; i++) {
+				std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(static_cast<double>(i) / rate)));
+				queue.push({ addrs[i % addrs.size()], ossia::value(static_cast<float>(i % 128) / 127.0f), Clock::now() });
+				result.sent++;
+			}
+			done = true;
+		});
+
+		result.latency.reserve(static_cast<size_t>(rate * seconds));
+		auto handle = [&resolve, &result](const Update& update) {
+			const auto& resolved = resolve(update.addr);
+			boost::container::small_vector<ossia::net::parameter_base *, 4> params(resolved.begin(), resolved.end());
+			for (auto param: params) {
+				param->push_value(update.value);
+			}
+			result.latency.push_back(std::chrono::duration<double, std::micro>(Clock::now() - update.queued).count());
+		};
+
+		while (true) {
+			const bool finished = done.load();
+			auto update = queue.popTimeout(process_poll_period);
+			if (!update) {
+				if (finished) {
+					break;
+				}
+				continue;
+			}
+			auto start = Clock::now();
+			handle(update.get());
+			while (auto next = queue.tryPop()) {
+				handle(next.get());
+			}
+			result.busy += std::chrono::duration<double>(Clock::now() - start).count();
+		}
+		network.join();
+		result.dropped = queue.overflowed();
+		return result;
+	}
+
+	double percentile(std::vector<double>& values, double p) {
+		if (values.empty()) {
+			return 0.0;
+		}
+		auto index = std::min(values.size() - 1, static_cast<size_t>(p * static_cast<double>(values.size())));
+		std::nth_element(values.begin(), values.begin() + index, values.end());
+		return values[index];
+	}
+}
+
+int main(int argc, char * argv[]) {
+	double rate = 5000.0;
+	double seconds = 5.0;
+	size_t mapped = 256;
+	if (argc > 1) {
+		rate = std::max(1.0, std::strtod(argv[1], nullptr));
+	}
+	if (argc > 2) {
+		seconds = std::max(0.1, std::strtod(argv[2], nullptr));
+	}
+	if (argc > 3) {
+		mapped = std::max<size_t>(1, std::strtoul(argv[3], nullptr, 10));
+	}
+
+	//a runner shaped tree, each parameter has a callback standing in for the instance taking the value
+	auto device = std::make_unique<ossia::net::generic_device>(std::make_unique<ossia::net::multiplex_protocol>(), "rnbo-bench");
+	auto& root = device->get_root_node();
+	std::atomic<uint64_t> received = 0;
+	for (unsigned int i = 0; i < instances; i++) {
+		for (unsigned int p = 0; p < params_per_instance; p++) {
+			const std::string base = "/rnbo/inst/" + std::to_string(i) + "/params/p" + std::to_string(p);
+			for (auto addr: { base, base + "/normalized" }) {
+				auto param = ossia::net::create_node(root, addr).create_parameter(ossia::val_type::FLOAT);
+				param->add_callback([&received](const ossia::value&) { received.fetch_add(1, std::memory_order_relaxed); });
+			}
+		}
+	}
+
+	//the local addresses incoming OSC is mapped to, spread across the instances
+	std::vector<std::string> addrs;
+	for (size_t m = 0; m < mapped; m++) {
+		addrs.push_back("/rnbo/inst/" + std::to_string(m % instances) + "/params/p" + std::to_string((m / instances) % params_per_instance) + "/normalized");
+	}
+
+	OSCRouteCache cache(root, 4096);
+	std::vector<ossia::net::parameter_base *> found;
+	const std::vector<std::pair<std::string, Resolve>> resolvers = {
+		{ "cache", [&cache](std::string_view addr) -> const std::vector<ossia::net::parameter_base *>& { return cache.resolve(addr); } },
+		{ "find_nodes", [&root, &found](std::string_view addr) -> const std::vector<ossia::net::parameter_base *>& {
+			found.clear();
+			for (auto n: ossia::net::find_nodes(root, addr)) {
+				if (auto param = n->get_parameter()) {
+					found.push_back(param);
+				}
+			}
+			return found;
+		} },
+	};
+
+	std::cout << rate << " msgs/s for " << seconds << "s across " << mapped << " mapped addresses, "
+		<< instances * params_per_instance << " params" << std::endl;
+	std::cout << std::left << std::setw(12) << "resolve"
+		<< std::right << std::setw(10) << "sent"
+		<< std::setw(10) << "dropped"
+		<< std::setw(12) << "p50 us"
+		<< std::setw(12) << "p99 us"
+		<< std::setw(12) << "max us"
+		<< std::setw(10) << "busy %"
+		<< std::endl;
+
+	for (const auto& [name, resolve]: resolvers) {
+		auto result = run(addrs, resolve, rate, seconds);
+		const double max = result.latency.empty() ? 0.0 : *std::max_element(result.latency.begin(), result.latency.end());
+		std::cout << std::left << std::setw(12) << name
+			<< std::right << std::setw(10) << result.sent
+			<< std::setw(10) << result.dropped
+			<< std::setw(12) << std::fixed << std::setprecision(1) << percentile(result.latency, 0.5)
+			<< std::setw(12) << std::setprecision(1) << percentile(result.latency, 0.99)
+			<< std::setw(12) << std::setprecision(1) << max
+			<< std::setw(10) << std::setprecision(1) << result.busy * 100.0 / seconds
+			<< std::endl;
+	}
+	return 0;
+}
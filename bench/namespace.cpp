@@ -0,0 +1,126 @@
+//OSCQuery namespace reply benchmark for src/NamespaceServer
+//usage: rnbo-bench-namespace [params per instance] [gets per measurement]
+//
+//builds a tree shaped like the runner's, /rnbo/inst/N/params/pM with a normalized child each, for a growing
+//number of instances and times NamespaceCache::get("/") the way the HTTP server calls it:
+//cold, after every bucket was dropped, after a single value change, which only serializes that instance again,
+//and with nothing changed, against serializing the whole tree for every request like the OSCQuery server does
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ossia/network/base/node.hpp>
+#include <ossia/network/base/node_functions.hpp>
+#include <ossia/network/base/parameter.hpp>
+#include <ossia/network/generic/generic_device.hpp>
+#include <ossia/network/local/local.hpp>
+#include <ossia/protocols/oscquery/detail/json_writer.hpp>
+
+#include "NamespaceServer.h"
+
+namespace {
+	const std::vector<unsigned int> instance_counts = { 1, 2, 5, 10, 20 };
+
+	template <typename F>
+	double measure(size_t reps, F func) {
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < reps; i++) {
+			func(i);
+		}
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / static_cast<double>(reps);
+	}
+
+	struct Tree {
+		std::unique_ptr<ossia::net::generic_device> device;
+		NamespaceCache * cache = nullptr;
+		std::vector<ossia::net::parameter_base *> params; //the first parameter of every instance
+	};
+
+	Tree build(unsigned int instances, unsigned int params) {
+		Tree tree;
+		auto proto = new ossia::net::multiplex_protocol();
+		tree.device = std::make_unique<ossia::net::generic_device>(std::unique_ptr<ossia::net::protocol_base>(proto), "rnbo-bench");
+		{
+			auto cache = std::make_unique<NamespaceCache>(*tree.device);
+			tree.cache = cache.get();
+			proto->expose_to(std::move(cache));
+		}
+
+		auto& root = tree.device->get_root_node();
+		auto& inst = ossia::net::create_node(root, "/rnbo/inst");
+		tree.cache->split(&inst);
+		ossia::net::create_node(root, "/rnbo/info/version").create_parameter(ossia::val_type::STRING)->push_value(std::string("bench"));
+
+		for (unsigned int i = 0; i < instances; i++) {
+			const std::string base = "/rnbo/inst/" + std::to_string(i);
+			ossia::net::create_node(root, base + "/name").create_parameter(ossia::val_type::STRING)->push_value("instance" + std::to_string(i));
+			for (unsigned int p = 0; p < params; p++) {
+				auto& node = ossia::net::create_node(root, base + "/params/p" + std::to_string(p));
+				auto param = node.create_parameter(ossia::val_type::FLOAT);
+				param->push_value(0.0f);
+				node.create_child("normalized")->create_parameter(ossia::val_type::FLOAT)->push_value(0.0f);
+				if (p == 0) {
+					tree.params.push_back(param);
+				}
+			}
+		}
+		return tree;
+	}
+}
+
+int main(int argc, char * argv[]) {
+	unsigned int params = 100;
+	size_t reps = 50;
+	if (argc > 1) {
+		params = static_cast<unsigned int>(std::strtoul(argv[1], nullptr, 10));
+	}
+	if (argc > 2) {
+		reps = std::max<size_t>(1, std::strtoul(argv[2], nullptr, 10));
+	}
+
+	std::cout << params << " params per instance, " << reps << " gets per measurement" << std::endl;
+	std::cout << std::right << std::setw(10) << "instances"
+		<< std::setw(10) << "KB"
+		<< std::setw(14) << "full ms"
+		<< std::setw(14) << "cold ms"
+		<< std::setw(14) << "value ms"
+		<< std::setw(14) << "cached us"
+		<< std::endl;
+
+	for (auto instances: instance_counts) {
+		Tree tree = build(instances, params);
+		auto& root = tree.device->get_root_node();
+
+		size_t bytes = 0;
+		double full = measure(reps, [&root, &bytes](size_t) {
+			auto json = ossia::oscquery::json_writer::query_namespace(root);
+			bytes = json.GetSize();
+		});
+		double cold = measure(reps, [&tree](size_t) {
+			tree.cache->structureChanged();
+			tree.cache->get("/", false);
+		});
+		double value = measure(reps, [&tree](size_t i) {
+			tree.params[i % tree.params.size()]->push_value(static_cast<float>(i));
+			tree.cache->get("/", false);
+		});
+		double cached = measure(reps, [&tree](size_t) {
+			tree.cache->get("/", false);
+		});
+
+		std::cout << std::right << std::setw(10) << instances
+			<< std::setw(10) << std::fixed << std::setprecision(1) << static_cast<double>(bytes) / 1024.0
+			<< std::setw(14) << std::setprecision(3) << full * 1e3
+			<< std::setw(14) << std::setprecision(3) << cold * 1e3
+			<< std::setw(14) << std::setprecision(3) << value * 1e3
+			<< std::setw(14) << std::setprecision(2) << cached * 1e6
+			<< std::endl;
+	}
+	return 0;
+}
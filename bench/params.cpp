@@ -0,0 +1,235 @@
+//parameter table benchmark for the OSC control path of src/Instance
+//usage: rnbo-bench-params [messages] [params]
+//
+//builds an instance's parameters, 2000 by default, each with a value and a normalized node and callbacks like the
+//ones Instance installs, then drives them round robin from one thread as fast as it can: every message is resolved
+//with OSCRouteCache like mapped OSC, pushed into its node, handled through the parameter table and echoed to the
+//other node, whose callback is then suppressed as recursion
+//Instance needs RNBO so its table is reproduced here, the dense table it uses now against the map it replaced,
+//with a 0..100 range standing in for RNBO's parameter conversions
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/container/small_vector.hpp>
+
+#include <ossia/network/base/node.hpp>
+#include <ossia/network/base/node_functions.hpp>
+#include <ossia/network/base/parameter.hpp>
+#include <ossia/network/generic/generic_device.hpp>
+#include <ossia/network/local/local.hpp>
+
+#include "OSCRouteCache.h"
+
+namespace {
+	const float range = 100.0f;
+
+	//what Instance uses now: entries indexed by parameter, recursion tracked per thread
+	struct DenseTable {
+		struct Entry {
+			ossia::net::parameter_base * param = nullptr;
+			ossia::net::parameter_base * normparam = nullptr;
+			std::atomic<float> normvalue = 0.0f;
+			std::atomic<bool> dirty = false;
+		};
+
+		class Guard {
+			public:
+				Guard(Entry& entry, std::atomic<uint64_t>& suppressed) : mKey(&entry) {
+					mEntered = std::find(tActive.begin(), tActive.end(), mKey) == tActive.end();
+					if (mEntered) {
+						tActive.push_back(mKey);
+					} else {
+						suppressed.fetch_add(1, std::memory_order_relaxed);
+					}
+				}
+				~Guard() {
+					if (mEntered) {
+						tActive.pop_back();
+					}
+				}
+				Guard(const Guard&) = delete;
+				Guard& operator=(const Guard&) = delete;
+				explicit operator bool() const { return mEntered; }
+			private:
+				static inline thread_local std::vector<const void *> tActive;
+				const void * mKey;
+				bool mEntered;
+		};
+
+		DenseTable(size_t count) : entries(count) { }
+		Entry& add(size_t index) { return entries[index]; }
+		Entry * find(size_t index) {
+			return index < entries.size() && entries[index].param != nullptr ? &entries[index] : nullptr;
+		}
+		static void track(Entry& entry, float norm) {
+			entry.normvalue.store(norm, std::memory_order_relaxed);
+			entry.dirty.store(true, std::memory_order_release);
+		}
+
+		std::vector<Entry> entries;
+	};
+
+	//what Instance used before: a map with a mutex per entry as the recursion guard and hash maps for enums
+	struct MapTable {
+		struct Entry {
+			std::shared_ptr<std::mutex> mutex = std::make_shared<std::mutex>();
+			std::shared_ptr<std::mutex> oscmutex = std::make_shared<std::mutex>();
+			ossia::net::parameter_base * param = nullptr;
+			ossia::net::parameter_base * normparam = nullptr;
+			std::unordered_map<std::string, double> nameToVal;
+			std::unordered_map<int, std::string> valToName;
+		};
+
+		class Guard {
+			public:
+				Guard(Entry& entry, std::atomic<uint64_t>& suppressed) : mLock(*entry.mutex, std::try_to_lock) {
+					if (!mLock.owns_lock()) {
+						suppressed.fetch_add(1, std::memory_order_relaxed);
+					}
+				}
+				explicit operator bool() const { return mLock.owns_lock(); }
+			private:
+				std::unique_lock<std::mutex> mLock;
+		};
+
+		MapTable(size_t) { }
+		Entry& add(size_t index) { return entries[index]; }
+		Entry * find(size_t index) {
+			auto it = entries.find(index);
+			return it != entries.end() ? &it->second : nullptr;
+		}
+		static void track(Entry&, float) { }
+
+		std::map<size_t, Entry> entries;
+	};
+
+	//the parameter callbacks of an Instance, over one of the tables
+	template <typename Table>
+	class Params {
+		public:
+			Params(ossia::net::node_base& root, size_t count) : mTable(count), mValues(count, 0.0f) {
+				for (size_t i = 0; i < count; i++) {
+					auto& node = ossia::net::create_node(root, "/rnbo/inst/0/params/p" + std::to_string(i));
+					auto& entry = mTable.add(i);
+					entry.param = node.create_parameter(ossia::val_type::FLOAT);
+					entry.normparam = node.create_child("normalized")->create_parameter(ossia::val_type::FLOAT);
+					entry.param->add_callback([this, i](const ossia::value& v) { onValue(i, v); });
+					entry.normparam->add_callback([this, i](const ossia::value& v) { onNormalized(i, v); });
+				}
+			}
+
+			uint64_t suppressed() const { return mSuppressed.load(); }
+		private:
+			void onValue(size_t index, const ossia::value& val) {
+				auto entry = mTable.find(index);
+				if (entry == nullptr) {
+					return;
+				}
+				float f = 0.0f;
+				switch (val.get_type()) {
+					case ossia::val_type::FLOAT:
+						f = val.get<float>();
+						break;
+					case ossia::val_type::INT:
+						f = static_cast<float>(val.get<int>());
+						break;
+					default:
+						return;
+				}
+				if (auto guard = typename Table::Guard(*entry, mSuppressed)) {
+					f = std::clamp(f, 0.0f, range);
+					mValues[index] = f;
+					auto norm = f / range;
+					Table::track(*entry, norm);
+					entry->normparam->push_value(norm);
+				}
+			}
+
+			void onNormalized(size_t index, const ossia::value& val) {
+				auto entry = mTable.find(index);
+				if (entry == nullptr || val.get_type() != ossia::val_type::FLOAT) {
+					return;
+				}
+				if (auto guard = typename Table::Guard(*entry, mSuppressed)) {
+					auto norm = std::clamp(val.get<float>(), 0.0f, 1.0f);
+					mValues[index] = norm * range;
+					Table::track(*entry, norm);
+					entry->param->push_value(norm * range);
+				}
+			}
+
+			Table mTable;
+			std::vector<float> mValues; //stands in for RNBO's parameter values
+			std::atomic<uint64_t> mSuppressed = 0;
+	};
+
+	template <typename Table>
+	void run(const std::string& name, size_t count, size_t messages) {
+		ossia::net::generic_device device(std::make_unique<ossia::net::multiplex_protocol>(), "rnbo-bench");
+		auto& root = device.get_root_node();
+		Params<Table> params(root, count);
+		OSCRouteCache cache(root, 4096);
+
+		//alternate between the value and normalized addresses of every parameter
+		std::vector<std::string> addrs;
+		for (size_t i = 0; i < count; i++) {
+			const std::string base = "/rnbo/inst/0/params/p" + std::to_string(i);
+			addrs.push_back(base);
+			addrs.push_back(base + "/normalized");
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		for (size_t m = 0; m < messages; m++) {
+			const auto& resolved = cache.resolve(addrs[m % addrs.size()]);
+			boost::container::small_vector<ossia::net::parameter_base *, 4> targets(resolved.begin(), resolved.end());
+			const float v = static_cast<float>(m % 101) / 100.0f;
+			for (auto param: targets) {
+				param->push_value(v);
+			}
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << std::left << std::setw(8) << name
+			<< std::right << std::setw(10) << count
+			<< std::setw(12) << std::fixed << std::setprecision(2) << seconds * 1e3
+			<< std::setw(14) << std::setprecision(0) << static_cast<double>(messages) / seconds
+			<< std::setw(12) << std::setprecision(1) << seconds * 1e9 / static_cast<double>(messages)
+			<< std::setw(14) << params.suppressed()
+			<< std::endl;
+	}
+}
+
+int main(int argc, char * argv[]) {
+	size_t messages = 1000000;
+	size_t count = 2000;
+	if (argc > 1) {
+		messages = std::strtoul(argv[1], nullptr, 10);
+	}
+	if (argc > 2) {
+		count = std::max<size_t>(1, std::strtoul(argv[2], nullptr, 10));
+	}
+
+	std::cout << messages << " messages over " << count << " params" << std::endl;
+	std::cout << std::left << std::setw(8) << "table"
+		<< std::right << std::setw(10) << "params"
+		<< std::setw(12) << "ms"
+		<< std::setw(14) << "msgs/s"
+		<< std::setw(12) << "ns/msg"
+		<< std::setw(14) << "suppressed"
+		<< std::endl;
+
+	run<MapTable>("map", count, messages);
+	run<DenseTable>("dense", count, messages);
+	return 0;
+}
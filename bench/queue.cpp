@@ -0,0 +1,137 @@
+//producer contention benchmark for common/Queue.h
+//usage: rnbo-bench-queue [items per producer]
+//
+//each run starts P producers pushing command sized strings into one queue drained by a single consumer
+//blocked in popTimeout, like the controller and instance queues, and reports the time for the whole run
+//the mutex queue that Queue.h replaced is run the same way for comparison
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include "Queue.h"
+
+namespace {
+	const size_t capacity = 1024;
+	const std::vector<unsigned int> producer_counts = { 1, 2, 4, 8 };
+
+	//the queue as it was before it became lock free, kept here as the baseline
+	template <typename T>
+	class MutexQueue {
+		public:
+			bool push(T item) {
+				std::lock_guard<std::mutex> guard(mMutex);
+				mQueue.push(item);
+				mCondition.notify_one();
+				return true;
+			}
+
+			template <typename Rep, typename Period>
+			boost::optional<T> popTimeout(std::chrono::duration<Rep, Period> timeout) {
+				std::unique_lock<std::mutex> guard(mMutex);
+				if (mQueue.empty())
+					mCondition.wait_for(guard, timeout);
+				if (mQueue.empty())
+					return boost::none;
+				T item = mQueue.front();
+				mQueue.pop();
+				return boost::make_optional(item);
+			}
+		private:
+			std::queue<T> mQueue;
+			std::mutex mMutex;
+			std::condition_variable mCondition;
+	};
+
+	struct Result {
+		double seconds = 0.0;
+		size_t retries = 0; //pushes that found the queue full and tried again
+	};
+
+	template <typename Q>
+	Result run(Q& queue, unsigned int producers, size_t items) {
+		const std::string payload = R"({"method":"instance_load","id":"0","params":{"index":0}})";
+		const size_t total = items * producers;
+		std::vector<size_t> retries(producers, 0);
+
+		auto start = std::chrono::steady_clock::now();
+		std::thread consumer([&queue, total] {
+			size_t popped = 0;
+			while (popped < total) {
+				if (queue.popTimeout(std::chrono::milliseconds(10))) {
+					popped++;
+				}
+			}
+		});
+
+		std::vector<std::thread> threads;
+		for (unsigned int p = 0; p < producers; p++) {
+			threads.emplace_back([&queue, &payload, &retries, p, items] {
+				for (size_t i = 0; i < items; i++) {
+					while (!queue.push(payload)) {
+						retries[p]++;
+						std::this_thread::yield();
+					}
+				}
+			});
+		}
+		for (auto& t: threads) {
+			t.join();
+		}
+		consumer.join();
+
+		Result result;
+		result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		for (auto r: retries) {
+			result.retries += r;
+		}
+		return result;
+	}
+
+	void report(const std::string& name, unsigned int producers, size_t items, const Result& result) {
+		const double total = static_cast<double>(items * producers);
+		std::cout << std::left << std::setw(8) << name
+			<< std::right << std::setw(10) << producers
+			<< std::setw(14) << std::fixed << std::setprecision(1) << (result.seconds * 1e9 / total)
+			<< std::setw(14) << std::setprecision(2) << (total / result.seconds / 1e6)
+			<< std::setw(12) << result.retries
+			<< std::endl;
+	}
+}
+
+int main(int argc, char * argv[]) {
+	size_t items = 200000;
+	if (argc > 1) {
+		items = std::strtoul(argv[1], nullptr, 10);
+	}
+
+	std::cout << "capacity " << capacity << ", " << items << " items per producer, "
+		<< std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+	std::cout << std::left << std::setw(8) << "queue"
+		<< std::right << std::setw(10) << "producers"
+		<< std::setw(14) << "ns/item"
+		<< std::setw(14) << "Mitems/s"
+		<< std::setw(12) << "full"
+		<< std::endl;
+
+	for (auto producers: producer_counts) {
+		{
+			MutexQueue<std::string> queue;
+			report("mutex", producers, items, run(queue, producers, items));
+		}
+		{
+			Queue<std::string> queue(capacity);
+			report("Queue", producers, items, run(queue, producers, items));
+		}
+	}
+	return 0;
+}
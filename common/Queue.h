@@ -1,57 +1,215 @@
 #pragma once
 
-#include <mutex>
-#include <queue>
-#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <new>
 #include <chrono>
+#include <thread>
+#include <limits>
+#include <functional>
 #include <boost/optional.hpp>
 
-//a thread safe (not realtime safe) queue
+#ifdef __linux__
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+//a bounded, lock-free, multi producer queue (not realtime safe as consumers may block)
+//based on Dmitry Vyukov's bounded MPMC queue, so multiple consumers are also safe
+//items are moved in and out, pushing to a full queue drops the item and counts it as an overflow
+//there is no default size, size each queue for the most it has to hold between drains and check overflowed()
+//where it is drained
 template <typename T>
 class Queue {
 	public:
-		//push from any thread
-		void push(T item) {
-			std::lock_guard<std::mutex> guard(mMutex);
-			mQueue.push(item);
-			mCondition.notify_one();
+		//capacity is rounded up to a power of 2
+		explicit Queue(size_t capacity) {
+			size_t size = 2;
+			while (size < capacity) {
+				size <<= 1;
+			}
+			mMask = size - 1;
+			mCells.reset(new Cell[size]);
+			for (size_t i = 0; i < size; i++) {
+				mCells[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		~Queue() {
+			while (tryPop()) {
+			}
+		}
+
+		Queue(const Queue&) = delete;
+		Queue& operator=(const Queue&) = delete;
+
+		//push from any thread, returns false and drops the item if the queue is full
+		bool push(T item) {
+			Cell * cell = nullptr;
+			size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+			while (true) {
+				cell = &mCells[pos & mMask];
+				size_t seq = cell->sequence.load(std::memory_order_acquire);
+				intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+				if (diff == 0) {
+					if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						break;
+					}
+				} else if (diff < 0) {
+					mOverflow.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				} else {
+					pos = mEnqueuePos.load(std::memory_order_relaxed);
+				}
+			}
+
+			new (cell->storage) T(std::move(item));
+			cell->sequence.store(pos + 1, std::memory_order_release);
+
+			//only hit the kernel if someone is blocked waiting
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (mWaiters.load(std::memory_order_relaxed) > 0) {
+				mSignal.fetch_add(1, std::memory_order_release);
+				wakeOne();
+			}
+
+			if (mOnPush) {
+				mOnPush();
+			}
+			return true;
+		}
+
+		//set a function to call after every push, for consumers that wait on something other than this queue
+		//set before any pushes happen
+		void onPush(std::function<void()> f) {
+			mOnPush = f;
 		}
 
 		//wait until there is data available.
 		T pop() {
-			std::unique_lock<std::mutex> guard(mMutex);
-			while (mQueue.empty()) {
-				mCondition.wait(guard);
+			while (true) {
+				if (auto item = popTimeout(std::chrono::seconds(1))) {
+					return std::move(item.get());
+				}
 			}
-			T item = mQueue.front();
-			mQueue.pop();
-			return item;
 		}
 
 		//wait for an amount of time
 		template <typename Rep, typename Period>
 		boost::optional<T> popTimeout(std::chrono::duration<Rep, Period> timeout) {
-			std::unique_lock<std::mutex> guard(mMutex);
-			if (mQueue.empty())
-				mCondition.wait_for(guard, timeout);
-			if (mQueue.empty())
-				return boost::none;
-			T item = mQueue.front();
-			mQueue.pop();
-			return boost::make_optional(item);
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
+			while (true) {
+				if (auto item = tryPop()) {
+					return item;
+				}
+
+				auto now = std::chrono::steady_clock::now();
+				if (now >= deadline) {
+					return boost::none;
+				}
+
+				//register as a waiter and check again so a push between the check and the wait isn't missed
+				uint32_t signal = mSignal.load(std::memory_order_acquire);
+				mWaiters.fetch_add(1, std::memory_order_seq_cst);
+				if (auto item = tryPop()) {
+					mWaiters.fetch_sub(1, std::memory_order_relaxed);
+					return item;
+				}
+				waitFor(signal, deadline - now);
+				mWaiters.fetch_sub(1, std::memory_order_relaxed);
+			}
 		}
 
 		//get data if it is available.
 		boost::optional<T> tryPop() {
-			std::lock_guard<std::mutex> guard(mMutex);
-			if (mQueue.empty())
-				return boost::none;
-			T item = mQueue.front();
-			mQueue.pop();
-			return boost::make_optional(item);
+			Cell * cell = nullptr;
+			size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+			while (true) {
+				cell = &mCells[pos & mMask];
+				size_t seq = cell->sequence.load(std::memory_order_acquire);
+				intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+				if (diff == 0) {
+					if (mDequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						break;
+					}
+				} else if (diff < 0) {
+					return boost::none;
+				} else {
+					pos = mDequeuePos.load(std::memory_order_relaxed);
+				}
+			}
+
+			T * ptr = std::launder(reinterpret_cast<T *>(cell->storage));
+			boost::optional<T> item(std::move(*ptr));
+			ptr->~T();
+			cell->sequence.store(pos + mMask + 1, std::memory_order_release);
+			return item;
+		}
+
+		//pop up to max items that are available, calling f with each, returns the number popped
+		template <typename F>
+		size_t popBatch(F f, size_t max = std::numeric_limits<size_t>::max()) {
+			size_t count = 0;
+			while (count < max) {
+				auto item = tryPop();
+				if (!item) {
+					break;
+				}
+				f(std::move(item.get()));
+				count++;
+			}
+			return count;
+		}
+
+		size_t capacity() const {
+			return mMask + 1;
+		}
+
+		//the number of items dropped because the queue was full, since the last call
+		size_t overflowed() {
+			return mOverflow.exchange(0, std::memory_order_relaxed);
 		}
+
 	private:
-		std::queue<T> mQueue;
-		std::mutex mMutex;
-		std::condition_variable mCondition;
+		struct Cell {
+			std::atomic<size_t> sequence;
+			alignas(T) unsigned char storage[sizeof(T)];
+		};
+
+		void wakeOne() {
+#ifdef __linux__
+			syscall(SYS_futex, reinterpret_cast<uint32_t *>(&mSignal), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#endif
+		}
+
+		template <typename Duration>
+		void waitFor(uint32_t signal, Duration timeout) {
+#ifdef __linux__
+			auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count();
+			struct timespec ts;
+			ts.tv_sec = static_cast<time_t>(ns / 1000000000);
+			ts.tv_nsec = static_cast<long>(ns % 1000000000);
+			//returns immediately if mSignal has changed since we read it
+			syscall(SYS_futex, reinterpret_cast<uint32_t *>(&mSignal), FUTEX_WAIT_PRIVATE, signal, &ts, nullptr, 0);
+#else
+			(void)signal;
+			std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(timeout, std::chrono::milliseconds(1)));
+#endif
+		}
+
+		static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32 bit int");
+
+		std::unique_ptr<Cell[]> mCells;
+		size_t mMask = 0;
+
+		alignas(64) std::atomic<size_t> mEnqueuePos = 0;
+		alignas(64) std::atomic<size_t> mDequeuePos = 0;
+		alignas(64) std::atomic<uint32_t> mSignal = 0;
+		std::atomic<uint32_t> mWaiters = 0;
+		std::atomic<size_t> mOverflow = 0;
+
+		std::function<void()> mOnPush;
 };
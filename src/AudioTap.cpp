@@ -0,0 +1,60 @@
+#include "AudioTap.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+using namespace audiotap;
+
+namespace {
+	size_t align_up(size_t v, size_t a) {
+		return (v + a - 1) / a * a;
+	}
+}
+
+AudioTap::AudioTap(const std::string& shmPrefix, std::vector<size_t> channels, size_t frames, double sampleRate) : mChannels(channels) {
+	mFrames = 2;
+	while (mFrames < frames) {
+		mFrames <<= 1;
+	}
+
+	const size_t dataOffset = align_up(sizeof(Header), 64);
+	mRegion = std::make_unique<ShmRegion>(shmPrefix, dataOffset + mChannels.size() * mFrames * sizeof(float));
+
+	mHeader = new (mRegion->data()) Header();
+	mData = reinterpret_cast<float *>(mRegion->data() + dataOffset);
+
+	mHeader->version = version;
+	mHeader->format = static_cast<uint32_t>(Format::Float32Planar);
+	mHeader->channels = static_cast<uint32_t>(mChannels.size());
+	mHeader->frames = static_cast<uint32_t>(mFrames);
+	mHeader->dataOffset = static_cast<uint32_t>(dataOffset);
+	mHeader->sampleRate = sampleRate;
+	//written last so readers know the rest is valid
+	std::atomic_thread_fence(std::memory_order_release);
+	mHeader->magic = magic;
+}
+
+void AudioTap::write(float * const * outputs, size_t numOutputs, size_t nframes) {
+	//a period larger than the ring only keeps its tail
+	size_t skip = nframes > mFrames ? nframes - mFrames : 0;
+	size_t count = nframes - skip;
+	size_t start = static_cast<size_t>((mWritten + skip) & (mFrames - 1));
+	size_t first = std::min(count, mFrames - start);
+
+	for (size_t c = 0; c < mChannels.size(); c++) {
+		float * ring = mData + c * mFrames;
+		auto index = mChannels[c];
+		if (index < numOutputs && outputs[index] != nullptr) {
+			const float * src = outputs[index] + skip;
+			std::memcpy(ring + start, src, first * sizeof(float));
+			std::memcpy(ring, src + first, (count - first) * sizeof(float));
+		} else {
+			std::memset(ring + start, 0, first * sizeof(float));
+			std::memset(ring, 0, (count - first) * sizeof(float));
+		}
+	}
+
+	mWritten += nframes;
+	mHeader->framesWritten.store(mWritten, std::memory_order_release);
+}
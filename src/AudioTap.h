@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ShmRegion.h"
+
+//layout of a shared memory audio tap, for visualizers and analysis on the same machine
+//
+//the region starts with a Header, followed by one ring of frames samples per channel at dataOffset,
+//channel c starts at dataOffset + c * frames * sizeof(float), all offsets are in bytes from the start of the region
+//
+//the audio thread copies each period into the rings and then stores framesWritten with release semantics
+//readers never block the writer, so check framesWritten after copying: data older than framesWritten - frames
+//may have been overwritten while it was being read
+namespace audiotap {
+	const uint32_t magic = 0x524e4254; //"RNBT"
+	const uint32_t version = 1;
+
+	enum class Format : uint32_t {
+		Float32Planar = 0
+	};
+
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t format;
+		uint32_t channels;
+		uint32_t frames; //ring size per channel, a power of 2
+		uint32_t dataOffset;
+		double sampleRate;
+
+		//total frames written since the tap was created
+		alignas(64) std::atomic<uint64_t> framesWritten;
+	};
+
+	static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared atomics must not need locks");
+}
+
+//copies selected output channels of an instance into a shared memory ring
+class AudioTap {
+	public:
+		//channels are indices into the outputs given to write, the region is named after shmPrefix, see ShmRegion
+		//throws if the region cannot be created
+		AudioTap(const std::string& shmPrefix, std::vector<size_t> channels, size_t frames, double sampleRate);
+
+		AudioTap(const AudioTap&) = delete;
+		AudioTap& operator=(const AudioTap&) = delete;
+
+		const std::string& name() const { return mRegion->name(); }
+		const std::vector<size_t>& channels() const { return mChannels; }
+		size_t frames() const { return mFrames; }
+
+		//called from the audio thread, wait free, channels beyond numOutputs are written as silence
+		void write(float * const * outputs, size_t numOutputs, size_t nframes);
+	private:
+		std::vector<size_t> mChannels;
+		size_t mFrames = 0;
+		std::unique_ptr<ShmRegion> mRegion;
+		audiotap::Header * mHeader = nullptr;
+		float * mData = nullptr;
+		//only accessed in the audio thread
+		uint64_t mWritten = 0;
+};
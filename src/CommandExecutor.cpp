@@ -0,0 +1,124 @@
+#include "CommandExecutor.h"
+
+#include <iostream>
+
+namespace {
+	thread_local bool tOnWorker = false;
+
+	bool conflicts(const std::string& a, const std::string& b) {
+		if (a.empty() || b.empty()) {
+			return true;
+		}
+		const auto& shorter = a.size() <= b.size() ? a : b;
+		const auto& longer = a.size() <= b.size() ? b : a;
+		return longer.compare(0, shorter.size(), shorter) == 0 && (longer.size() == shorter.size() || longer[shorter.size()] == '/');
+	}
+
+	bool conflicts(const std::vector<std::string>& keys, const std::vector<const std::vector<std::string> *>& blockers) {
+		for (auto b: blockers) {
+			for (const auto& bk: *b) {
+				for (const auto& k: keys) {
+					if (conflicts(k, bk)) {
+						return true;
+					}
+				}
+			}
+		}
+		return false;
+	}
+}
+
+CommandExecutor::CommandExecutor(unsigned int workers, std::function<void()> completed) : mCompleted(completed) {
+	for (unsigned int i = 0; i < workers; i++) {
+		mThreads.emplace_back(&CommandExecutor::work, this);
+	}
+}
+
+CommandExecutor::~CommandExecutor() {
+	{
+		std::lock_guard<std::mutex> guard(mMutex);
+		mQuit = true;
+	}
+	mCondition.notify_all();
+	for (auto& t: mThreads) {
+		t.join();
+	}
+}
+
+bool CommandExecutor::onWorker() {
+	return tOnWorker;
+}
+
+void CommandExecutor::submit(std::vector<std::string> keys, Thread thread, std::function<void()> job) {
+	{
+		std::lock_guard<std::mutex> guard(mMutex);
+		mPending.push_back({std::move(keys), thread, std::move(job)});
+	}
+	if (thread == Thread::Worker) {
+		mCondition.notify_one();
+	}
+}
+
+bool CommandExecutor::runController() {
+	std::unique_lock<std::mutex> lock(mMutex);
+	for (auto it = next(true); it != mPending.end(); it = next(true)) {
+		run(lock, it);
+	}
+	for (const auto& j: mPending) {
+		if (j.thread == Thread::Controller || mThreads.empty()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+std::list<CommandExecutor::Job>::iterator CommandExecutor::next(bool controller) {
+	//a job waits for running jobs and for earlier pending ones that it conflicts with
+	std::vector<const std::vector<std::string> *> blockers;
+	blockers.reserve(mRunning.size() + mPending.size());
+	for (const auto& j: mRunning) {
+		blockers.push_back(&j.keys);
+	}
+	for (auto it = mPending.begin(); it != mPending.end(); it++) {
+		const bool ours = controller ? (it->thread == Thread::Controller || mThreads.empty()) : it->thread == Thread::Worker;
+		if (ours && !conflicts(it->keys, blockers)) {
+			return it;
+		}
+		blockers.push_back(&it->keys);
+	}
+	return mPending.end();
+}
+
+void CommandExecutor::run(std::unique_lock<std::mutex>& lock, std::list<Job>::iterator it) {
+	mRunning.splice(mRunning.end(), mPending, it);
+	lock.unlock();
+	try {
+		it->func();
+	} catch (const std::exception& e) {
+		std::cerr << "exception in command executor " << e.what() << std::endl;
+	} catch (...) {
+		std::cerr << "unknown exception in command executor" << std::endl;
+	}
+	lock.lock();
+	mRunning.erase(it);
+	//whatever was waiting on this might be ready now
+	mCondition.notify_all();
+}
+
+void CommandExecutor::work() {
+	tOnWorker = true;
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (!mQuit) {
+		auto it = next(false);
+		if (it == mPending.end()) {
+			mCondition.wait(lock);
+			continue;
+		}
+		run(lock, it);
+		if (mCompleted) {
+			lock.unlock();
+			mCompleted();
+			lock.lock();
+		}
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//runs commands on a pool of worker threads, or in the controller thread, while keeping commands that
+//touch the same resource in the order they were submitted
+//
+//keys name resources with '/' separated paths, "instance/2", "file/datafile/a.wav", "db/sets"
+//a key conflicts with itself and with anything below it, so "instance" is ordered against every "instance/N"
+//the empty key conflicts with everything
+class CommandExecutor {
+	public:
+		enum class Thread {
+			Worker,
+			Controller //only run by runController
+		};
+
+		//0 workers runs everything in runController
+		//completed is called, from a worker, after a job finishes so the controller can look for newly ready jobs
+		CommandExecutor(unsigned int workers, std::function<void()> completed);
+		~CommandExecutor();
+
+		void submit(std::vector<std::string> keys, Thread thread, std::function<void()> job);
+
+		//run the controller thread jobs that are ready, returns true if there are any still waiting on others
+		bool runController();
+
+		//is the calling thread one of the executor's workers
+		static bool onWorker();
+	private:
+		struct Job {
+			std::vector<std::string> keys;
+			Thread thread;
+			std::function<void()> func;
+		};
+
+		//call with mMutex held, returns mPending.end() if nothing is ready
+		std::list<Job>::iterator next(bool controller);
+		//call with lock held, it is released while the job runs
+		void run(std::unique_lock<std::mutex>& lock, std::list<Job>::iterator it);
+		void work();
+
+		std::vector<std::thread> mThreads;
+		std::function<void()> mCompleted;
+
+		std::mutex mMutex;
+		std::condition_variable mCondition;
+		std::list<Job> mPending; //in submission order
+		std::list<Job> mRunning;
+		bool mQuit = false;
+};
@@ -78,6 +78,8 @@ namespace {
 		{config::key::InstanceAudioFadeOut, 20.0},
 		{config::key::InstancePortToOSC, true},
 		{config::key::ControlAutoConnectMIDI, true},
+		{config::key::ListenerBundleMTU, 1400},
+		{config::key::ListenerFlushInterval, 0},
 
 		{config::key::SetPresetDefaultPatcherNamed, false},
 
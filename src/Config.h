@@ -46,6 +46,19 @@ namespace config {
 		const static std::string SetPresetMIDIProgramChangeChannel = "set_preset_midi_program_change_channel"; //string, "omni" for omni 1..16 for specific, "none" or null for none
 		const static std::string UUIDPath = "uuid_path"; //path where we store the unique identifier for the runner
 
+		const static std::string ListenerBundleMTU = "listener_bundle_mtu"; //int, max size in bytes of the OSC bundles sent to listeners
+		const static std::string ListenerFlushInterval = "listener_flush_interval_ms"; //int, how often values are flushed to OSC listeners, 0 flushes every main loop iteration
+
+		const static std::string OSCTimedPort = "osc_timed_port"; //int, UDP port for OSC whose bundle timetags schedule parameter and inport events, 0 disables
+		const static std::string InstanceMeters = "instance_meters"; //bool, compute peak and RMS meters for instance audio i/o, published at /rnbo/inst/N/jack/meters
+		const static std::string InstanceMeterWindow = "instance_meter_window_ms"; //int, how many milliseconds of audio each meter value covers
+		const static std::string InstanceShmControl = "instance_shm_control"; //bool, give each instance a shared memory region for local control and parameter read back, see ShmControl.h
+		const static std::string NamespaceHTTPPort = "namespace_http_port"; //int, TCP port that serves cached OSCQuery namespace JSON with ETag and gzip support, 0 disables
+		const static std::string OSCIngestPort = "osc_ingest_port"; //int, UDP port for high rate numeric OSC to instance parameters and inports that bypasses the tree, 0 disables
+
+		const static std::string InstanceEventWorkers = "instance_event_workers"; //int, threads used to process instance events in parallel, 0 picks based on the hardware, 1 processes them in the main thread
+		const static std::string CommandWorkers = "command_workers"; //int, threads that run file, package and database commands alongside the main loop, 0 runs every command in the main thread
+
 		const static std::string SetPresetDefaultPatcherNamed = "set_preset_default_patcher_named"; //by default, when adding an instance to a set, make it so set presets for that instance save the latest preset, associated with that instance
 	}
 
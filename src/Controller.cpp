@@ -16,6 +16,17 @@
 #include "JackAudio.h"
 #include "Util.h"
 #include "PatcherFactory.h"
+#include "ParamBatch.h"
+#include "EventDispatcher.h"
+#include "DeferredPushProtocol.h"
+#include "CommandExecutor.h"
+#include "Reactor.h"
+#include "OSCBundleProtocol.h"
+#include "OSCTimedReceiver.h"
+#include "OSCIngest.h"
+#include "NamespaceServer.h"
+#include "QuietTreeChanges.h"
+#include "Listing.h"
 #include "RNBO_Version.h"
 #include "RNBO_LoggerImpl.h"
 
@@ -23,18 +34,19 @@
 #include <boost/process/child.hpp>
 
 #include <boost/uuid/detail/md5.hpp>
+#include <boost/container/small_vector.hpp>
 #include <boost/algorithm/hex.hpp>
 
 #include <ossia/context.hpp>
 #include <ossia/detail/config.hpp>
 
 #include <ossia/protocols/oscquery/oscquery_server_asio.hpp>
-#include <ossia/protocols/osc/osc_factory.hpp>
 
 #include <ossia/network/context.hpp>
 #include <ossia/network/local/local.hpp>
 #include <ossia/network/base/parameter_data.hpp>
 #include <ossia/network/generic/generic_device.hpp>
+#include <ossia/network/generic/generic_node.hpp>
 #include <ossia/network/generic/generic_parameter.hpp>
 
 #include <sys/types.h>
@@ -64,6 +76,16 @@ namespace {
 	static const std::chrono::milliseconds save_debounce_timeout(500);
 
 	static const std::chrono::milliseconds process_poll_period(10);
+	//how often per listener stats are published
+	static const std::chrono::seconds listeners_stats_period(1);
+	//how soon to retry a flush for listeners that are over their budget
+	static const std::chrono::milliseconds listeners_budget_retry(10);
+	//bound the resolved route cache as addresses come from the network
+	static const size_t osc_route_cache_max = 4096;
+	//longest we'll sleep with nothing to do, some polling (jack stats, cards) isn't tracked as a timer
+	static const std::chrono::milliseconds idle_wait_max(100);
+	//keep ticking at process_poll_period for this long after activity to service short debounces
+	static const std::chrono::milliseconds busy_linger(250);
 
 	static const std::chrono::milliseconds datafile_debounce_timeout(50);
 
@@ -75,6 +97,13 @@ namespace {
 	static const std::string UNTITLED_SET_NAME = "(untitled)";
 	static const std::string LAST_SET_NAME = "RNBO_LAST_SET"; //XXX NO LONGER USED
 
+	//pushing an unchanged value still goes out to every listening client
+	void push_if_changed(ossia::net::parameter_base * p, const ossia::value& v) {
+		if (p->value() != v) {
+			p->push_value(v);
+		}
+	}
+
 	ossia::net::node_base * find_or_create_child(ossia::net::node_base * parent, const std::string name) {
 			auto c = parent->find_child(name);
 			if (!c) {
@@ -162,6 +191,125 @@ namespace {
 
 	boost::optional<CompileInfo> compileProcess;
 
+	//while a batch runs one of its commands, the statuses that command reports are collected instead of pushed
+	struct BatchCapture;
+	thread_local BatchCapture * tBatchCapture = nullptr;
+
+	struct BatchCapture {
+		BatchCapture(const std::string& id, RNBO::Json& responses) : id(id), responses(responses) {
+			tBatchCapture = this;
+		}
+		~BatchCapture() {
+			tBatchCapture = nullptr;
+		}
+		BatchCapture(const BatchCapture&) = delete;
+		BatchCapture& operator=(const BatchCapture&) = delete;
+
+		const std::string& id;
+		RNBO::Json& responses;
+	};
+
+	//what a command touches, so it is ordered against commands that touch the same things,
+	//and whether it alters the instances, audio or other controller thread state and so must run there
+	struct CommandOrdering {
+		std::vector<std::string> keys;
+		CommandExecutor::Thread thread;
+	};
+
+	CommandOrdering command_ordering(const std::string& method, const RNBO::Json& params) {
+		using T = CommandExecutor::Thread;
+		if (method == "batch") {
+			//everything its commands touch, in the controller thread if any of them need it
+			CommandOrdering ordering = { {}, T::Worker };
+			if (params.is_object() && params.contains("commands") && params["commands"].is_array()) {
+				for (const auto& c: params["commands"]) {
+					if (!c.is_object() || !c.contains("method") || !c["method"].is_string()) {
+						continue;
+					}
+					auto o = command_ordering(c["method"].get<std::string>(), c.contains("params") ? c["params"] : RNBO::Json());
+					ordering.keys.insert(ordering.keys.end(), o.keys.begin(), o.keys.end());
+					if (o.thread == T::Controller) {
+						ordering.thread = T::Controller;
+					}
+				}
+				//a transaction holds the whole database, the controller thread takes the database while holding
+				//subtree locks that batched commands take after it, so it has to run there as well
+				//the main loop and instance callbacks are then never waiting on it, workers that use the database
+				//wait but only ever hold it for a single call themselves, see DB::Batch
+				if (params.contains("transaction") && params["transaction"].is_boolean() && params["transaction"].get<bool>()) {
+					ordering.keys.push_back("db");
+					ordering.thread = T::Controller;
+				}
+			}
+			return ordering;
+		}
+
+		auto param = [&params](const char * key) -> std::string {
+			return params.is_object() && params.contains(key) && params[key].is_string() ? params[key].get<std::string>() : std::string();
+		};
+		auto index = [&params](const char * key) -> boost::optional<int> {
+			if (params.is_object() && params.contains(key) && params[key].is_number_integer()) {
+				return params[key].get<int>();
+			}
+			return boost::none;
+		};
+
+		if (method.starts_with("file_")) {
+			std::string filetype = param("filetype");
+			std::string filename = param("filename");
+			if (method == "file_write_extended" && !base64_decode_inplace(filename)) {
+				filename.clear();
+			}
+			//writes to the same file stay in order, everything else can go in parallel
+			std::vector<std::string> keys = { filename.size() && filetype.size() ? "file/" + filetype + "/" + filename : "file" };
+			if (filetype == "set") {
+				keys.push_back("db/sets");
+			} else if (filetype == "presets") {
+				keys.push_back("db/patchers");
+			}
+			return { keys, T::Worker };
+		}
+		//workers leave changes to the ossia tree, and their status pushes, to the controller thread, see onController
+		if (method == "patcherstore" || method == "patcher_destroy") {
+			return { { "db/patchers", "file" }, T::Worker };
+		}
+		if (method == "patcher_rename") {
+			return { { "db/patchers" }, T::Controller };
+		}
+		if (method == "db_backup") {
+			return { { "db" }, T::Worker };
+		}
+		if (method == "package_create" || method == "package_install") {
+			return { { "db", "file" }, T::Worker };
+		}
+		//these read the current set from the tree and edit the views under it as they go
+		if (method.starts_with("instance_set_view_")) {
+			return { { "db/sets" }, T::Controller };
+		}
+		if (method == "instance_load" || method == "instance_unload") {
+			auto i = index("index");
+			//loads read the patcher a patcherstore might still be writing
+			return { { i && i.get() >= 0 ? "instance/" + std::to_string(i.get()) : "instance", "db/sets", "db/patchers" }, T::Controller };
+		}
+		if (method.starts_with("instance_set_")) {
+			return { { "instance", "db/sets", "db/patchers" }, T::Controller };
+		}
+		if (method == "compile" || method == "compile_cancel") {
+			return { { "compile", "instance", "file" }, T::Controller };
+		}
+		if (method == "activate_audio" || method == "restart_audio") {
+			return { { "audio", "instance" }, T::Controller };
+		}
+		if (method.starts_with("listener_")) {
+			return { { "listeners" }, T::Controller };
+		}
+		if (method == "install" || method == "use_rnbo_library") {
+			return { { "update" }, T::Controller };
+		}
+		//db_restore and anything unknown waits for everything
+		return { { "" }, T::Controller };
+	}
+
 	fs::path packagedir(std::string rnboVersion) {
 		return config::get<fs::path>(config::key::PackageDir).get() / sanitizeName(rnboVersion);
 	}
@@ -645,8 +793,12 @@ Controller::Controller(std::string server_name) {
 	mOssiaContext = ossia::net::create_network_context();
 	auto serv_proto = new ossia::oscquery_asio::oscquery_server_protocol(mOssiaContext, 1234, 5678);
 
-	mServer = std::unique_ptr<ossia::net::generic_device>(new ossia::net::generic_device(std::unique_ptr<ossia::net::protocol_base>(mProtocol), server_name));
+	//instance event workers capture their pushes, the controller thread publishes them through the multiplex
+	auto deferred_proto = new DeferredPushProtocol(std::unique_ptr<ossia::net::protocol_base>(mProtocol));
+
+	mServer = std::unique_ptr<ossia::net::generic_device>(new ossia::net::generic_device(std::unique_ptr<ossia::net::protocol_base>(deferred_proto), server_name));
 	mServer->set_echo(true);
+	mOSCRouteCache = std::make_unique<OSCRouteCache>(mServer->get_root_node(), osc_route_cache_max);
 
 	mProtocol->expose_to(std::unique_ptr<ossia::net::protocol_base>(serv_proto));
 
@@ -665,6 +817,13 @@ Controller::Controller(std::string server_name) {
 
 	mServer->on_unhandled_message.connect<&Controller::onUnhandledOSC>(this);
 
+	//invalidate resolved OSC routes whenever the tree changes
+	mServer->on_node_created.connect<&Controller::onTreeNodeChanged>(this);
+	mServer->on_node_removing.connect<&Controller::onTreeNodeChanged>(this);
+	mServer->on_node_renamed.connect<&Controller::onTreeNodeRenamed>(this);
+	mServer->on_parameter_created.connect<&Controller::onTreeParameterChanged>(this);
+	mServer->on_parameter_removing.connect<&Controller::onTreeParameterChanged>(this);
+
 	mSourceCache = config::get<fs::path>(config::key::SourceCacheDir).get();
 	mCompileCache = config::get<fs::path>(config::key::CompileCacheDir).get();
 
@@ -673,7 +832,58 @@ Controller::Controller(std::string server_name) {
 	if (configBuildExe && fs::exists(configBuildExe.get()))
 		build_program = configBuildExe.get().string();
 
-	mProcessNext = steady_clock::now();
+	mReactor = std::make_unique<Reactor>(mOssiaContext->context);
+	mCommandQueue.onPush(&Reactor::wake);
+	mOSCMappedUpdateQueue.onPush(&Reactor::wake);
+
+	//OSC that keeps its bundle timetags, so hosts can schedule events ahead of time
+	if (auto port = config::get<int>(config::key::OSCTimedPort); port && port.get() > 0) {
+		try {
+			mOSCTimedReceiver = std::make_unique<OSCTimedReceiver>(mOssiaContext->context, static_cast<uint16_t>(port.get()),
+				[this](const std::string& addr, const ossia::value& v, boost::optional<std::chrono::system_clock::time_point> when) {
+					if (when) {
+						Instance::ScheduledAt at(when.get());
+						dispatchOSC(addr, v);
+					} else {
+						dispatchOSC(addr, v);
+					}
+				});
+		} catch (const std::exception& e) {
+			std::cerr << "failed to open timed OSC port " << port.get() << ": " << e.what() << std::endl;
+		}
+	}
+
+	//OSC straight to instances, for sensors and other high rate sources
+	if (auto port = config::get<int>(config::key::OSCIngestPort); port && port.get() > 0) {
+		try {
+			mOSCIngest = std::make_unique<OSCIngest>(static_cast<uint16_t>(port.get()));
+		} catch (const std::exception& e) {
+			std::cerr << "failed to open OSC ingest port " << port.get() << ": " << e.what() << std::endl;
+		}
+	}
+
+	mListenerBundleMTU = static_cast<size_t>(std::max(0, config::get<int>(config::key::ListenerBundleMTU).value_or(1400)));
+	mListenerFlushInterval = std::chrono::milliseconds(std::max(0, config::get<int>(config::key::ListenerFlushInterval).value_or(0)));
+	mListenerFlushNext = steady_clock::now();
+	{
+		//a single output for all listeners so values are only encoded once
+		auto output = std::make_unique<OSCBundleProtocol>(mOssiaContext->context, mListenerBundleMTU);
+		mListenerOutput = output.get();
+		mProtocol->expose_to(std::move(output));
+	}
+
+	{
+		//serialized namespace replies, kept until something under them changes
+		auto cache = std::make_unique<NamespaceCache>(*mServer);
+		mNamespaceCache = cache.get();
+		mProtocol->expose_to(std::move(cache));
+	}
+
+	mEventDispatcher = std::make_unique<EventDispatcher>(static_cast<unsigned int>(std::max(0, config::get<int>(config::key::InstanceEventWorkers).value_or(0))));
+	mCommandExecutor = std::make_unique<CommandExecutor>(
+			static_cast<unsigned int>(std::max(0, config::get<int>(config::key::CommandWorkers).value_or(2))),
+			[] { Reactor::wake(); }
+	);
 
 	auto root = mServer->create_child("rnbo");
 
@@ -720,7 +930,7 @@ Controller::Controller(std::string server_name) {
 			auto n = rep->create_child("add");
 			auto p = n->create_parameter(ossia::val_type::STRING);
 			n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::SET);
-			n->set(ossia::net::description_attribute{}, "add OSC UDP listener: \"[ip:]port\"");
+			n->set(ossia::net::description_attribute{}, "add OSC UDP listener: \"[ip:]port\", a multicast group ip sends to all of its subscribers");
 
 			p->add_callback([this, cmdBuilder](const ossia::value& v) {
 				std::string addr;
@@ -735,7 +945,7 @@ Controller::Controller(std::string server_name) {
 				}
 				auto cmd = cmdBuilder("listener_add", addr);
 				if (cmd.size()) {
-					mCommandQueue.push(cmd);
+					queueCommand(cmd);
 				}
 			});
 		}
@@ -757,7 +967,7 @@ Controller::Controller(std::string server_name) {
 				}
 				auto cmd = cmdBuilder("listener_del", addr);
 				if (cmd.size()) {
-					mCommandQueue.push(cmd);
+					queueCommand(cmd);
 				}
 			});
 		}
@@ -768,9 +978,41 @@ Controller::Controller(std::string server_name) {
 			n->set(ossia::net::description_attribute{}, "clear all OSC UDP listeners");
 
 			p->add_callback([this, cmdBuilder](const ossia::value& v) {
-				mCommandQueue.push(cmdBuilder("listener_clear", "0:0"));
+				queueCommand(cmdBuilder("listener_clear", "0:0"));
+			});
+		}
+		{
+			auto n = rep->create_child("configure");
+			auto p = n->create_parameter(ossia::val_type::STRING);
+			n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::SET);
+			n->set(ossia::net::description_attribute{}, "add or reconfigure an OSC UDP listener: JSON object with ip, port and optional max_messages_per_second, max_bytes_per_second, max_queue, filters (address list), priorities (address -> high, normal or low) and multicast_ttl");
+
+			p->add_callback([this](const ossia::value& v) {
+				if (v.get_type() != ossia::val_type::STRING) {
+					return;
+				}
+				auto params = RNBO::Json::parse(v.get<std::string>(), nullptr, false);
+				if (!params.is_object() || !params.contains("port")) {
+					std::cerr << "invalid listener configuration " << v.get<std::string>() << std::endl;
+					return;
+				}
+				if (!params.contains("ip")) {
+					params["ip"] = "127.0.0.1";
+				}
+				RNBO::Json cmd = {
+					{"method", "listener_add"},
+					{"id", "internal"},
+					{"params", params}
+				};
+				queueCommand(cmd.dump());
 			});
 		}
+		{
+			auto n = rep->create_child("stats");
+			mListenersStatsParam = n->create_parameter(ossia::val_type::STRING);
+			n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+			n->set(ossia::net::description_attribute{}, "JSON object of ip:port -> sent, bytes, dropped and queued message counts");
+		}
 
 		restoreListeners();
 	}
@@ -936,7 +1178,7 @@ Controller::Controller(std::string server_name) {
 				if (v.get_type() == ossia::val_type::STRING) {
 					auto s = v.get<std::string>();
 					if (s.size() > 0) {
-						mCommandQueue.push(s);
+						queueCommand(s);
 						p->set_value_quiet(std::string());
 					}
 				}
@@ -977,7 +1219,7 @@ Controller::Controller(std::string server_name) {
 							}
 						}
 					};
-					mCommandQueue.push(cmd.dump());
+					queueCommand(cmd.dump());
 				}
 		});
 	}
@@ -997,7 +1239,7 @@ Controller::Controller(std::string server_name) {
 						}
 					}
 				};
-				mCommandQueue.push(cmd.dump());
+				queueCommand(cmd.dump());
 		});
 	}
 
@@ -1007,10 +1249,20 @@ Controller::Controller(std::string server_name) {
 	mSetsNode = root->create_child("sets");
 	mSetsNode->set(ossia::net::description_attribute{}, "graph set descriptions");
 
+	{
+		//incremental updates and paging for the children of patchers and sets, which can't hold them without clashing with names
+		auto listings = root->create_child("listings");
+		listings->set(ossia::net::description_attribute{}, "Versioned change deltas and paged access for large listings");
+		mPatcherListing = std::make_unique<Listing>(listings->create_child("patchers"), "patcher");
+		mSetListing = std::make_unique<Listing>(listings->create_child("sets"), "set");
+	}
+
 	updatePatchersInfo();
 
 	mInstancesNode = root->create_child("inst");
 	mInstancesNode->set(ossia::net::description_attribute{}, "code export instances");
+	//instances change independently, don't let one invalidate the cached namespace of the others
+	mNamespaceCache->split(mInstancesNode);
 	{
 		auto ctl = mInstancesNode->create_child("control");
 
@@ -1039,7 +1291,7 @@ Controller::Controller(std::string server_name) {
 				p->add_callback([this, cmdBuilder](const ossia::value& v) {
 						if (v.get_type() == ossia::val_type::INT) {
 							auto index = v.get<int>();
-							mCommandQueue.push(cmdBuilder("instance_unload", index));
+							queueCommand(cmdBuilder("instance_unload", index));
 						}
 				});
 
@@ -1063,7 +1315,7 @@ Controller::Controller(std::string server_name) {
 								instance_name = l[2].get<std::string>();
 							}
 
-							mCommandQueue.push(cmdBuilder("instance_load", index, name, instance_name));
+							queueCommand(cmdBuilder("instance_load", index, name, instance_name));
 
 						}
 					}
@@ -1072,6 +1324,34 @@ Controller::Controller(std::string server_name) {
 			}
 		}
 
+		{
+			auto n = ctl->create_child("params_set");
+			auto p = n->create_parameter(ossia::val_type::LIST);
+			n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::SET);
+			n->set(ossia::net::description_attribute{}, "Set many parameters across instances at once. args: instance index value [instance index value ...] or a blob of packed little endian [uint32 instance, uint32 index, float32 value] records");
+			p->add_callback([this](const ossia::value& v) {
+				std::vector<parambatch::InstanceEntry> entries;
+				if (!parambatch::decode(v, entries)) {
+					std::cerr << "malformed params_set value" << std::endl;
+					return;
+				}
+
+				//group by instance so each gets a single batch
+				std::unordered_map<unsigned int, std::vector<parambatch::Entry>> byInstance;
+				for (const auto& [instance, index, value]: entries) {
+					byInstance[instance].emplace_back(index, value);
+				}
+
+				for (auto& i: *instances()) {
+					auto inst = std::get<0>(i);
+					auto it = byInstance.find(inst->index());
+					if (it != byInstance.end()) {
+						inst->setParameterValues(it->second);
+					}
+				}
+			});
+		}
+
 		{
 			auto sets = ctl->create_child("sets");
 
@@ -1118,7 +1398,7 @@ Controller::Controller(std::string server_name) {
 								if (metav.get_type() == ossia::val_type::STRING) {
 									meta = metav.get<std::string>();
 								}
-								mCommandQueue.push(cmdBuilder("instance_set_save", name, meta));
+								queueCommand(cmdBuilder("instance_set_save", name, meta));
 							}
 						}
 				});
@@ -1134,7 +1414,7 @@ Controller::Controller(std::string server_name) {
 						if (v.get_type() == ossia::val_type::STRING) {
 							auto name = v.get<std::string>();
 							if (name.size()) {
-								mCommandQueue.push(cmdBuilder("instance_set_load", name));
+								queueCommand(cmdBuilder("instance_set_load", name));
 							}
 						}
 				});
@@ -1147,7 +1427,7 @@ Controller::Controller(std::string server_name) {
 				n->set(ossia::net::description_attribute{}, "Load the initial set indicated via runner config, useful for delayed start");
 
 				p->add_callback([this, cmdBuilder](const ossia::value& v) {
-						mCommandQueue.push(cmdBuilder("instance_set_load_initial", ""));
+						queueCommand(cmdBuilder("instance_set_load_initial", ""));
 				});
 			}
 
@@ -1161,7 +1441,7 @@ Controller::Controller(std::string server_name) {
 						if (v.get_type() == ossia::val_type::STRING) {
 							auto name = v.get<std::string>();
 							if (name.size()) {
-								mCommandQueue.push(cmdBuilder("instance_set_delete", name));
+								queueCommand(cmdBuilder("instance_set_delete", name));
 							}
 						}
 				});
@@ -1190,7 +1470,7 @@ Controller::Controller(std::string server_name) {
 										}
 									}
 								};
-								mCommandQueue.push(cmd.dump());
+								queueCommand(cmd.dump());
 							}
 						}
 					}
@@ -1222,7 +1502,7 @@ Controller::Controller(std::string server_name) {
 								}
 							}
 						};
-						mCommandQueue.push(cmd.dump());
+						queueCommand(cmd.dump());
 					}
 				});
 			}
@@ -1256,7 +1536,7 @@ Controller::Controller(std::string server_name) {
 				p->add_callback([this, cmdBuilder](const ossia::value& v) {
 						if (v.get_type() == ossia::val_type::STRING) {
 							auto name = v.get<std::string>();
-							mCommandQueue.push(cmdBuilder("instance_set_initial", name));
+							queueCommand(cmdBuilder("instance_set_initial", name));
 						}
 				});
 			}
@@ -1275,7 +1555,7 @@ Controller::Controller(std::string server_name) {
 							if (v.get_type() == ossia::val_type::STRING) {
 								auto name = v.get<std::string>();
 								if (name.size()) {
-									mCommandQueue.push(cmdBuilder("instance_set_preset_save", name));
+									queueCommand(cmdBuilder("instance_set_preset_save", name));
 								}
 							}
 					});
@@ -1288,7 +1568,7 @@ Controller::Controller(std::string server_name) {
 					n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::SET);
 
 					p->add_callback([this, cmdBuilder](const ossia::value& val) {
-						mCommandQueue.push(cmdBuilder("instance_set_preset_save", "_auto"));
+						queueCommand(cmdBuilder("instance_set_preset_save", "_auto"));
 					});
 				}
 
@@ -1300,7 +1580,7 @@ Controller::Controller(std::string server_name) {
 
 					p->add_callback([this, cmdBuilder](const ossia::value& v) {
 						if (v.get_type() == ossia::val_type::INT) {
-							mCommandQueue.push(cmdBuilder("instance_set_preset_save", "_auto", "", v.get<int>()));
+							queueCommand(cmdBuilder("instance_set_preset_save", "_auto", "", v.get<int>()));
 						}
 					});
 				}
@@ -1315,7 +1595,7 @@ Controller::Controller(std::string server_name) {
 							if (v.get_type() == ossia::val_type::STRING) {
 								auto name = v.get<std::string>();
 								if (name.size()) {
-									mCommandQueue.push(cmdBuilder("instance_set_preset_load", name));
+									queueCommand(cmdBuilder("instance_set_preset_load", name));
 								}
 							}
 					});
@@ -1332,7 +1612,7 @@ Controller::Controller(std::string server_name) {
 								auto index = std::max(0, v.get<int>());
 								auto name = mDB->setPresetNameByIndex(setname, index);
 								if (name) {
-									mCommandQueue.push(cmdBuilder("instance_set_preset_load", *name));
+									queueCommand(cmdBuilder("instance_set_preset_load", *name));
 								}
 							}
 					});
@@ -1385,7 +1665,7 @@ Controller::Controller(std::string server_name) {
 							if (v.get_type() == ossia::val_type::STRING) {
 								auto name = v.get<std::string>();
 								if (name.size()) {
-									mCommandQueue.push(cmdBuilder("instance_set_preset_delete", name));
+									queueCommand(cmdBuilder("instance_set_preset_delete", name));
 								}
 							}
 					});
@@ -1402,7 +1682,7 @@ Controller::Controller(std::string server_name) {
 						if (v.get_type() == ossia::val_type::INT && setname.size() > 0) {
 							auto name = mDB->setPresetNameByIndex(setname, std::max(0, v.get<int>()));
 							if (name) {
-								mCommandQueue.push(cmdBuilder("instance_set_preset_delete", name.get()));
+								queueCommand(cmdBuilder("instance_set_preset_delete", name.get()));
 							}
 						}
 					});
@@ -1431,7 +1711,7 @@ Controller::Controller(std::string server_name) {
 											}
 										}
 									};
-									mCommandQueue.push(cmd.dump());
+									queueCommand(cmd.dump());
 								}
 							}
 						}
@@ -1467,7 +1747,7 @@ Controller::Controller(std::string server_name) {
 											}
 										}
 									};
-									mCommandQueue.push(cmd.dump());
+									queueCommand(cmd.dump());
 								}
 							}
 						}
@@ -1508,7 +1788,7 @@ Controller::Controller(std::string server_name) {
 										}
 									}
 								};
-								mCommandQueue.push(cmd.dump());
+								queueCommand(cmd.dump());
 							}
 						}
 					});
@@ -1531,7 +1811,7 @@ Controller::Controller(std::string server_name) {
 									}
 								}
 							};
-							mCommandQueue.push(cmd.dump());
+							queueCommand(cmd.dump());
 						}
 					});
 				}
@@ -1563,7 +1843,7 @@ Controller::Controller(std::string server_name) {
 								}
 							}
 						};
-						mCommandQueue.push(cmd.dump());
+						queueCommand(cmd.dump());
 					});
 				}
 			}
@@ -1878,9 +2158,20 @@ Controller::Controller(std::string server_name) {
 	}
 
 	registerCommands();
+
+	if (auto port = config::get<int>(config::key::NamespaceHTTPPort); port && port.get() > 0) {
+		try {
+			mNamespaceServer = std::make_unique<NamespaceHTTPServer>(mOssiaContext->context, static_cast<uint16_t>(port.get()), *mNamespaceCache);
+		} catch (const std::exception& e) {
+			std::cerr << "failed to open namespace HTTP port " << port.get() << ": " << e.what() << std::endl;
+		}
+	}
 }
 
 Controller::~Controller() {
+	mNamespaceServer.reset();
+	//let running commands finish before tearing anything down
+	mCommandExecutor.reset();
 	{
 		std::lock_guard<std::mutex> guard(mBuildMutex);
 		clearInstances(guard, 0.0f);
@@ -1980,20 +2271,29 @@ std::shared_ptr<Instance> Controller::loadLibrary(const std::string& path, std::
 		{
 			std::lock_guard<std::mutex> guard(mBuildMutex);
 			unloadInstance(guard, instanceIndex);
-			instNode = mInstancesNode->create_child(instIndex);
 		}
-		auto builder = [instNode, this](std::function<void(ossia::net::node_base*)> f) {
-			std::lock_guard<std::mutex> guard(mBuildMutex);
+
+		//build the instance's subtree detached from the tree, nothing else can reach it so it needs no lock
+		//our own tree listeners ignore the build and see the single add_child once it is complete
+		//ossia's server is told about every node as it is created, its clients can't resolve them until then
+		auto detached = std::make_unique<ossia::net::generic_node>(instIndex, *mServer, *mInstancesNode);
+		instNode = detached.get();
+		auto builder = [instNode](std::function<void(ossia::net::node_base*)> f) {
 			f(instNode);
 		};
 
-		auto instance = std::make_shared<Instance>(
-			mDB, factory, name, builder, conf, mProcessAudio, instanceIndex,
-			std::bind(&Controller::dispatchOSC, this, std::placeholders::_1, std::placeholders::_2),
-			std::bind(&Controller::registerOSCMapping, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)
-		);
+		std::shared_ptr<Instance> instance;
+		{
+			QuietTreeChanges quiet;
+			instance = std::make_shared<Instance>(
+				mDB, factory, name, builder, conf, mProcessAudio, instanceIndex,
+				std::bind(&Controller::dispatchOSC, this, std::placeholders::_1, std::placeholders::_2),
+				std::bind(&Controller::registerOSCMapping, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)
+			);
+		}
 		{
 			std::lock_guard<std::mutex> guard(mBuildMutex);
+			mInstancesNode->add_child(std::move(detached));
 			instance->registerPresetLoadedCallback([this, instanceIndex](const std::string& presetName, const std::string& setPresetName) {
 					handleInstancePresetLoad(instanceIndex, setPresetName, presetName);
 			});
@@ -2010,7 +2310,9 @@ std::shared_ptr<Instance> Controller::loadLibrary(const std::string& path, std::
 					mSetDirtyParam->push_value(true);
 					queueSave();
 			});
-			mInstances.emplace_back(std::make_tuple(instance, path, config_path));
+			modifyInstances([&](InstanceList& list) {
+				list.emplace_back(std::make_tuple(instance, path, config_path));
+			});
 		}
 		if (cmdId.size()) {
 			reportCommandResult(cmdId, {
@@ -2121,7 +2423,7 @@ void Controller::doLoadSet(SetInfo& setInfo, boost::optional<PendingPresetMap>&
 		if (presets.size()) {
 			std::lock_guard<std::mutex> guard(mBuildMutex);
 			for (auto& preset: presets) {
-				for (auto i: mInstances) {
+				for (auto i: *instances()) {
 					auto inst = std::get<0>(i);
 					if (inst->index() == preset.first) {
 						inst->loadPreset(std::move(preset.second));
@@ -2137,10 +2439,9 @@ void Controller::doLoadSet(SetInfo& setInfo, boost::optional<PendingPresetMap>&
 
 		const bool loadInitial = setInfo.name.size() && setInfo.name != UNTITLED_SET_NAME;
 
-		//load presets and start instances
+		//load presets and start instances, they aren't in the process loop's way so no build lock
 		{
-			std::lock_guard<std::mutex> guard(mBuildMutex);
-			std::lock_guard<std::mutex> iguard(mInstanceMutex);
+			std::lock_guard<std::mutex> pguard(mSetPresetPendingMutex);
 
 			mPendingSetPresetName = "initial";
 			mInstancesPendingPresetLoad.clear();
@@ -2178,7 +2479,7 @@ void Controller::doLoadSet(SetInfo& setInfo, boost::optional<PendingPresetMap>&
 		cerr << "unknown exception trying to load last setup" << endl;
 	}
 	{
-		std::lock_guard<std::mutex> guard(mBuildMutex);
+		std::lock_guard<std::mutex> guard(mSetViewsMutex);
 		updateSetViews(setInfo.name);
 	}
 }
@@ -2206,7 +2507,7 @@ bool Controller::loadBuiltIn() {
 			{
 				std::lock_guard<std::mutex> guard(mBuildMutex);
 				clearInstances(guard, 0.0f);
-				instIndex = std::to_string(mInstances.size());
+				instIndex = std::to_string(instances()->size());
 				instNode = mInstancesNode->create_child(instIndex);
 			}
 			auto builder = [instNode, this](std::function<void(ossia::net::node_base *)> f) {
@@ -2220,7 +2521,9 @@ bool Controller::loadBuiltIn() {
 				std::lock_guard<std::mutex> guard(mBuildMutex);
 				instance->registerConfigChangeCallback([this] { queueSave(); });
 				instance->activate();
-				mInstances.emplace_back(std::make_tuple(instance, fs::path(), fs::path()));
+				modifyInstances([&](InstanceList& list) {
+					list.emplace_back(std::make_tuple(instance, fs::path(), fs::path()));
+				});
 			}
 
 			instance->connect();
@@ -2252,11 +2555,9 @@ SetInfo Controller::setInfo() {
 		}
 	}
 
-	std::lock_guard<std::mutex> iguard(mInstanceMutex);
-
 	info.connections = mProcessAudio->connections();
 
-	for (auto& i: mInstances) {
+	for (auto& i: *instances()) {
 		auto& inst = std::get<0>(i);
 
 		info.instances.push_back(SetInstanceInfo(inst->name(), inst->index(), inst->currentConfig().dump()));
@@ -2321,22 +2622,27 @@ void Controller::patcherStore(
 		}
 	}
 
-	{
-		std::lock_guard<std::mutex> guard(mBuildMutex);
+	onController([this, name]() {
+		std::lock_guard<std::mutex> guard(mPatchersNodeMutex);
 		updatePatchersInfo(name);
-	}
+	});
 }
 
 void Controller::queueSave() {
-	std::lock_guard<std::mutex> guard(mSaveMutex);
-	mSave = true;
+	{
+		std::lock_guard<std::mutex> guard(mSaveMutex);
+		mSave = true;
+	}
+	Reactor::wake();
 }
 
 void Controller::updatePatchersInfo(std::string addedOrUpdated) {
-	mDB->patchers([this, &addedOrUpdated](const std::string& name, int audio_inputs, int audio_outputs, int midi_inputs, int midi_outputs, const std::string& created_at, const std::string& uuid, const std::string& patcher_rnbo_version, const std::string& patcher_compat_version) {
+	std::vector<Listing::Entry> names;
+	mDB->patchers([this, &addedOrUpdated, &names](const std::string& name, int audio_inputs, int audio_outputs, int midi_inputs, int midi_outputs, const std::string& created_at, const std::string& uuid, const std::string& patcher_rnbo_version, const std::string& patcher_compat_version) {
 			if (addedOrUpdated.length() && name != addedOrUpdated) {
 				return;
 			}
+			names.emplace_back(name, -1);
 
 			auto r = find_or_create_child(mPatchersNode, name);
 
@@ -2355,7 +2661,7 @@ void Controller::updatePatchersInfo(std::string addedOrUpdated) {
 				l.push_back(midi_inputs);
 				l.push_back(midi_outputs);
 
-				p->push_value(l);
+				push_if_changed(p, l);
 			}
 
 			{
@@ -2365,7 +2671,7 @@ void Controller::updatePatchersInfo(std::string addedOrUpdated) {
 					p = n->create_parameter(ossia::val_type::STRING);
 					n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
 				}
-				p->push_value(created_at);
+				push_if_changed(p, created_at);
 			}
 
 			{
@@ -2375,7 +2681,7 @@ void Controller::updatePatchersInfo(std::string addedOrUpdated) {
 					p = n->create_parameter(ossia::val_type::STRING);
 					n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
 				}
-				p->push_value(uuid);
+				push_if_changed(p, uuid);
 			}
 
 			{
@@ -2386,7 +2692,7 @@ void Controller::updatePatchersInfo(std::string addedOrUpdated) {
 					n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
 					n->set(ossia::net::description_attribute{}, "which version of rnbo was used to build this patcher");
 				}
-				p->push_value(patcher_rnbo_version);
+				push_if_changed(p, patcher_rnbo_version);
 			}
 
 			{
@@ -2397,7 +2703,7 @@ void Controller::updatePatchersInfo(std::string addedOrUpdated) {
 					n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
 					n->set(ossia::net::description_attribute{}, "what is the compatibility version of this patcher");
 				}
-				p->push_value(patcher_compat_version);
+				push_if_changed(p, patcher_compat_version);
 			}
 
 			{
@@ -2417,7 +2723,7 @@ void Controller::updatePatchersInfo(std::string addedOrUpdated) {
 									}
 								}
 							};
-							mCommandQueue.push(cmd.dump());
+							queueCommand(cmd.dump());
 					});
 				}
 			}
@@ -2442,13 +2748,21 @@ void Controller::updatePatchersInfo(std::string addedOrUpdated) {
 										}
 									}
 								};
-								mCommandQueue.push(cmd.dump());
+								queueCommand(cmd.dump());
 							}
 
 					});
 				}
 			}
 	});
+
+	if (addedOrUpdated.length()) {
+		for (const auto& e: names) {
+			mPatcherListing->add(e.first);
+		}
+	} else {
+		mPatcherListing->update(names);
+	}
 }
 
 void Controller::destroyPatcher(const std::string& name) {
@@ -2457,21 +2771,27 @@ void Controller::destroyPatcher(const std::string& name) {
 			fs::remove(fs::absolute(mCompileCache / so_name), ec);
 			fs::remove(fs::absolute(mSourceCache / config_name), ec);
 	});
-	{
-		std::lock_guard<std::mutex> guard(mBuildMutex);
-		mPatchersNode->remove_child(name);
-	}
+	onController([this, name]() {
+		{
+			std::lock_guard<std::mutex> guard(mPatchersNodeMutex);
+			mPatchersNode->remove_child(name);
+		}
+		mPatcherListing->remove(name);
+	});
 }
 
 void Controller::updateSetNames() {
 	std::lock_guard<std::mutex> guard(mSetNamesMutex);
+	auto previousUUIDs = std::move(mSetUUIDs);
+	std::vector<Listing::Entry> entries;
 	mSetNames.clear();
 	mSetUUIDs.clear();
 	std::string initialName;
-	mDB->sets([this, &initialName](const std::string& name, const std::string& /*created*/, bool initial, const std::string& uuid) {
+	mDB->sets([this, &initialName, &entries](const std::string& name, const std::string& /*created*/, bool initial, const std::string& uuid) {
 			if (name != UNTITLED_SET_NAME) {
 				mSetNames.push_back(name);
 				mSetUUIDs.insert({name, uuid});
+				entries.emplace_back(name, -1);
 				if (initial) {
 					initialName = name;
 				}
@@ -2479,11 +2799,14 @@ void Controller::updateSetNames() {
 	});
 
 	updateSetInitialName(initialName);
-	mSetNamesUpdated = true;
+	//the domain and set nodes are only rebuilt, and sent to every client, if something changed
+	if (mSetListing->update(entries) || previousUUIDs != mSetUUIDs) {
+		mSetNamesUpdated = true;
+	}
 }
 
 void Controller::updateSetViews(const std::string& setname) {
-	//we have the build mutex
+	//we have the set views mutex
 	mSetViewsListNode->clear_children();
 	std::vector<ossia::value> order;
 
@@ -2624,8 +2947,7 @@ std::tuple<std::string, int> Controller::saveSetPreset(const std::string& setNam
 		mDB->setPresetDestroy(setName, presetName);
 	}
 	//save the new ones
-	std::lock_guard<std::mutex> iguard(mInstanceMutex);
-	for (auto& i: mInstances) {
+	for (auto& i: *instances()) {
 		auto inst = std::get<0>(i);
 		if (inst->inSetPreset()) {
 			inst->savePreset(presetName, setName, presetindex);
@@ -2636,10 +2958,10 @@ std::tuple<std::string, int> Controller::saveSetPreset(const std::string& setNam
 
 void Controller::loadSetPreset(const std::string& setName, std::string presetName) {
 	//load the preset and if it exists for an instance make note so we can watch callback and report once they're all loaded
-	std::lock_guard<std::mutex> iguard(mInstanceMutex);
+	std::lock_guard<std::mutex> pguard(mSetPresetPendingMutex);
 	mPendingSetPresetName = presetName;
 	mInstancesPendingPresetLoad.clear();
-	for (auto& i: mInstances) {
+	for (auto& i: *instances()) {
 		auto inst = std::get<0>(i);
 		if (inst->inSetPreset() && inst->loadPreset(presetName, setName)) {
 			mInstancesPendingPresetLoad.insert(inst->index());
@@ -2648,7 +2970,8 @@ void Controller::loadSetPreset(const std::string& setName, std::string presetNam
 }
 
 void Controller::handleInstancePresetLoad(unsigned int index, const std::string& setPresetName, const std::string& /*presetName*/) {
-	std::lock_guard<std::mutex> iguard(mInstanceMutex);
+	//called with the instance's tree locked, possibly from a dispatcher worker
+	std::lock_guard<std::mutex> pguard(mSetPresetPendingMutex);
 	if (setPresetName != mPendingSetPresetName || mInstancesPendingPresetLoad.count(index) == 0) {
 		return;
 	}
@@ -2672,8 +2995,7 @@ void Controller::handleInstancePresetSave(unsigned int index, const std::string&
 
 unsigned int Controller::nextInstanceIndex() {
 	unsigned int index = 0;
-	std::lock_guard<std::mutex> iguard(mInstanceMutex);
-	for (auto& i: mInstances) {
+	for (auto& i: *instances()) {
 		index = std::max(std::get<0>(i)->index() + 1, index);
 	}
 	return index;
@@ -2813,13 +3135,17 @@ std::string Controller::installPackage(const boost::filesystem::path& contentdir
 				storeSetContent(setData, mDB, name);
 			}
 		}
-		updateSetNames();
+		onController([this]() { updateSetNames(); });
 	}
 	return backupname;
 }
 
 bool Controller::processEvents() {
 	auto now = steady_clock::now();
+	bool housekeeping = now >= mProcessNext;
+	if (housekeeping) {
+		mProcessNext = now + process_poll_period;
+	}
 
 	try {
 		{
@@ -2829,25 +3155,19 @@ bool Controller::processEvents() {
 
 		//process any updates that have come from mapped OSC
 		{
-			auto& root = mServer->get_root_node();
 			std::lock_guard<std::recursive_mutex> guard(mOSCMapMutex);
+			if (auto dropped = mOSCMappedUpdateQueue.overflowed()) {
+				cerr << "mapped OSC update queue full, dropped " << dropped << " updates" << endl;
+			}
 			while (auto update = mOSCMappedUpdateQueue.tryPop()) {
-				auto node = ossia::net::find_node(root, update->first);
-				if (node != nullptr) {
-					auto param = node->get_parameter();
-					if (param) {
-						param->push_value(update->second);
-					}
+				const auto& resolved = mOSCRouteCache->resolve(update->first);
+				boost::container::small_vector<ossia::net::parameter_base *, 4> params(resolved.begin(), resolved.end());
+				for (auto param: params) {
+					param->push_value(update->second);
 				}
 			}
 		}
 
-		if (mProcessNext < now) {
-			mProcessNext = now + process_poll_period;
-		} else {
-			return true;
-		}
-
 		processCommands();
 
 		std::string loadedset = getCurrentSetName();
@@ -2861,17 +3181,52 @@ bool Controller::processEvents() {
 		};
 
 		bool stoppingInstances = false;
-		{
+		if (housekeeping) {
 			std::lock_guard<std::mutex> guard(mBuildMutex);
 			if (mProcessAudio)
 				mProcessAudio->processEvents(handleConnectionChange);
-			for (auto& i: mInstances) {
+		}
+
+		//instances lock their own subtrees, so they're processed from a snapshot without the build lock
+		//an instance removed in the mean time is detached and skips its tree work
+		{
+			auto snapshot = instances();
+
+			//instance events are independent of each other so process them in parallel
+			{
+				std::vector<std::pair<unsigned int, std::function<void()>>> jobs;
+				jobs.reserve(snapshot->size());
+				for (auto& i: *snapshot) {
+					auto inst = std::get<0>(i).get();
+					jobs.emplace_back(inst->index(), [inst] { inst->processDispatchEvents(); });
+				}
+				mEventDispatcher->run(jobs);
+			}
+
+			//OSC that the workers produced for nodes outside of their own instance
+			//the values they pushed into their own nodes are published by processControlEvents
+			if (auto dropped = mOSCDispatchQueue.overflowed()) {
+				cerr << "OSC dispatch queue full, dropped " << dropped << " messages" << endl;
+			}
+			while (auto item = mOSCDispatchQueue.tryPop()) {
+				dispatchOSC(item->first, item->second);
+			}
+
+			mBuildingNodes = false;
+			for (auto& i: *snapshot) {
 				auto& inst = std::get<0>(i);
-				inst->processEvents();
+				inst->processControlEvents();
+				mBuildingNodes = mBuildingNodes || inst->buildingNodes();
+				//informational nodes are built quietly, report them once they're all there
+				//they aren't OSC ingest targets so those routes are left alone
+				if (inst->takeNodesBuilt()) {
+					mOSCRouteCache->invalidate();
+					mNamespaceCache->structureChanged();
+				}
 
 				//manage broadcasting preset changes across instances
 				if (inst->presetsDirty()) {
-					for (auto& j: mInstances) {
+					for (auto& j: *snapshot) {
 						auto& jinst = std::get<0>(j);
 						if (jinst != inst && jinst->name() == inst->name()) {
 							jinst->presetsUpdateMarkClean();
@@ -2879,156 +3234,226 @@ bool Controller::processEvents() {
 					}
 				}
 			}
-			//manage stopping instances
-			for (auto it = mStoppingInstances.begin(); it != mStoppingInstances.end();) {
-				auto p = *it;
-				p->processEvents();
-				if (p->audioState() == AudioState::Stopped) {
-					//get final state to restore if it has been requested
-					std::lock_guard<std::mutex> pendingguard(mSetLoadPendingMutex);
-					if (mSetLoadPendingPreset) {
+		}
+
+		//everything below is polling and bookkeeping, run it at most once per process_poll_period
+		//no matter how often the audio thread or the network wakes us
+		if (housekeeping) {
+			std::vector<std::shared_ptr<Instance>> stopped;
+			{
+				std::lock_guard<std::mutex> guard(mBuildMutex);
+				//manage stopping instances
+				for (auto it = mStoppingInstances.begin(); it != mStoppingInstances.end();) {
+					auto p = *it;
+					p->processEvents();
+					if (p->audioState() == AudioState::Stopped) {
+						stopped.push_back(p);
+						it = mStoppingInstances.erase(it);
+					} else {
+						it++;
+					}
+				}
+				stoppingInstances = mStoppingInstances.size() > 0;
+			}
+
+			//get final state to restore if it has been requested
+			//outside of the build lock, set loads hold the pending lock while they unload
+			if (stopped.size()) {
+				std::lock_guard<std::mutex> pendingguard(mSetLoadPendingMutex);
+				if (mSetLoadPendingPreset) {
+					for (auto& p: stopped) {
 						auto data = p->getJSONPresetSync();
 						mSetLoadPendingPreset->insert({p->index(), data});
 					}
+				}
+			}
 
-					it = mStoppingInstances.erase(it);
-				} else {
-					it++;
+			//if we have no stopping instances, look to see if we should load a set and/or send a reset
+			if (!stoppingInstances) {
+				if (mResetPending) {
+					mResetPending = false;
+					mProcessAudio->sendReset();
+				}
+				boost::optional<SetInfo> pending;
+				boost::optional<PendingPresetMap> preset;
+				{
+					std::lock_guard<std::mutex> guard(mSetLoadPendingMutex);
+					mSetLoadPending.swap(pending);
+					mSetLoadPendingPreset.swap(preset);
+				}
+				if (pending) {
+					doLoadSet(pending.get(), preset);
 				}
 			}
-			stoppingInstances = mStoppingInstances.size() > 0;
-		}
 
-		//if we have no stopping instances, look to see if we should load a set and/or send a reset
-		if (!stoppingInstances) {
-			if (mResetPending) {
-				mResetPending = false;
-				mProcessAudio->sendReset();
+			if (mDiskSpacePollNext <= now) {
+				//XXX shouldn't need this mutex but removing listeners is causing this to throw an exception so
+				//using a hammer to make sure that doesn't happen
+				std::lock_guard<std::mutex> guard(mOssiaContextMutex);
+				updateDiskStats();
 			}
-			boost::optional<SetInfo> pending;
-			boost::optional<PendingPresetMap> preset;
-			{
-				std::lock_guard<std::mutex> guard(mSetLoadPendingMutex);
-				mSetLoadPending.swap(pending);
-				mSetLoadPendingPreset.swap(preset);
+
+			//file commands run on workers, they only flag changes and the debounce starts here
+			if (mDatafileChanged.exchange(false)) {
+				mDatafilePollNext = now + datafile_debounce_timeout;
 			}
-			if (pending) {
-				doLoadSet(pending.get(), preset);
+			if (mDatafilePollNext <= now) {
+				//XXX shouldn't need this mutex but removing listeners is causing this to throw an exception so
+				//using a hammer to make sure that doesn't happen
+				std::lock_guard<std::mutex> guard(mOssiaContextMutex);
+				updateDatafileStats();
 			}
-		}
-
-		if (mDiskSpacePollNext <= now) {
-			//XXX shouldn't need this mutex but removing listeners is causing this to throw an exception so
-			//using a hammer to make sure that doesn't happen
-			std::lock_guard<std::mutex> guard(mOssiaContextMutex);
-			updateDiskStats();
-		}
-
-		if (mDatafilePollNext <= now) {
-			//XXX shouldn't need this mutex but removing listeners is causing this to throw an exception so
-			//using a hammer to make sure that doesn't happen
-			std::lock_guard<std::mutex> guard(mOssiaContextMutex);
-			updateDatafileStats();
-		}
 
 #ifdef RNBO_USE_DBUS
-		//poll for update service if we don't already have it
-		if (!mUpdateServiceProxy && mUpdateServicePollNext < steady_clock::now()) {
-			std::lock_guard<std::mutex> guard(mOssiaContextMutex); //needed??
-			std::lock_guard<std::mutex> buildguard(mBuildMutex);
-			if (setupUpdateService()) {
-				mUpdateSupportedParam->push_value(true);
-			} else {
-				mUpdateServicePollNext = steady_clock::now() + mUpdateServicePollPeriod;
+			//poll for update service if we don't already have it
+			if (!mUpdateServiceProxy && mUpdateServicePollNext < steady_clock::now()) {
+				std::lock_guard<std::mutex> guard(mOssiaContextMutex); //needed??
+				std::lock_guard<std::mutex> buildguard(mBuildMutex);
+				if (setupUpdateService()) {
+					mUpdateSupportedParam->push_value(true);
+				} else {
+					mUpdateServicePollNext = steady_clock::now() + mUpdateServicePollPeriod;
+				}
 			}
-		}
 #endif
 
-		bool save = false;
-		{
-			//see if we got the save flag set, debounce
-			std::lock_guard<std::mutex> guard(mSaveMutex);
-			if (mSave) {
-				mSave = false;
-				mSaveNext = steady_clock::now() + save_debounce_timeout;
-			} else if (mSaveNext && mSaveNext.get() < now) {
-				save = true;
-				mSaveNext.reset();
+			bool save = false;
+			{
+				//see if we got the save flag set, debounce
+				std::lock_guard<std::mutex> guard(mSaveMutex);
+				if (mSave) {
+					mSave = false;
+					mSaveNext = steady_clock::now() + save_debounce_timeout;
+				} else if (mSaveNext && mSaveNext.get() < now) {
+					save = true;
+					mSaveNext.reset();
+				}
+			}
+			if (save) {
+				auto info = setInfo();
+				mDB->setSave(UNTITLED_SET_NAME, info);
 			}
-		}
-		if (save) {
-			auto info = setInfo();
-			mDB->setSave(UNTITLED_SET_NAME, info);
-		}
-
-		if (mSetPresetSaved) {
-			updateSetPresetNames();
-			mSetPresetSaved = false;
-		}
 
-		//sets
-		{
-			std::lock_guard<std::mutex> guard(mSetNamesMutex);
-			if (mSetNamesUpdated) {
-				mSetNamesUpdated = false;
+			if (mSetPresetSaved) {
+				updateSetPresetNames();
+				mSetPresetSaved = false;
+			}
 
-				auto dom = ossia::init_domain(ossia::val_type::STRING);
-				ossia::set_values(dom, mSetNames);
-				mSetLoadNode->set(ossia::net::domain_attribute{}, dom);
-				mSetLoadNode->set(ossia::net::bounding_mode_attribute{}, ossia::bounding_mode::CLIP);
+			//sets
+			{
+				std::lock_guard<std::mutex> guard(mSetNamesMutex);
+				if (mSetNamesUpdated) {
+					mSetNamesUpdated = false;
 
-				{
-					std::lock_guard<std::mutex> guard(mBuildMutex);
+					auto dom = ossia::init_domain(ossia::val_type::STRING);
+					ossia::set_values(dom, mSetNames);
+					mSetLoadNode->set(ossia::net::domain_attribute{}, dom);
+					mSetLoadNode->set(ossia::net::bounding_mode_attribute{}, ossia::bounding_mode::CLIP);
 
-					//remove any that have gone away
-					std::set<std::string> remove;
-					for (const auto& c: mSetsNode->children()) {
-						auto name = c->get_name();
-						if (mSetUUIDs.find(name) == mSetUUIDs.end()) {
-							remove.insert(name);
+					{
+						//the sets subtree is only changed here, under mSetNamesMutex
+						//remove any that have gone away
+						std::set<std::string> remove;
+						for (const auto& c: mSetsNode->children()) {
+							auto name = c->get_name();
+							if (mSetUUIDs.find(name) == mSetUUIDs.end()) {
+								remove.insert(name);
+							}
 						}
-					}
 
-					for (auto name: remove) {
-						mSetsNode->remove_child(name);
-					}
+						for (auto name: remove) {
+							mSetsNode->remove_child(name);
+						}
 
-					for (const auto& kv: mSetUUIDs) {
-						const std::string& name = kv.first;
-						const std::string& uuid = kv.second;
-						auto r = find_or_create_child(mSetsNode, name);
-						auto n = find_or_create_child(r, "uuid");
-						auto p = n->get_parameter();
-						if (!p) {
-							p = n->create_parameter(ossia::val_type::STRING);
-							n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
-							p->push_value(uuid);
-						} else if (p->value().get<std::string>() != uuid) {
-							p->push_value(uuid);
+						for (const auto& kv: mSetUUIDs) {
+							const std::string& name = kv.first;
+							const std::string& uuid = kv.second;
+							auto r = find_or_create_child(mSetsNode, name);
+							auto n = find_or_create_child(r, "uuid");
+							auto p = n->get_parameter();
+							if (!p) {
+								p = n->create_parameter(ossia::val_type::STRING);
+								n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+								p->push_value(uuid);
+							} else if (p->value().get<std::string>() != uuid) {
+								p->push_value(uuid);
+							}
 						}
 					}
 				}
 			}
-		}
-		{
-			std::lock_guard<std::mutex> guard(mSetPresetNamesMutex);
-			if (mSetPresetNamesUpdated) {
-				mSetPresetNamesUpdated = false;
+			{
+				std::lock_guard<std::mutex> guard(mSetPresetNamesMutex);
+				if (mSetPresetNamesUpdated) {
+					mSetPresetNamesUpdated = false;
 
-				auto dom = ossia::init_domain(ossia::val_type::STRING);
-				ossia::set_values(dom, mSetPresetNameValues);
-				mSetPresetLoadNode->set(ossia::net::domain_attribute{}, dom);
-				mSetPresetLoadNode->set(ossia::net::bounding_mode_attribute{}, ossia::bounding_mode::CLIP);
+					auto dom = ossia::init_domain(ossia::val_type::STRING);
+					ossia::set_values(dom, mSetPresetNameValues);
+					mSetPresetLoadNode->set(ossia::net::domain_attribute{}, dom);
+					mSetPresetLoadNode->set(ossia::net::bounding_mode_attribute{}, ossia::bounding_mode::CLIP);
+				}
 			}
 		}
 	} catch (const std::exception& e) {
 		std::cerr << "exception in Controller::process thread " << e.what() << std::endl;
 	}
 
+	if (mOSCIngest && mOSCIngestRoutesInvalid.exchange(false)) {
+		updateOSCIngestRoutes();
+	}
+
+	//send out everything produced this iteration
+	flushListeners(now);
+	if (now >= mListenersStatsNext) {
+		mListenersStatsNext = now + listeners_stats_period;
+		updateListenersStats();
+	}
+
+	//figure out when we need to run next if nothing wakes us
+	{
+		auto next = now + idle_wait_max;
+		if (mBusyUntil > now || !mStoppingInstances.empty() || mBuildingNodes) {
+			next = now + process_poll_period;
+		}
+		next = std::min({next, mDiskSpacePollNext, mDatafilePollNext});
+#ifdef RNBO_USE_DBUS
+		if (!mUpdateServiceProxy) {
+			next = std::min(next, mUpdateServicePollNext);
+		}
+#endif
+		{
+			std::lock_guard<std::mutex> guard(mSaveMutex);
+			if (mSave) {
+				next = now;
+			} else if (mSaveNext) {
+				next = std::min(next, mSaveNext.get());
+			}
+		}
+		//none of the above can run before the next housekeeping pass
+		next = std::max(next, mProcessNext);
+		//anything still pending after the flush is waiting on its budget
+		if (mListenerOutput->pending()) {
+			next = std::min(next, std::max(mListenerFlushNext, now + listeners_budget_retry));
+		}
+		mWakeNext = next;
+	}
+
 	//TODO allow for quitting?
 	return true;
 }
 
+void Controller::waitForEvents(std::chrono::steady_clock::time_point deadline) {
+	deadline = std::min(deadline, mWakeNext);
+	bool active = false;
+	{
+		std::lock_guard<std::mutex> guard(mOssiaContextMutex);
+		active = mReactor->wait(deadline);
+	}
+	if (active) {
+		mBusyUntil = steady_clock::now() + busy_linger;
+	}
+}
+
 void Controller::handleActive(bool active) {
 	//clear out instances if we're deactivating
 	if (!active) {
@@ -3036,7 +3461,7 @@ void Controller::handleActive(bool active) {
 		//save preset to reload on activation
 		//might cause a glitch?
 		mInstanceLastPreset.clear();
-		for (auto i: mInstances) {
+		for (auto i: *instances()) {
 			auto inst = std::get<0>(i);
 			mInstanceLastPreset.insert({inst->index(), inst->getPresetSync()});
 		}
@@ -3051,10 +3476,9 @@ void Controller::handleActive(bool active) {
 		//XXX defer to setting not active
 	} else if (!wasActive && mProcessAudio->isActive()) {
 		//if the process audio became active and there are no instances loaded, try to load_last
-		std::lock_guard<std::mutex> guard(mBuildMutex);
-		if (!mInstances.size()) {
+		if (!instances()->size()) {
 			//load last if we're activating from inactive
-			mCommandQueue.push("load_last");
+			queueCommand("load_last");
 		}
 	}
 }
@@ -3066,62 +3490,92 @@ bool Controller::tryActivateAudio(bool startServer) {
 }
 
 void Controller::dispatchOSC(const std::string& addr, const ossia::value& v) {
-	//based on code example from jcelerier
-	auto nodes = ossia::net::find_nodes(mServer->get_root_node(), addr);
-	bool message_sent = false;
+	//instances processing in parallel must not push into nodes they don't own, defer to the controller thread
+	if (EventDispatcher::onWorker()) {
+		mOSCDispatchQueue.push(std::make_pair(addr, v));
+		return;
+	}
+
+	//copy as pushing values may alter the tree and invalidate the cache
+	const auto& resolved = mOSCRouteCache->resolve(addr);
+	boost::container::small_vector<ossia::net::parameter_base *, 4> params(resolved.begin(), resolved.end());
 
 	bool isimpulse = v.get_type() == ossia::val_type::IMPULSE;
-	for (auto& n : nodes) {
-		if (auto param = n->get_parameter()) {
-			//query
-			if (isimpulse && param->get_value_type() != ossia::val_type::IMPULSE && param->get_access() != ossia::access_mode::SET) {
-				param->push_value();
-			} else {
-				param->push_value(v);
-			}
-			message_sent = true;
+	for (auto param: params) {
+		//query
+		if (isimpulse && param->get_value_type() != ossia::val_type::IMPULSE && param->get_access() != ossia::access_mode::SET) {
+			param->push_value();
+		} else {
+			param->push_value(v);
 		}
 	}
 
 	//send out but also callback into any local osc listeners
-	if (!message_sent) {
+	if (params.empty()) {
 		mProtocol->push_raw({addr, v});
 		onUnhandledOSC(addr, v);
 	}
 }
 
 void Controller::onUnhandledOSC(ossia::string_view addrview, const ossia::value& val) {
-	std::lock_guard<std::recursive_mutex> guard(mOSCMapMutex);
+	boost::container::small_vector<ossia::net::parameter_base *, 4> params;
+	{
+		std::lock_guard<std::recursive_mutex> guard(mOSCMapMutex);
 
-	//c++17 can't use string_view for lookup: https://www.cppstories.com/2021/heterogeneous-access-cpp20/
-	std::string addr(addrview.begin(), addrview.end());
+		auto it = mOSCToParam.find(std::string_view(addrview.data(), addrview.size()));
+		if (it == mOSCToParam.end()) {
+			return;
+		}
 
-	auto it = mOSCToParam.find(addr);
-	if (it == mOSCToParam.end()) {
-		return;
+		for (const auto& localaddr: it->second) {
+			const auto& resolved = mOSCRouteCache->resolve(localaddr);
+			params.insert(params.end(), resolved.begin(), resolved.end());
+		}
 	}
 
-	auto& root = mServer->get_root_node();
-	for (auto localaddr: it->second) {
-		auto node = ossia::net::find_node(root, localaddr);
-		if (node != nullptr) {
-			auto param = node->get_parameter();
-			if (param) {
-				param->push_value(val);
-			}
-		}
+	for (auto param: params) {
+		param->push_value(val);
 	}
 }
 
+void Controller::onTreeNodeChanged(const ossia::net::node_base&) {
+	if (!QuietTreeChanges::active()) {
+		mOSCRouteCache->invalidate();
+		mOSCIngestRoutesInvalid = true;
+	}
+}
 
-void Controller::registerOSCMapping(bool doregister, const std::string& oscaddr, const std::string& localaddr) {
-	std::lock_guard<std::recursive_mutex> guard(mOSCMapMutex);
-	auto it = mOSCToParam.find(oscaddr);
-	if (doregister) {
-		if (it != mOSCToParam.end()) {
-			it->second.insert(localaddr);
-		} else {
-			mOSCToParam.insert({oscaddr, {localaddr}});
+void Controller::onTreeNodeRenamed(const ossia::net::node_base&, const std::string&) {
+	if (!QuietTreeChanges::active()) {
+		mOSCRouteCache->invalidate();
+		mOSCIngestRoutesInvalid = true;
+	}
+}
+
+void Controller::onTreeParameterChanged(const ossia::net::parameter_base&) {
+	if (!QuietTreeChanges::active()) {
+		mOSCRouteCache->invalidate();
+		mOSCIngestRoutesInvalid = true;
+	}
+}
+
+void Controller::updateOSCIngestRoutes() {
+	auto routes = std::make_shared<OSCIngest::Routes>();
+	for (auto& i: *instances()) {
+		std::get<0>(i)->addIngestRoutes(*routes);
+	}
+	mOSCIngest->setRoutes(routes);
+}
+
+void Controller::registerOSCMapping(bool doregister, const std::string& oscaddr, const std::string& localaddr) {
+	std::lock_guard<std::recursive_mutex> guard(mOSCMapMutex);
+	mOSCRouteCache->invalidate();
+	auto it = mOSCToParam.find(oscaddr);
+	if (doregister) {
+		if (it != mOSCToParam.end()) {
+			it->second.insert(localaddr);
+		} else {
+			mOSCToParam.insert({oscaddr, {localaddr}});
 		}
 	} else {
 		if (it != mOSCToParam.end()) {
@@ -3137,18 +3591,27 @@ void Controller::reportActive() {
 	mAudioActive->set_value(mProcessAudio->isActive());
 }
 
-void Controller::clearInstances(std::lock_guard<std::mutex>&, float fadeTime) {
+std::shared_ptr<const Controller::InstanceList> Controller::instances() {
+	std::lock_guard<std::mutex> guard(mInstanceListMutex);
+	return mInstances;
+}
+
+void Controller::modifyInstances(std::function<void(InstanceList&)> f) {
+	std::lock_guard<std::mutex> guard(mInstanceListMutex);
+	auto list = std::make_shared<InstanceList>(*mInstances);
+	f(*list);
+	mInstances = list;
+}
+
+void Controller::clearInstances(std::lock_guard<std::mutex>& guard, float fadeTime) {
 	auto info = setInfo();
 
-	for (auto it = mInstances.begin(); it < mInstances.end(); ) {
-		auto inst = std::get<0>(*it);
-		auto index = inst->index();
-		inst->stop(fadeTime);
-		mStoppingInstances.push_back(inst);
-		it = mInstances.erase(it);
-		if (!mInstancesNode->remove_child(std::to_string(index))) {
-			std::cerr << "failed to remove instance node with index " << index << std::endl;
-		}
+	InstanceList removed;
+	modifyInstances([&removed](InstanceList& list) {
+		std::swap(removed, list);
+	});
+	for (auto& i: removed) {
+		removeInstance(guard, std::get<0>(i), fadeTime);
 	}
 
 	//disconnect any connections that don't flow thru rnbo instances
@@ -3163,22 +3626,251 @@ void Controller::clearInstances(std::lock_guard<std::mutex>&, float fadeTime) {
 	mResetPending = true; //send reset after unload
 }
 
-void Controller::unloadInstance(std::lock_guard<std::mutex>&, unsigned int index) {
-	for (auto it = mInstances.begin(); it < mInstances.end(); it++) {
-		auto inst = std::get<0>(*it);
-		if (inst->index() == index) {
-			mInstances.erase(it);
-			inst->stop(mInstFadeOutMs);
-			mStoppingInstances.push_back(inst);
-			if (!mInstancesNode->remove_child(std::to_string(index))) {
-				std::cerr << "failed to remove instance node with index " << index << std::endl;
-			}
-			return;
+void Controller::unloadInstance(std::lock_guard<std::mutex>& guard, unsigned int index) {
+	std::shared_ptr<Instance> inst;
+	modifyInstances([&inst, index](InstanceList& list) {
+		auto it = std::find_if(list.begin(), list.end(), [index](const auto& i) { return std::get<0>(i)->index() == index; });
+		if (it != list.end()) {
+			inst = std::get<0>(*it);
+			list.erase(it);
 		}
+	});
+	if (inst) {
+		removeInstance(guard, inst, mInstFadeOutMs);
+	}
+}
+
+void Controller::removeInstance(std::lock_guard<std::mutex>&, std::shared_ptr<Instance> inst, float fadeTime) {
+	auto index = inst->index();
+	inst->stop(fadeTime);
+	mStoppingInstances.push_back(inst);
+
+	//a snapshot might still be processing it, wait for that and make sure it doesn't touch the subtree again
+	auto tree = inst->lockTree();
+	inst->detachTree();
+	if (!mInstancesNode->remove_child(std::to_string(index))) {
+		std::cerr << "failed to remove instance node with index " << index << std::endl;
 	}
 }
 
 void Controller::registerCommands() {
+	mCommandHandlers.insert({
+			"batch",
+			[this](const std::string& method, const std::string& id, const RNBO::Json& params) {
+				if (!params.is_object() || !params.contains("commands") || !params["commands"].is_array()) {
+					reportCommandError(id, static_cast<unsigned int>(BatchCommandError::InvalidRequestObject), "request object invalid, commands must be an array");
+					return;
+				}
+				const bool transaction = params.contains("transaction") && params["transaction"].is_boolean() && params["transaction"].get<bool>();
+				//a failure rolls back a transaction so there is no point going on
+				const bool stopOnError = transaction || (params.contains("stop_on_error") && params["stop_on_error"].is_boolean() && params["stop_on_error"].get<bool>());
+
+				//keep the db alive and hold it for the whole batch
+				auto db = mDB;
+				boost::optional<DB::Batch> dbBatch;
+				if (transaction) {
+					//command_ordering puts transactions in the controller thread, see DB::Batch
+					assert(!CommandExecutor::onWorker());
+					dbBatch.emplace(*db);
+				}
+
+				RNBO::Json results = RNBO::Json::array();
+				unsigned int failed = 0;
+				const auto& commands = params["commands"];
+				for (size_t i = 0; i < commands.size() && !(stopOnError && failed); i++) {
+					const auto& c = commands[i];
+					std::string subid = id + "/" + std::to_string(i);
+					if (c.is_object() && c.contains("id") && c["id"].is_string()) {
+						subid = c["id"].get<std::string>();
+					}
+
+					RNBO::Json entry = {
+						{"id", subid},
+						{"responses", RNBO::Json::array()}
+					};
+					if (!c.is_object() || !c.contains("method") || !c["method"].is_string()) {
+						entry["responses"].push_back({{"error", {{"code", static_cast<unsigned int>(BatchCommandError::InvalidRequestObject)}, {"message", "command must be an object with a method"}}}});
+					} else {
+						std::string submethod = c["method"].get<std::string>();
+						entry["method"] = submethod;
+						//these replace or wait on everything the batch is holding
+						if (submethod == "batch" || submethod == "db_restore") {
+							entry["responses"].push_back({{"error", {{"code", static_cast<unsigned int>(BatchCommandError::InvalidRequestObject)}, {"message", submethod + " cannot be batched"}}}});
+						} else {
+							BatchCapture capture(subid, entry["responses"]);
+							runCommand(submethod, subid, c.contains("params") ? c["params"] : RNBO::Json());
+						}
+					}
+					if (entry["responses"].size() && entry["responses"].back().contains("error")) {
+						failed++;
+					}
+					results.push_back(std::move(entry));
+				}
+
+				if (failed == 0) {
+					if (dbBatch) {
+						dbBatch->commit();
+					}
+					reportCommandResult(id, {
+						{"code", 0},
+						{"message", "completed"},
+						{"results", results},
+						{"progress", 100}
+					});
+				} else {
+					if (dbBatch) {
+						dbBatch.reset();
+						//only the database is rolled back, bring the listings back in line with it
+						updateSetNames();
+						updateSetPresetNames();
+						{
+							std::lock_guard<std::mutex> guard(mPatchersNodeMutex);
+							updatePatchersInfo();
+						}
+						{
+							std::lock_guard<std::mutex> guard(mSetViewsMutex);
+							updateSetViews(getCurrentSetName());
+						}
+					}
+					std::string message = transaction ? "a command failed, rolled back" : std::to_string(failed) + " command(s) failed";
+					reportCommandStatus(id, {
+						{ "error",
+						{
+							{ "code", static_cast<unsigned int>(BatchCommandError::CommandFailed) },
+							{ "message", message },
+							{ "data", { {"results", results} } }
+						}
+						}
+					}, true);
+				}
+			}
+	});
+
+	mCommandHandlers.insert({
+			"compile_cancel",
+			[this](const std::string& method, const std::string& id, const RNBO::Json& params) {
+				//should terminate
+				compileProcess.reset();
+				reportCommandResult(id, {
+					{"code", static_cast<unsigned int>(CompileLoadStatus::Cancelled)},
+					{"message", "cancelled"},
+					{"progress", 100}
+				});
+			}
+	});
+
+	mCommandHandlers.insert({
+			"compile",
+			[this](const std::string& method, const std::string& id, const RNBO::Json& params) {
+				//terminate existing
+				compileProcess.reset();
+
+				std::string timeTag = std::to_string(std::chrono::seconds(std::time(NULL)).count());
+#if RNBO_USE_DBUS
+				//update the outpdated package list
+				if (mUpdateServiceProxy && params.contains("update_outdated") && params["update_outdated"].get<bool>()) {
+					try {
+						mUpdateServiceProxy->UpdateOutdated();
+					} catch (...) { }
+				}
+#endif
+
+				//support either a pre-written file or embedded "code"
+				if (!params.is_object() || !(params.contains("filename") || params.contains("code"))) {
+					reportCommandError(id, static_cast<unsigned int>(CompileLoadError::InvalidRequestObject), "request object invalid");
+					return;
+				}
+				//get filename or generate one
+				std::string fileName = params.contains("filename") ? params["filename"].get<std::string>() : ("rnbogen." + timeTag + ".cpp");
+				fs::path sourceFile = fs::absolute(mSourceCache / fileName);
+
+				//write code if we have it
+				if (params.contains("code")) {
+					std::string code = params["code"];
+					std::fstream f;
+					f.open(sourceFile.string(), std::fstream::out | std::fstream::trunc);
+					if (!f.is_open()) {
+						reportCommandError(id, static_cast<unsigned int>(CompileLoadError::SourceWriteFailed), "failed to open file for write: " + sourceFile.string());
+						return;
+					}
+					f << code;
+					f.close();
+				}
+
+				//make sure the source file exists
+				if (!fs::exists(sourceFile)) {
+					reportCommandError(id, static_cast<unsigned int>(CompileLoadError::SourceFileDoesNotExist), "cannot file source file: " + sourceFile.string());
+					return;
+				}
+				reportCommandResult(id, {
+					{"code", static_cast<unsigned int>(CompileLoadStatus::Received)},
+					{"message", "received"},
+					{"progress", 10}
+				});
+
+				//config might be in a file
+				RNBO::Json config;
+				fs::path confFilePath;
+				if (params.contains("config_file")) {
+					confFilePath = params["config_file"].get<std::string>();
+					confFilePath = fs::absolute(mSourceCache / confFilePath);
+					std::ifstream i(confFilePath.string());
+					i >> config;
+					i.close();
+				} else if (params.contains("config")) {
+					config = params["config"];
+				}
+
+				std::string libName = fs::path(fileName).replace_extension().string();
+				fs::path libPath = fs::absolute(mCompileCache / fs::path(std::string(RNBO_DYLIB_PREFIX) + libName + "." + rnbo_dylib_suffix));
+				//program path_to_generated.cpp libraryName pathToConfigFile
+				std::vector<std::string> args = {
+					sourceFile.string(), libName, config::get<fs::path>(config::key::RnboCPPDir).get().string(), config::get<fs::path>(config::key::CompileCacheDir).get().string()
+				};
+				auto cmake = config::get<fs::path>(config::key::CMakePath);
+				if (cmake) {
+					args.push_back(cmake.get().string());
+				}
+
+				//start compile
+				{
+					boost::optional<unsigned int> instanceIndex = 0;
+					fs::path rnboPatchPath;
+
+					std::string maxRNBOVersion = "unknown";
+
+					if (params.contains("patcher_file")) {
+						rnboPatchPath = params["patcher_file"].get<std::string>();
+						rnboPatchPath = fs::absolute(mSourceCache / rnboPatchPath);
+					}
+
+					if (params.contains("rnbo_version")) {
+						maxRNBOVersion = params["rnbo_version"].get<std::string>();
+					}
+
+					bool migratePresets = params.contains("migrate_presets") && params["migrate_presets"].is_boolean() && params["migrate_presets"].get<bool>();
+
+					if (params.contains("load")) {
+						if (params["load"].is_null()) {
+							instanceIndex = boost::none;
+						} else {
+							int index = params["load"].get<int>();
+							if (index < 0) {
+								index = nextInstanceIndex();
+							}
+							instanceIndex = boost::make_optional(static_cast<unsigned int>(index));
+							{
+								std::lock_guard<std::mutex> guard(mBuildMutex);
+								unloadInstance(guard, instanceIndex.get());
+							}
+							mProcessAudio->updatePorts();
+						}
+					}
+					compileProcess = CompileInfo(build_program, args, libPath, id, config, confFilePath, rnboPatchPath, maxRNBOVersion, migratePresets, instanceIndex);
+				}
+			}
+	});
+
 	mCommandHandlers.insert({
 			"activate_audio",
 			[this](const std::string& method, const std::string& id, const RNBO::Json& params) {
@@ -3207,8 +3899,9 @@ void Controller::registerCommands() {
 				std::string name = params["name"].get<std::string>();
 				std::string newName = params["newName"].get<std::string>();
 				mDB->patcherRename(name, newName);
+				mPatcherListing->rename(name, newName);
 				{
-					std::lock_guard<std::mutex> guard(mBuildMutex);
+					std::lock_guard<std::mutex> guard(mPatchersNodeMutex);
 					mPatchersNode->remove_child(name);
 					updatePatchersInfo(newName);
 				}
@@ -3307,8 +4000,7 @@ void Controller::registerCommands() {
 
 					updateSetPresetNames();
 					{
-
-						std::lock_guard<std::mutex> guard(mBuildMutex);
+						std::lock_guard<std::mutex> guard(mSetViewsMutex);
 						updateSetViews(loaded);
 					}
 				}
@@ -3351,7 +4043,7 @@ void Controller::registerCommands() {
 						if (loaded.size() > 0 && loaded != name) {
 							mDB->setViewsCopy(loaded, name);
 						}
-						std::lock_guard<std::mutex> guard(mBuildMutex);
+						std::lock_guard<std::mutex> guard(mSetViewsMutex);
 						updateSetViews(name);
 
 						if (loaded == UNTITLED_SET_NAME) {
@@ -3431,7 +4123,7 @@ void Controller::registerCommands() {
 					mSetCurrentNameParam->push_value(UNTITLED_SET_NAME);
 					mSetDirtyParam->push_value(false);
 					{
-						std::lock_guard<std::mutex> guard(mBuildMutex);
+						std::lock_guard<std::mutex> guard(mSetViewsMutex);
 						mSetViewsListNode->clear_children();
 					}
 				}
@@ -3444,6 +4136,7 @@ void Controller::registerCommands() {
 				std::string name = params["name"].get<std::string>();
 				std::string newName = params["newName"].get<std::string>();
 				if (mDB->setRename(name, newName)) {
+					mSetListing->rename(name, newName);
 					reportCommandResult(id, {
 						{"code", 0},
 						{"message", "renamed"},
@@ -3644,7 +4337,7 @@ void Controller::registerCommands() {
 
 					int index = mDB->setViewCreate(setname, viewname, viewParams);
 					{
-						std::lock_guard<std::mutex> guard(mBuildMutex);
+						std::lock_guard<std::mutex> guard(mSetViewsMutex);
 						addSetView(setname, index);
 					}
 
@@ -3671,7 +4364,7 @@ void Controller::registerCommands() {
 					mDB->setViewDestroy(setname, index);
 
 					{
-						std::lock_guard<std::mutex> guard(mBuildMutex);
+						std::lock_guard<std::mutex> guard(mSetViewsMutex);
 						if (index < 0) {
 							mSetViewsListNode->clear_children();
 						} else {
@@ -3832,7 +4525,7 @@ void Controller::registerCommands() {
 
 					//update file stats after datafile delete
 					if (filetype == "datafile") {
-						mDatafilePollNext = steady_clock::now() + datafile_debounce_timeout;
+						mDatafileChanged = true;
 					}
 
 				} else {
@@ -3858,7 +4551,7 @@ void Controller::registerCommands() {
 
 			//update timeout for datafile polling while file is writing, we want to read after all file operations complete
 			if (filetype == "datafile") {
-				mDatafilePollNext = steady_clock::now() + datafile_debounce_timeout;
+				mDatafileChanged = true;
 			}
 
 			//special handling for sets, filename == set name, we actually store
@@ -3916,7 +4609,7 @@ void Controller::registerCommands() {
 				SetInfo info = SetInfo::fromJson(setData);
 				mDB->setSave(fileName, info);
 				storeSetContent(setData, mDB, fileName);
-				updateSetNames();
+				onController([this]() { updateSetNames(); });
 			}
 
 			reportCommandResult(id, {
@@ -4459,15 +5152,29 @@ void Controller::registerCommands() {
 				if (!validateListenerCmd(id, params, key))
 					return;
 
+				//budgets, filters and priorities are optional, given inline with ip and port
+				RNBO::Json options;
+				auto optionsJson = OSCBundleProtocol::Options::fromJson(params).toJson();
+				for (auto& [k, v]: optionsJson.items()) {
+					if (params.contains(k)) {
+						options = optionsJson;
+						break;
+					}
+				}
+
 				if (!mDB->listenerExists(key.first, key.second)) {
 					try {
 						std::lock_guard<std::mutex> guard(mOssiaContextMutex);
-						listenersAddProtocol(key.first, key.second);
-						mDB->listenersAdd(key.first, key.second);
+						listenersAdd(key.first, key.second, options);
+						mDB->listenersAdd(key.first, key.second, options.is_null() ? std::string() : options.dump());
 					} catch (const std::exception&) {
 						reportCommandError(id, static_cast<unsigned int>(ListenerCommandStatus::Failed), "failed add listener for ip: " + key.first + " and port: " + std::to_string(key.second));
 						return;
 					}
+				} else if (!options.is_null()) {
+					std::lock_guard<std::mutex> guard(mOssiaContextMutex);
+					mListenerOutput->setOptions(key.first + ":" + std::to_string(key.second), OSCBundleProtocol::Options::fromJson(options));
+					mDB->listenersSetOptions(key.first, key.second, options.dump());
 				}
 				updateListenersList();
 				reportCommandResult(id, {
@@ -4487,18 +5194,10 @@ void Controller::registerCommands() {
 				if (mDB->listenersDel(key.first, key.second)) {
 					std::string lookup = key.first + ":" + std::to_string(key.second);
 					std::lock_guard<std::mutex> guard(mOssiaContextMutex);
-					auto it = mListenerProtocol.find(lookup);
-					if (it == mListenerProtocol.end()) {
-						std::string msg = "failed to find listener protocol for key " + lookup;
+					if (!mListenerOutput->removeListener(lookup)) {
+						std::string msg = "failed to find listener for key " + lookup;
 						throw std::runtime_error(msg);
 					}
-					for (auto& p: mProtocol->get_protocols()) {
-						if (it->second == reinterpret_cast<std::uintptr_t>(p.get())) {
-							mProtocol->stop_expose_to(*p);
-							break;
-						}
-					}
-					mListenerProtocol.erase(it);
 					updateListenersList();
 				}
 				reportCommandResult(id, {
@@ -4517,16 +5216,7 @@ void Controller::registerCommands() {
 
 				std::lock_guard<std::mutex> guard(mOssiaContextMutex);
 				mDB->listenersClear();
-
-				for (auto it: mListenerProtocol) {
-					for (auto& p: mProtocol->get_protocols()) {
-						if (it.second == reinterpret_cast<std::uintptr_t>(p.get())) {
-							mProtocol->stop_expose_to(*p);
-							break;
-						}
-					}
-				}
-				mListenerProtocol.clear();
+				mListenerOutput->clearListeners();
 
 				updateListenersList();
 				reportCommandResult(id, {
@@ -4682,14 +5372,17 @@ void Controller::processCommands() {
 		}
 
 		while (auto cmd = mCommandQueue.tryPop()) {
-			std::string cmdStr = cmd.get();
+			std::string cmdStr = std::move(cmd.get());
 
 			//internal commands
 			if (cmdStr == "load_last") {
-				//terminate existing compile
-				compileProcess.reset();
+				mCommandExecutor->submit({ "compile", "instance", "db/sets" }, CommandExecutor::Thread::Controller, [this]() {
+					runControllerTasks();
+					//terminate existing compile
+					compileProcess.reset();
 
-				loadSet(UNTITLED_SET_NAME);
+					loadSet(UNTITLED_SET_NAME);
+				});
 				continue;
 			}
 
@@ -4701,136 +5394,20 @@ void Controller::processCommands() {
 			std::string id = cmdObj["id"];
 			std::string method = cmdObj["method"];
 			RNBO::Json params = cmdObj["params"];
-			if (method == "compile_cancel") {
-				//should terminate
-				compileProcess.reset();
-				reportCommandResult(id, {
-					{"code", static_cast<unsigned int>(CompileLoadStatus::Cancelled)},
-					{"message", "cancelled"},
-					{"progress", 100}
-				});
-				continue;
-			} else if (method == "compile") {
-				//terminate existing
-				compileProcess.reset();
-
-				std::string timeTag = std::to_string(std::chrono::seconds(std::time(NULL)).count());
-#if RNBO_USE_DBUS
-				//update the outpdated package list
-				if (mUpdateServiceProxy && params.contains("update_outdated") && params["update_outdated"].get<bool>()) {
-					try {
-						mUpdateServiceProxy->UpdateOutdated();
-					} catch (...) { }
-				}
-#endif
-
-				//support either a pre-written file or embedded "code"
-				if (!params.is_object() || !(params.contains("filename") || params.contains("code"))) {
-					reportCommandError(id, static_cast<unsigned int>(CompileLoadError::InvalidRequestObject), "request object invalid");
-					continue;
-				}
-				//get filename or generate one
-				std::string fileName = params.contains("filename") ? params["filename"].get<std::string>() : ("rnbogen." + timeTag + ".cpp");
-				fs::path sourceFile = fs::absolute(mSourceCache / fileName);
-
-				//write code if we have it
-				if (params.contains("code")) {
-					std::string code = params["code"];
-					std::fstream f;
-					f.open(sourceFile.string(), std::fstream::out | std::fstream::trunc);
-					if (!f.is_open()) {
-						reportCommandError(id, static_cast<unsigned int>(CompileLoadError::SourceWriteFailed), "failed to open file for write: " + sourceFile.string());
-						continue;
-					}
-					f << code;
-					f.close();
-				}
-
-				//make sure the source file exists
-				if (!fs::exists(sourceFile)) {
-					reportCommandError(id, static_cast<unsigned int>(CompileLoadError::SourceFileDoesNotExist), "cannot file source file: " + sourceFile.string());
-					continue;
-				}
-				reportCommandResult(id, {
-					{"code", static_cast<unsigned int>(CompileLoadStatus::Received)},
-					{"message", "received"},
-					{"progress", 10}
-				});
-
-				//config might be in a file
-				RNBO::Json config;
-				fs::path confFilePath;
-				if (params.contains("config_file")) {
-					confFilePath = params["config_file"].get<std::string>();
-					confFilePath = fs::absolute(mSourceCache / confFilePath);
-					std::ifstream i(confFilePath.string());
-					i >> config;
-					i.close();
-				} else if (params.contains("config")) {
-					config = params["config"];
-				}
-
-				std::string libName = fs::path(fileName).replace_extension().string();
-				fs::path libPath = fs::absolute(mCompileCache / fs::path(std::string(RNBO_DYLIB_PREFIX) + libName + "." + rnbo_dylib_suffix));
-				//program path_to_generated.cpp libraryName pathToConfigFile
-				std::vector<std::string> args = {
-					sourceFile.string(), libName, config::get<fs::path>(config::key::RnboCPPDir).get().string(), config::get<fs::path>(config::key::CompileCacheDir).get().string()
-				};
-				auto cmake = config::get<fs::path>(config::key::CMakePath);
-				if (cmake) {
-					args.push_back(cmake.get().string());
-				}
-
-				//start compile
-				{
-					boost::optional<unsigned int> instanceIndex = 0;
-					fs::path rnboPatchPath;
-
-					std::string maxRNBOVersion = "unknown";
-
-					if (params.contains("patcher_file")) {
-						rnboPatchPath = params["patcher_file"].get<std::string>();
-						rnboPatchPath = fs::absolute(mSourceCache / rnboPatchPath);
-					}
-
-					if (params.contains("rnbo_version")) {
-						maxRNBOVersion = params["rnbo_version"].get<std::string>();
-					}
-
-					bool migratePresets = params.contains("migrate_presets") && params["migrate_presets"].is_boolean() && params["migrate_presets"].get<bool>();
-
-					if (params.contains("load")) {
-						if (params["load"].is_null()) {
-							instanceIndex = boost::none;
-						} else {
-							int index = params["load"].get<int>();
-							if (index < 0) {
-								index = nextInstanceIndex();
-							}
-							instanceIndex = boost::make_optional(static_cast<unsigned int>(index));
-							{
-								std::lock_guard<std::mutex> guard(mBuildMutex);
-								unloadInstance(guard, instanceIndex.get());
-							}
-							mProcessAudio->updatePorts();
-						}
-					}
-					compileProcess = CompileInfo(build_program, args, libPath, id, config, confFilePath, rnboPatchPath, maxRNBOVersion, migratePresets, instanceIndex);
-				}
-			} else {
-				try {
-					auto f = mCommandHandlers.find(method);
-					if (f != mCommandHandlers.end()) {
-						f->second(method, id, params);
-					} else {
-						cerr << "unknown method " << method << endl;
-					}
-				} catch (const std::exception& e) {
-					std::string message = "error processing method: " + method + " with error: " + e.what();
-					reportCommandError(id, 1000, message);
-				}
-			}
+			auto ordering = command_ordering(method, params);
+			mCommandExecutor->submit(std::move(ordering.keys), ordering.thread, [this, method, id, params]() {
+				//a worker that ran a command this one is ordered after has queued its tree changes before finishing,
+				//apply them first so this command sees them
+				if (!CommandExecutor::onWorker()) {
+					runControllerTasks();
+				}
+				runCommand(method, id, params);
+			});
 		}
+
+		//commands that were waiting on others might be ready, workers wake us when they finish one
+		mCommandExecutor->runController();
+		runControllerTasks();
 	} catch (const std::exception& e) {
 		cerr << "exception processing command " << e.what() << endl;
 	} catch (...) {
@@ -4838,6 +5415,33 @@ void Controller::processCommands() {
 	}
 }
 
+void Controller::queueCommand(std::string cmd) {
+	if (mCommandQueue.push(cmd)) {
+		return;
+	}
+	//answer rather than leave the client waiting for a response that never comes
+	auto cmdObj = RNBO::Json::parse(cmd, nullptr, false);
+	if (cmdObj.is_object() && cmdObj.contains("id") && cmdObj["id"].is_string()) {
+		reportCommandError(cmdObj["id"].get<std::string>(), static_cast<unsigned int>(CommandError::QueueFull), "command queue full");
+	} else {
+		cerr << "command queue full, dropped " << cmd << endl;
+	}
+}
+
+void Controller::runCommand(const std::string& method, const std::string& id, const RNBO::Json& params) {
+	try {
+		auto f = mCommandHandlers.find(method);
+		if (f != mCommandHandlers.end()) {
+			f->second(method, id, params);
+		} else {
+			cerr << "unknown method " << method << endl;
+		}
+	} catch (const std::exception& e) {
+		std::string message = "error processing method: " + method + " with error: " + e.what();
+		reportCommandError(id, 1000, message);
+	}
+}
+
 void Controller::reportCommandResult(std::string id, RNBO::Json res) {
 	reportCommandStatus(id, { {"result", res} });
 }
@@ -4854,16 +5458,52 @@ void Controller::reportCommandError(std::string id, unsigned int code, std::stri
 }
 
 void Controller::reportCommandStatus(std::string id, RNBO::Json obj, bool printerr) {
+	if (tBatchCapture && tBatchCapture->id == id) {
+		if (printerr) {
+			std::cerr << obj.dump() << std::endl;
+		}
+		tBatchCapture->responses.push_back(std::move(obj));
+		return;
+	}
 	obj["jsonrpc"] = "2.0";
 	obj["id"] = id;
 	std::string status = obj.dump();
 	if (id == "internal") {
 		std::cout << status << std::endl;
 	} else {
-		mResponseParam->push_value(status);
 		if (printerr) {
 			std::cerr << status << std::endl;
 		}
+		onController([this, status = std::move(status)]() {
+			mResponseParam->push_value(status);
+		});
+	}
+}
+
+void Controller::onController(std::function<void()> func) {
+	if (!CommandExecutor::onWorker()) {
+		func();
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> guard(mControllerTasksMutex);
+		mControllerTasks.push_back(std::move(func));
+	}
+	Reactor::wake();
+}
+
+void Controller::runControllerTasks() {
+	std::vector<std::function<void()>> tasks;
+	{
+		std::lock_guard<std::mutex> guard(mControllerTasksMutex);
+		std::swap(tasks, mControllerTasks);
+	}
+	for (auto& task: tasks) {
+		try {
+			task();
+		} catch (const std::exception& e) {
+			cerr << "exception applying command worker changes " << e.what() << endl;
+		}
 	}
 }
 
@@ -4909,16 +5549,16 @@ void Controller::updateDatafileStats() {
 
 void Controller::updateListenersList() {
 	std::vector<ossia::value> l;
-	mDB->listeners([&l](const std::string& ip, uint16_t port) {
+	mDB->listeners([&l](const std::string& ip, uint16_t port, const std::string&) {
 		l.push_back(ip + ":" + std::to_string(port));
 	});
 	mListenersListParam->push_value(l);
 }
 
 void Controller::restoreListeners() {
-	mDB->listeners([this](const std::string& ip, uint16_t port) {
+	mDB->listeners([this](const std::string& ip, uint16_t port, const std::string& options) {
 			try {
-				listenersAddProtocol(ip, port);
+				listenersAdd(ip, port, options.size() ? RNBO::Json::parse(options, nullptr, false) : RNBO::Json());
 			} catch (...) {
 				std::cerr << "error adding listener ip: " << ip << " port: " << std::to_string(port) << std::endl;
 			}
@@ -4926,25 +5566,37 @@ void Controller::restoreListeners() {
 	updateListenersList();
 }
 
-void Controller::listenersAddProtocol(const std::string& ip, uint16_t port) {
-	using conf = ossia::net::osc_protocol_configuration;
-	auto protocol = ossia::net::make_osc_protocol(
-			mOssiaContext,
-			{
-				.mode = conf::HOST,
-				.version = conf::OSC1_1,
-				.framing = conf::SLIP, //gcc doesn't like the default members, so we specify this even though it is a default
-				.transport = ossia::net::udp_configuration {{
-					.local = std::nullopt,
-					.remote = ossia::net::send_socket_configuration {{ip, port}}
-				}}
-			}
-		);
-
-	//keep track
+void Controller::listenersAdd(const std::string& ip, uint16_t port, const RNBO::Json& options) {
+	//values are aggregated into bundles and sent in flushListeners
 	std::string key = ip + ":" + std::to_string(port);
-	mListenerProtocol.insert({key, reinterpret_cast<std::uintptr_t>(protocol.get())});
-	mProtocol->expose_to(std::move(protocol));
+	mListenerOutput->addListener(key, ip, port, OSCBundleProtocol::Options::fromJson(options));
+}
+
+void Controller::flushListeners(std::chrono::steady_clock::time_point now) {
+	if (now < mListenerFlushNext) {
+		return;
+	}
+	mListenerFlushNext = now + mListenerFlushInterval;
+
+	std::lock_guard<std::mutex> guard(mOssiaContextMutex);
+	mListenerOutput->flush();
+}
+
+void Controller::updateListenersStats() {
+	RNBO::Json stats = RNBO::Json::object();
+	for (auto& [key, s]: mListenerOutput->stats()) {
+		stats[key] = {
+			{"sent", s.sent},
+			{"bytes", s.bytes},
+			{"dropped", s.dropped},
+			{"queued", s.queued}
+		};
+	}
+	auto str = stats.dump();
+	if (str != mListenersStatsLast) {
+		mListenersStatsLast = str;
+		mListenersStatsParam->push_value(str);
+	}
 }
 
 void Controller::handleProgramChange(ProgramChange p) {
@@ -4963,7 +5615,7 @@ void Controller::handleProgramChange(ProgramChange p) {
 						}
 					}
 				};
-				mCommandQueue.push(cmd.dump());
+				queueCommand(cmd.dump());
 			} else {
 				std::cerr << "no patcher at index " << (int)p.prog << std::endl;
 			}
@@ -4983,7 +5635,7 @@ void Controller::handleProgramChange(ProgramChange p) {
 						}
 					}
 				};
-				mCommandQueue.push(cmd.dump());
+				queueCommand(cmd.dump());
 			} else {
 				std::cerr << "no set at index " << (int)p.prog << std::endl;
 			}
@@ -5010,7 +5662,7 @@ void Controller::handleProgramChange(ProgramChange p) {
 						}
 					}
 				};
-				mCommandQueue.push(cmd.dump());
+				queueCommand(cmd.dump());
 			} else {
 				std::cerr << "no set preset at index " << (int)p.prog << std::endl;
 			}
@@ -9,6 +9,8 @@
 #include <memory>
 #include <functional>
 #include <unordered_map>
+#include <string_view>
+#include <chrono>
 
 #include <boost/filesystem.hpp>
 #include <boost/optional.hpp>
@@ -17,6 +19,7 @@
 #include "ProcessAudio.h"
 #include "Queue.h"
 #include "DB.h"
+#include "OSCRouteCache.h"
 
 //forward declarations
 namespace ossia {
@@ -36,6 +39,15 @@ struct PackageInstallOptions {
 #ifdef RNBO_USE_DBUS
 class RnboUpdateServiceProxy;
 #endif
+class EventDispatcher;
+class CommandExecutor;
+class Reactor;
+class OSCBundleProtocol;
+class OSCTimedReceiver;
+class OSCIngest;
+class NamespaceCache;
+class NamespaceHTTPServer;
+class Listing;
 
 //An object which controls the whole show
 class Controller {
@@ -58,6 +70,9 @@ class Controller {
 		//returns true until we should quit
 		bool processEvents();
 
+		//block until there is work for processEvents or the deadline passes
+		void waitForEvents(std::chrono::steady_clock::time_point deadline);
+
 		bool tryActivateAudio(bool startServer = true);
 
 	private:
@@ -69,21 +84,51 @@ class Controller {
 
 		void registerOSCMapping(bool doregister, const std::string& oscaddr, const std::string& localaddr);
 
+		void onTreeNodeChanged(const ossia::net::node_base&);
+		void onTreeNodeRenamed(const ossia::net::node_base&, const std::string&);
+		void onTreeParameterChanged(const ossia::net::parameter_base&);
+
+		//hash that allows std::string_view lookups in std::string keyed maps
+		struct StringHash {
+			using is_transparent = void;
+			size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+		};
+
+		//OSC addr -> resolved params, invalidated when the tree changes, only resolve from the controller thread
+		std::unique_ptr<OSCRouteCache> mOSCRouteCache;
+
 		//for OSC listeners (params and inports)
 		//OSC addr -> local addresss eg [/rnbo/inst/0/params/foo/normalized]
 		std::recursive_mutex mOSCMapMutex;
-		std::unordered_map<std::string, std::set<std::string>> mOSCToParam;
+		std::unordered_map<std::string, std::set<std::string>, StringHash, std::equal_to<>> mOSCToParam;
 		//for messages that call back from parameter updates into other parameter updates
-		Queue<std::pair<std::string, ossia::value>> mOSCMappedUpdateQueue;
+		//filled from the network between polls, a burst of mapped OSC can be large
+		Queue<std::pair<std::string, ossia::value>> mOSCMappedUpdateQueue{8192};
+		//for dispatchOSC calls made from event dispatcher workers, filled and drained within a single tick
+		Queue<std::pair<std::string, ossia::value>> mOSCDispatchQueue{8192};
+
+		//processes instance events in parallel
+		std::unique_ptr<EventDispatcher> mEventDispatcher;
 
 		void doLoadSet(SetInfo& setInfo, boost::optional<PendingPresetMap>& preset);
 
 		void reportActive();
 		void clearInstances(std::lock_guard<std::mutex>&, float fadeTime);
 		void unloadInstance(std::lock_guard<std::mutex>&, unsigned int index);
+		//stop an instance that has been taken out of the list and remove its subtree
+		void removeInstance(std::lock_guard<std::mutex>&, std::shared_ptr<Instance> inst, float fadeTime);
 
 		void registerCommands();
 		void processCommands();
+		//push a command for processCommands, answering it with an error if the queue is full
+		void queueCommand(std::string cmd);
+		//look up and run a command handler, reporting any exception as an error, may be called from a command worker
+		void runCommand(const std::string& method, const std::string& id, const RNBO::Json& params);
+		//run func now in the controller thread, or from a command worker, queue it for the controller thread
+		//the ossia tree is only changed and pushed into from there
+		void onController(std::function<void()> func);
+		//run what workers have queued with onController
+		void runControllerTasks();
 		void reportCommandResult(std::string id, RNBO::Json res);
 		void reportCommandError(std::string id, unsigned int code, std::string message);
 		void reportCommandStatus(std::string id, RNBO::Json obj, bool printerr = false);
@@ -93,7 +138,8 @@ class Controller {
 		void updateDatafileStats();
 		void updateListenersList();
 		void restoreListeners();
-		void listenersAddProtocol(const std::string& ip, uint16_t port);
+		void listenersAdd(const std::string& ip, uint16_t port, const RNBO::Json& options = RNBO::Json());
+		void updateListenersStats();
 
 		std::unordered_map<std::string, std::function<void(const std::string& method, const std::string& id, const RNBO::Json& params)>> mCommandHandlers;
 
@@ -138,7 +184,7 @@ class Controller {
 		//returns the backup name
 		std::string installPackage(const boost::filesystem::path& location, PackageInstallOptions options = {});
 
-		//guard by mInstanceMutex
+		//guard by mSetPresetPendingMutex
 		std::string mPendingSetPresetName;
 		std::set<unsigned int> mInstancesPendingPresetLoad;
 
@@ -150,7 +196,7 @@ class Controller {
 		std::shared_ptr<DB> mDB;
 		std::unique_ptr<ossia::net::generic_device> mServer;
 		std::shared_ptr<ossia::net::network_context> mOssiaContext;
-		ossia::net::multiplex_protocol * mProtocol;
+		ossia::net::multiplex_protocol * mProtocol; //owned by the DeferredPushProtocol the device owns
 		std::mutex mOssiaContextMutex;
 
 		ossia::net::node_base * mInstancesNode;
@@ -179,12 +225,14 @@ class Controller {
 		bool mSetNamesUpdated = false;
 		std::vector<ossia::value> mSetNames;
 		std::unordered_map<std::string, std::string> mSetUUIDs;
+		std::unique_ptr<Listing> mSetListing;
+		std::unique_ptr<Listing> mPatcherListing;
 
 		std::mutex mSetPresetNamesMutex;
 		bool mSetPresetNamesUpdated = false;
 		std::vector<ossia::value> mSetPresetNameValues;
 		std::set<std::string> mSetPresetNames;
-		bool mSetPresetSaved = false; //async from instances
+		std::atomic<bool> mSetPresetSaved = false; //async from instances
 
 		std::mutex mSetLoadPendingMutex;
 		boost::optional<SetInfo> mSetLoadPending;
@@ -193,7 +241,13 @@ class Controller {
 		ossia::net::parameter_base * mSetDirtyParam = nullptr;
 
 		//instance, path to SO, path to config
-		std::vector<std::tuple<std::shared_ptr<Instance>, boost::filesystem::path, boost::filesystem::path>> mInstances;
+		using InstanceList = std::vector<std::tuple<std::shared_ptr<Instance>, boost::filesystem::path, boost::filesystem::path>>;
+		//copy on write, readers iterate a snapshot without holding any lock while writers copy, modify and swap
+		std::shared_ptr<const InstanceList> instances();
+		//f should only add or remove entries, it runs with mInstanceListMutex held
+		void modifyInstances(std::function<void(InstanceList&)> f);
+		std::mutex mInstanceListMutex;
+		std::shared_ptr<const InstanceList> mInstances = std::make_shared<const InstanceList>();
 
 		std::vector<std::shared_ptr<Instance>> mStoppingInstances;
 		bool mResetPending = false;
@@ -210,26 +264,56 @@ class Controller {
 
 		std::chrono::duration<int> mDatafilePollPeriod = std::chrono::seconds(1);
 		std::chrono::time_point<std::chrono::steady_clock> mDatafilePollNext;
+		std::atomic<bool> mDatafileChanged = false; //set by file commands
 
 		std::shared_ptr<ProcessAudio> mProcessAudio;
 		ossia::net::parameter_base * mAudioActive;
+		//lock order: mInstanceMutex, mSetLoadPendingMutex, mBuildMutex, Instance::lockTree, then the leaf mutexes below
+		//guards the jack subtree, attaching and removing instance subtrees, stopping instances and update service setup
 		std::mutex mBuildMutex;
+		//serializes instance creation
 		std::mutex mInstanceMutex;
+		std::mutex mSetPresetPendingMutex;
+		std::mutex mSetViewsMutex; //mSetViewsListNode children
+		std::mutex mPatchersNodeMutex; //mPatchersNode children
 
 		//for saving/restoring while toggling audio settings
 		std::unordered_map<unsigned int, RNBO::UniquePresetPtr> mInstanceLastPreset;
 
-		Queue<std::string> mCommandQueue;
+		//commands are answered with an error when this is full, see queueCommand
+		Queue<std::string> mCommandQueue{1024};
+		std::unique_ptr<CommandExecutor> mCommandExecutor;
+		std::mutex mControllerTasksMutex;
+		std::vector<std::function<void()>> mControllerTasks; //in the order workers queued them
 
 		std::mutex mSaveMutex;
 		bool mSave = false;
 		//a timeout for when to save, debouncing
 		boost::optional<std::chrono::time_point<std::chrono::steady_clock>> mSaveNext;
 
-		boost::optional<std::chrono::time_point<std::chrono::steady_clock>> mProcessNext;
+		//wakes the main loop when there is work
+		std::unique_ptr<Reactor> mReactor;
+		std::unique_ptr<OSCTimedReceiver> mOSCTimedReceiver;
+		std::unique_ptr<OSCIngest> mOSCIngest;
+		std::atomic<bool> mOSCIngestRoutesInvalid = true;
+		void updateOSCIngestRoutes();
+		std::chrono::time_point<std::chrono::steady_clock> mWakeNext;
+		//polling and bookkeeping in processEvents is rate limited, wakes only drain queues before then
+		std::chrono::time_point<std::chrono::steady_clock> mProcessNext;
+		std::chrono::time_point<std::chrono::steady_clock> mBusyUntil;
+		bool mBuildingNodes = false; //instances are still adding deferred nodes
 
 		ossia::net::parameter_base * mListenersListParam = nullptr;
-		std::unordered_map<std::string, std::uintptr_t> mListenerProtocol; //map of host:port -> pointer so we can remove registrations
+		OSCBundleProtocol * mListenerOutput = nullptr; //owned by mProtocol, listeners are keyed by host:port
+		NamespaceCache * mNamespaceCache = nullptr; //owned by mProtocol
+		std::unique_ptr<NamespaceHTTPServer> mNamespaceServer;
+		size_t mListenerBundleMTU = 1400;
+		std::chrono::milliseconds mListenerFlushInterval;
+		std::chrono::time_point<std::chrono::steady_clock> mListenerFlushNext;
+		void flushListeners(std::chrono::steady_clock::time_point now);
+		ossia::net::parameter_base * mListenersStatsParam = nullptr;
+		std::string mListenersStatsLast;
+		std::chrono::time_point<std::chrono::steady_clock> mListenersStatsNext;
 
 		float mInstFadeInMs = 20.0f;
 		float mInstFadeOutMs = 20.0f;
@@ -8,6 +8,7 @@
 #include <regex>
 #include <set>
 #include <sstream>
+#include <thread>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
@@ -22,6 +23,7 @@
 #include <boost/uuid/uuid_io.hpp>
 
 #include <SQLiteCpp/Backup.h>
+#include <sqlite3.h>
 
 // https://srombauts.github.io/SQLiteCpp/
 
@@ -29,6 +31,7 @@ namespace fs = boost::filesystem;
 
 namespace {
 const std::regex auto_name_regex(R"(^_auto([0-9]+)$)");
+const int backup_step_pages = 64;
 
 std::string getStringColumn(SQLite::Statement &query, int col) {
   const char *s = query.getColumn(col);
@@ -144,6 +147,40 @@ void writePatchersParams(SQLite::Database &db, const int patcher_id,
   }
 }
 
+// SQLite transactions don't nest, join the one a DB::Batch has open instead of
+// starting another
+class Transaction {
+public:
+  Transaction(SQLite::Database &db)
+      : mDB(db), mOwn(sqlite3_get_autocommit(db.getHandle()) != 0) {
+    if (mOwn) {
+      mDB.exec("BEGIN");
+    }
+  }
+  ~Transaction() {
+    if (mOwn && !mCommitted) {
+      try {
+        mDB.exec("ROLLBACK");
+      } catch (...) {
+      }
+    }
+  }
+  Transaction(const Transaction &) = delete;
+  Transaction &operator=(const Transaction &) = delete;
+
+  void commit() {
+    if (mOwn) {
+      mDB.exec("COMMIT");
+    }
+    mCommitted = true;
+  }
+
+private:
+  SQLite::Database &mDB;
+  bool mOwn;
+  bool mCommitted = false;
+};
+
 std::string make_uuid() {
   static boost::uuids::random_generator gen;
   static std::mutex mtx;
@@ -220,7 +257,7 @@ DB::DB()
       };
 
       if (intransaction) {
-        SQLite::Transaction transaction(mDB);
+        Transaction transaction(mDB);
         func(mDB);
         incr();
         transaction.commit();
@@ -743,6 +780,11 @@ END;
     query.exec();
   });
 
+  // per listener budgets, filters and priorities
+  do_migration(22, [](SQLite::Database &db) {
+    db.exec("ALTER TABLE listeners ADD COLUMN options TEXT");
+  });
+
   // turn on foreign_keys support
   mDB.exec("PRAGMA foreign_keys=on");
   // clean up a bit
@@ -751,29 +793,38 @@ END;
 
 DB::~DB() {}
 
+DB::Batch::Batch(DB &db) : mLock(db.mMutex), mTransaction(db.mDB) {}
+
+void DB::Batch::commit() { mTransaction.commit(); }
+
 std::string DB::backup(std::string backupname) {
   backupname = backupname + ".sqlite";
   auto backuppath =
       config::get<fs::path>(config::key::BackupDir).get() / backupname;
 
-  {
-    std::lock_guard<std::mutex> guard(mMutex);
-    SQLite::Database backupDB(backuppath.string(),
-                              SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
-    SQLite::Backup backup(backupDB, mDB);
-    try {
-      backup.executeStep();
-    } catch (...) {
-      std::cerr << "failed to backup db to: " << backuppath.string()
-                << std::endl;
-      return "";
+  // copy a few pages at a time and let go of the database in between so a
+  // backup from a command worker doesn't hold up the controller thread, changes
+  // made through mDB in between are picked up by the backup
+  std::unique_lock<std::recursive_mutex> lock(mMutex);
+  SQLite::Database backupDB(backuppath.string(),
+                            SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+  SQLite::Backup backup(backupDB, mDB);
+  try {
+    while (backup.executeStep(backup_step_pages) != SQLITE_DONE) {
+      lock.unlock();
+      std::this_thread::yield();
+      lock.lock();
     }
+  } catch (...) {
+    std::cerr << "failed to backup db to: " << backuppath.string()
+              << std::endl;
+    return "";
   }
   return backupname;
 }
 
 void DB::rnboVersions(std::function<void(const std::string &)> f) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   SQLite::Statement query(
       mDB,
       "SELECT DISTINCT(runner_rnbo_version) FROM patchers ORDER BY id DESC");
@@ -785,7 +836,7 @@ void DB::rnboVersions(std::function<void(const std::string &)> f) {
 }
 
 boost::optional<std::string> DB::migrationDataAvailable() {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   SQLite::Statement query(
       mDB, "SELECT DISTINCT(rnbo_compat_version) FROM patchers WHERE "
            "rnbo_compat_version != ?1 AND rnbo_compat_version NOT IN (SELECT "
@@ -801,7 +852,7 @@ boost::optional<std::string> DB::migrationDataAvailable() {
 }
 
 void DB::markDataMigrated() {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   // mark all data migrated, no matter what the version is
   SQLite::Statement query(
       mDB, "INSERT OR IGNORE INTO data_migrations (data_rnbo_version, "
@@ -813,7 +864,7 @@ void DB::markDataMigrated() {
 
 bool DB::patcherLatestExistsWithUUID(const std::string &name,
                                      const std::string &uuid) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   SQLite::Statement query(
       mDB,
       "SELECT COUNT(*) FROM patchers WHERE uuid = ?3 AND id IN (SELECT MAX(id) "
@@ -830,7 +881,7 @@ bool DB::patcherLatestExistsWithUUID(const std::string &name,
 
 bool DB::setExistsWithUUID(const std::string &uuid) {
   // TODO should we check rnbo version??
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   SQLite::Statement query(mDB, "SELECT COUNT(*) from sets WHERE uuid = ?1");
   query.bind(1, uuid);
   if (query.executeStep()) {
@@ -847,9 +898,9 @@ void DB::patcherStore(const std::string &name, const fs::path &so_name,
                       int audio_inputs, int audio_outputs, int midi_inputs,
                       int midi_outputs, std::string uuid,
                       std::string runner_rnbo_version) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
-  SQLite::Transaction transaction(mDB);
+  Transaction transaction(mDB);
 
   int old_id = 0; // ids always start at 1 right?
   {
@@ -953,7 +1004,7 @@ bool DB::patcherGetLatest(const std::string &name, fs::path &so_name,
   if (rnbo_version.size() == 0)
     rnbo_version = runner::rnbo_compat_version;
 
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   SQLite::Statement query(
       mDB,
@@ -999,7 +1050,7 @@ void DB::patcherDestroy(
                        boost::filesystem::path &config_name)>
         f) {
   // TODO what about sets?
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   {
     SQLite::Statement query(
         mDB, "SELECT so_path, config_path FROM patchers WHERE name = ?1 AND "
@@ -1025,7 +1076,7 @@ void DB::patcherDestroy(
 }
 
 void DB::patcherRename(const std::string &name, std::string &newName) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   SQLite::Statement query(mDB, "UPDATE patchers SET name = ?3 WHERE name = ?1 "
                                "AND rnbo_compat_version = ?2");
@@ -1043,7 +1094,7 @@ void DB::patchers(std::function<void(const std::string &, int, int, int, int,
   if (rnbo_version.size() == 0)
     rnbo_version = runner::rnbo_compat_version;
 
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   SQLite::Statement query(mDB, R"(
 		SELECT name, audio_inputs, audio_outputs, midi_inputs, midi_outputs, datetime(created_at), uuid, runner_rnbo_version, rnbo_compat_version FROM patchers
@@ -1074,7 +1125,7 @@ void DB::presets(const std::string &patchername,
   if (rnbo_version.size() == 0)
     rnbo_version = runner::rnbo_compat_version;
 
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   SQLite::Statement query(mDB, R"(
 		SELECT name, initial, preset_index FROM presets
@@ -1099,7 +1150,7 @@ std::vector<int> DB::presetIndexes(const std::string &patchername,
     rnbo_version = runner::rnbo_compat_version;
 
   std::vector<int> indexes;
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   SQLite::Statement query(mDB, R"(
 		SELECT preset_index FROM presets
 		WHERE patcher_id IN (SELECT MAX(id) FROM patchers WHERE name = ?1 AND rnbo_compat_version = ?2 GROUP BY name)
@@ -1119,7 +1170,7 @@ DB::preset(const std::string &patchername, const std::string &presetName,
   if (rnbo_version.size() == 0)
     rnbo_version = runner::rnbo_compat_version;
 
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   SQLite::Statement query(mDB, R"(
 		SELECT content, name, preset_index FROM presets WHERE name = ?1 AND patcher_id IN
@@ -1145,7 +1196,7 @@ DB::preset(const std::string &patchername, const std::string &presetName,
 
 boost::optional<std::tuple<std::string, std::string, int>>
 DB::preset(const std::string &patchername, unsigned int index) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   SQLite::Statement query(mDB, R"(
 		SELECT content, name, preset_index FROM presets
@@ -1174,7 +1225,7 @@ DB::preset(const std::string &patchername, unsigned int index) {
 
 void DB::presetSave(const std::string &patchername, std::string presetName,
                     const std::string &preset, int index) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   // generate name
   if (presetName == "_auto") {
@@ -1242,7 +1293,7 @@ void DB::presetSave(const std::string &patchername, std::string presetName,
 
 void DB::presetSetInitial(const std::string &patchername,
                           const std::string &presetName) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   SQLite::Statement query(mDB, R"(
 		UPDATE presets
@@ -1260,7 +1311,7 @@ void DB::presetSetInitial(const std::string &patchername,
 
 void DB::presetRename(const std::string &patchername,
                       const std::string &oldName, const std::string &newName) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   {
     SQLite::Statement query(mDB, R"(
@@ -1307,7 +1358,7 @@ void DB::presetReindex(const std::string &patchername, const std::string &name,
     return;
   }
 
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   // delete any existing at that index that don't match this name
   {
     SQLite::Statement query(mDB, R"(
@@ -1344,7 +1395,7 @@ void DB::presetReindex(const std::string &patchername, const std::string &name,
 
 void DB::presetDestroy(const std::string &patchername,
                        const std::string &presetName) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   SQLite::Statement query(mDB, R"(
 		DELETE FROM presets
@@ -1362,7 +1413,7 @@ std::vector<std::string> DB::setPresets(const std::string &setname,
   if (rnbo_version.size() == 0)
     rnbo_version = runner::rnbo_compat_version;
 
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   std::vector<std::string> names;
 
   SQLite::Statement query(mDB, R"(
@@ -1384,7 +1435,7 @@ std::vector<int> DB::setPresetIndexes(const std::string &setName,
   if (rnbo_version.size() == 0)
     rnbo_version = runner::rnbo_compat_version;
 
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   std::vector<int> indexes;
 
   SQLite::Statement query(mDB, R"(
@@ -1401,7 +1452,7 @@ std::vector<int> DB::setPresetIndexes(const std::string &setName,
 }
 
 std::string DB::setPresetAutoNext(const std::string &setname) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   int max = 0;
 
   SQLite::Statement query(mDB, R"(
@@ -1430,7 +1481,7 @@ DB::setPresetNameByIndex(const std::string &setName, unsigned int index,
   if (rnbo_version.size() == 0)
     rnbo_version = runner::rnbo_compat_version;
 
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   SQLite::Statement query(mDB, R"(
 		SELECT DISTINCT name FROM sets_presets
@@ -1454,7 +1505,7 @@ boost::optional<int> DB::setPresetIndexByName(const std::string &setName,
   if (rnbo_version.size() == 0)
     rnbo_version = runner::rnbo_compat_version;
 
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   SQLite::Statement query(mDB, R"(
 		SELECT DISTINCT preset_index FROM sets_presets
 		WHERE set_id IN (SELECT MAX(id) FROM sets WHERE name = ?1 AND rnbo_compat_version = ?2 GROUP BY name)
@@ -1476,7 +1527,7 @@ int DB::setPresetIndexNext(const std::string &setName,
   if (rnbo_version.size() == 0)
     rnbo_version = runner::rnbo_compat_version;
 
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   SQLite::Statement query(mDB, R"(
 		SELECT MAX(preset_index) + 1 FROM sets_presets
 		WHERE set_id IN (SELECT MAX(id) FROM sets WHERE name = ?1 AND rnbo_compat_version = ?2 GROUP BY name)
@@ -1499,7 +1550,7 @@ void DB::setPresets(
   if (rnbo_version.size() == 0)
     rnbo_version = runner::rnbo_compat_version;
 
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   SQLite::Statement query(mDB, R"(
 		SELECT patchers.name, sets_presets.set_instance_index, COALESCE(presets.content, sets_presets.content), COALESCE(presets.name, "") as preset_name, sets_presets.preset_index
@@ -1536,7 +1587,7 @@ DB::setPreset(const std::string &patchername, const std::string &presetName,
               std::string rnbo_version) {
   if (rnbo_version.size() == 0)
     rnbo_version = runner::rnbo_compat_version;
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   SQLite::Statement query(mDB, R"(
 		SELECT COALESCE(presets.content, sets_presets.content), COALESCE(sets_presets.preset_name, "") FROM sets_presets
@@ -1579,7 +1630,7 @@ void DB::setPresetSave(const std::string &patchername,
                        const std::string &setName, unsigned int instanceIndex,
                        const std::string &content,
                        std::string patcherPresetName, int presetIndex) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   SQLite::Statement query(mDB, R"(
 		INSERT INTO sets_presets (patcher_id, set_id, name, set_instance_index, content, preset_name, preset_index)
@@ -1615,7 +1666,7 @@ void DB::setPresetRename(const std::string &setName, const std::string &oldName,
 
   if (rnbo_version.size() == 0)
     rnbo_version = runner::rnbo_compat_version;
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   SQLite::Statement query(mDB, R"(
 		UPDATE sets_presets SET name = ?3
@@ -1635,7 +1686,7 @@ void DB::setPresetReindex(const std::string &setName, const std::string &name,
                           int presetindex, std::string rnbo_version) {
   if (rnbo_version.size() == 0)
     rnbo_version = runner::rnbo_compat_version;
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   // delete existing
   {
@@ -1675,7 +1726,7 @@ void DB::setPresetDestroy(const std::string &setName,
                           std::string rnbo_version) {
   if (rnbo_version.size() == 0)
     rnbo_version = runner::rnbo_compat_version;
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   SQLite::Statement query(mDB, R"(
 		DELETE FROM sets_presets
@@ -1694,7 +1745,7 @@ void DB::setPresetDestroyAll(const std::string &setName,
                              std::string rnbo_version) {
   if (rnbo_version.size() == 0)
     rnbo_version = runner::rnbo_compat_version;
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   SQLite::Statement query(mDB, R"(
 		DELETE FROM sets_presets
@@ -1709,14 +1760,14 @@ void DB::setPresetDestroyAll(const std::string &setName,
 }
 
 void DB::setSave(const std::string &name, const SetInfo &info) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   std::string runner_rnbo_version = info.runner_rnbo_version;
   if (runner_rnbo_version.size() == 0) {
     runner_rnbo_version = runner::rnbo_version;
   }
 
-  SQLite::Transaction transaction(mDB);
+  Transaction transaction(mDB);
 
   // only 1 set per name per version, simply update if one exists already
   int64_t id = 0;
@@ -1825,7 +1876,7 @@ boost::optional<SetInfo> DB::setGet(const std::string &name,
   if (rnbo_version.size() == 0)
     rnbo_version = runner::rnbo_compat_version;
 
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   int64_t set_id = 0;
   SetInfo info;
@@ -1919,7 +1970,7 @@ boost::optional<SetInfo> DB::setGet(const std::string &name,
 bool DB::setDestroy(const std::string &name) {
   // presets get deleted because of on delete cascade
   {
-    std::lock_guard<std::mutex> guard(mMutex);
+    std::lock_guard<std::recursive_mutex> guard(mMutex);
     SQLite::Statement query(
         mDB, "DELETE FROM sets WHERE name=?1 AND rnbo_compat_version=?2");
     query.bind(1, name);
@@ -1931,8 +1982,8 @@ bool DB::setDestroy(const std::string &name) {
 bool DB::setInitial(const std::string &name) {
   // TODO can we do this in a single statement?
   {
-    std::lock_guard<std::mutex> guard(mMutex); // setNameInitial also grabs
-                                               // mutex
+    // setNameInitial also grabs mutex
+    std::lock_guard<std::recursive_mutex> guard(mMutex);
     SQLite::Statement query(mDB,
                             "UPDATE sets SET initial = CASE WHEN name == ?1 "
                             "THEN 1 ELSE 0 END WHERE rnbo_compat_version=?2");
@@ -1946,7 +1997,7 @@ bool DB::setInitial(const std::string &name) {
 }
 
 bool DB::setRename(const std::string &oldName, const std::string &newName) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   {
     SQLite::Statement query(mDB, "UPDATE OR IGNORE sets SET name=?3 WHERE "
@@ -1961,7 +2012,7 @@ bool DB::setRename(const std::string &oldName, const std::string &newName) {
 bool DB::setMatchesConnections(
     const std::string &name, const std::vector<std::string> &source,
     const std::vector<std::vector<std::string>> &dest) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   int setid = getsetid(mDB, name);
 
   std::set<std::string> destset;
@@ -2011,7 +2062,7 @@ boost::optional<std::string> DB::setNameInitial(std::string rnbo_version) {
   if (rnbo_version.size() == 0)
     rnbo_version = runner::rnbo_compat_version;
 
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   SQLite::Statement query(mDB,
                           "SELECT name FROM sets WHERE rnbo_compat_version = "
                           "?1 AND initial = 1 ORDER BY name ASC LIMIT 1");
@@ -2029,7 +2080,7 @@ boost::optional<std::string> DB::setNameByIndex(unsigned int index,
   if (rnbo_version.size() == 0)
     rnbo_version = runner::rnbo_compat_version;
 
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   SQLite::Statement query(mDB,
                           "SELECT name FROM sets WHERE rnbo_compat_version = "
                           "?1 ORDER BY name ASC LIMIT 1 OFFSET ?2");
@@ -2050,7 +2101,7 @@ void DB::sets(
   if (rnbo_version.size() == 0)
     rnbo_version = runner::rnbo_compat_version;
 
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   SQLite::Statement query(mDB, R"(
 		SELECT name, datetime(created_at), initial, uuid FROM sets
@@ -2073,7 +2124,7 @@ std::vector<int> DB::setViewIndexes(const std::string &setName,
   if (rnbo_version.size() == 0)
     rnbo_version = runner::rnbo_compat_version;
 
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   SQLite::Statement query(mDB, R"(
 		SELECT view_index FROM sets_views
 		WHERE set_id IN (SELECT MAX(id) FROM sets WHERE name = ?1 AND rnbo_compat_version = ?2 GROUP BY name)
@@ -2091,7 +2142,7 @@ std::vector<int> DB::setViewIndexes(const std::string &setName,
 boost::optional<std::tuple<std::string, std::vector<std::string>, int>>
 DB::setViewGet(const std::string &setname, int viewIndex,
                std::string rnbo_version) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   if (rnbo_version.size() == 0)
     rnbo_version = runner::rnbo_compat_version;
 
@@ -2140,11 +2191,11 @@ int DB::setViewCreate(const std::string &setname, const std::string &viewname,
                       const std::vector<ViewParam> params, int viewIndex) {
   int set_id = 0;
   {
-    std::lock_guard<std::mutex> guard(mMutex);
+    std::lock_guard<std::recursive_mutex> guard(mMutex);
     set_id = getsetid(mDB, setname);
   }
   if (viewIndex < 0) {
-    std::lock_guard<std::mutex> guard(mMutex);
+    std::lock_guard<std::recursive_mutex> guard(mMutex);
     SQLite::Statement query(
         mDB, "SELECT MAX(view_index) + 1 FROM sets_views WHERE set_id = ?1");
     query.bind(1, set_id);
@@ -2157,7 +2208,7 @@ int DB::setViewCreate(const std::string &setname, const std::string &viewname,
   }
 
   {
-    std::lock_guard<std::mutex> guard(mMutex);
+    std::lock_guard<std::recursive_mutex> guard(mMutex);
 
     SQLite::Statement query(mDB, R"(
 			INSERT INTO sets_views (set_id, view_index, params, name)
@@ -2172,7 +2223,7 @@ int DB::setViewCreate(const std::string &setname, const std::string &viewname,
 
   int set_view_id = mDB.getLastInsertRowid();
   {
-    std::lock_guard<std::mutex> guard(mMutex);
+    std::lock_guard<std::recursive_mutex> guard(mMutex);
     insertSetViewParams(mDB, set_id, set_view_id, params);
   }
 
@@ -2180,7 +2231,7 @@ int DB::setViewCreate(const std::string &setname, const std::string &viewname,
 }
 
 void DB::setViewDestroy(const std::string &setname, int viewIndex) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   if (viewIndex < 0) {
     SQLite::Statement query(mDB, R"(
 			DELETE FROM sets_views
@@ -2204,7 +2255,7 @@ void DB::setViewDestroy(const std::string &setname, int viewIndex) {
 
 void DB::setViewUpdateParams(const std::string &setname, int viewIndex,
                              const std::vector<ViewParam> params) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
 
   int set_id = getsetid(mDB, setname);
   if (set_id < 1)
@@ -2214,7 +2265,7 @@ void DB::setViewUpdateParams(const std::string &setname, int viewIndex,
   if (set_view_id < 1)
     return;
 
-  SQLite::Transaction transaction(mDB);
+  Transaction transaction(mDB);
   SQLite::Statement query(
       mDB, "DELETE FROM sets_views_params WHERE set_view_id = ?1");
   query.bind(1, set_view_id);
@@ -2226,7 +2277,7 @@ void DB::setViewUpdateParams(const std::string &setname, int viewIndex,
 
 void DB::setViewUpdateName(const std::string &setname, int viewIndex,
                            const std::string &name) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   SQLite::Statement query(mDB, R"(
 		UPDATE sets_views
 		SET name = ?4
@@ -2243,7 +2294,7 @@ void DB::setViewUpdateName(const std::string &setname, int viewIndex,
 
 bool DB::setViewsUpdateSortOrder(const std::string &setname,
                                  std::vector<int> &indexes) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   int setid = getsetid(mDB, setname);
   if (setid > 0) {
     std::vector<std::string> orderings;
@@ -2308,7 +2359,7 @@ bool DB::setViewsUpdateSortOrder(const std::string &setname,
 
 void DB::setViewsCopy(const std::string &srcSetName,
                       const std::string &dstSetName) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   int srcid = getsetid(mDB, srcSetName);
   int dstid = getsetid(mDB, dstSetName);
   if (srcid > 0 && dstid > 0) {
@@ -2346,7 +2397,7 @@ void DB::setViewsCopy(const std::string &srcSetName,
 }
 
 bool DB::listenerExists(const std::string &ip, uint16_t port) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   SQLite::Statement query(
       mDB, "SELECT COUNT(*) from listeners WHERE ip = ?1 AND port = ?2");
   query.bind(1, ip);
@@ -2358,18 +2409,36 @@ bool DB::listenerExists(const std::string &ip, uint16_t port) {
   return false;
 }
 
-bool DB::listenersAdd(const std::string &ip, uint16_t port) {
-  std::lock_guard<std::mutex> guard(mMutex);
+bool DB::listenersAdd(const std::string &ip, uint16_t port,
+                      const std::string &options) {
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   SQLite::Statement query(
-      mDB, "INSERT OR IGNORE INTO listeners (ip, port) VALUES (?1, ?2)");
+      mDB,
+      "INSERT OR IGNORE INTO listeners (ip, port, options) VALUES (?1, ?2, ?3)");
   query.bind(1, ip);
   query.bind(2, port);
+  if (options.size()) {
+    query.bind(3, options);
+  } else {
+    query.bind(3);
+  }
   query.exec();
   return mDB.getChanges() != 0;
 }
 
+void DB::listenersSetOptions(const std::string &ip, uint16_t port,
+                             const std::string &options) {
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
+  SQLite::Statement query(
+      mDB, "UPDATE listeners SET options = ?3 WHERE ip = ?1 AND port = ?2");
+  query.bind(1, ip);
+  query.bind(2, port);
+  query.bind(3, options);
+  query.exec();
+}
+
 bool DB::listenersDel(const std::string &ip, uint16_t port) {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   SQLite::Statement query(mDB,
                           "DELETE FROM listeners where ip = ?1 AND port = ?2");
   query.bind(1, ip);
@@ -2379,21 +2448,27 @@ bool DB::listenersDel(const std::string &ip, uint16_t port) {
 }
 
 void DB::listenersClear() {
-  std::lock_guard<std::mutex> guard(mMutex);
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
   mDB.exec("DELETE FROM listeners");
 }
 
-void DB::listeners(
-    std::function<void(const std::string &ip, uint16_t port)> func) {
-  std::lock_guard<std::mutex> guard(mMutex);
-  SQLite::Statement query(mDB, "SELECT ip, port FROM listeners");
+void DB::listeners(std::function<void(const std::string &ip, uint16_t port,
+                                        const std::string &options)>
+                       func) {
+  std::lock_guard<std::recursive_mutex> guard(mMutex);
+  SQLite::Statement query(mDB, "SELECT ip, port, options FROM listeners");
   while (query.executeStep()) {
     const char *s = query.getColumn(0);
     std::string ip(s);
 
     int port = query.getColumn(1);
 
-    func(ip, static_cast<uint16_t>(port));
+    std::string options;
+    if (!query.getColumn(2).isNull()) {
+      options = query.getColumn(2).getString();
+    }
+
+    func(ip, static_cast<uint16_t>(port), options);
   }
 }
 
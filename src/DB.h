@@ -80,7 +80,21 @@ class DB {
 		DB();
 		~DB();
 
+		//while in scope, everything the calling thread does with the database is a single transaction
+		//that is rolled back unless committed, other threads wait until it is done
+		//only take one in the controller thread, the main loop and instance callbacks use the database from there
+		//and would stall behind a command worker holding it, everything else holds the lock for a single call
+		class Batch {
+			public:
+				Batch(DB& db);
+				void commit();
+			private:
+				std::unique_lock<std::recursive_mutex> mLock;
+				SQLite::Transaction mTransaction;
+		};
+
 		//returns actual file name used on success
+		//copies in steps, letting other threads in between
 		std::string backup(std::string backupName);
 
 		//get the RNBO versions from DB
@@ -315,12 +329,14 @@ class DB {
 
 		bool listenerExists(const std::string& ip, uint16_t port);
 		//returns true if anything happened
-		bool listenersAdd(const std::string& ip, uint16_t port);
+		bool listenersAdd(const std::string& ip, uint16_t port, const std::string& options = std::string());
 		bool listenersDel(const std::string& ip, uint16_t port);
 		void listenersClear();
-		void listeners(std::function<void(const std::string& ip, uint16_t port)> func);
+		//options is a JSON string, empty if none have been set
+		void listenersSetOptions(const std::string& ip, uint16_t port, const std::string& options);
+		void listeners(std::function<void(const std::string& ip, uint16_t port, const std::string& options)> func);
 
 	private:
 		SQLite::Database mDB;
-		std::mutex mMutex;
+		std::recursive_mutex mMutex; //recursive so a Batch can hold it across calls
 };
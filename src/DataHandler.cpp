@@ -251,22 +251,22 @@ class DataLoadJobQueue {
 		};
 
 		void queue(std::shared_ptr<RunnerExternalDataHandler> handler, const std::string& datarefId, const fs::path& filePath) {
-			mJobs.push(Job(handler, datarefId, filePath));
+			if (!mJobs.push(Job(handler, datarefId, filePath))) {
+				std::cerr << "data load queue full, dropping load of " << datarefId << std::endl;
+			}
 		}
 
 		void work() {
 			while (mDoWork) {
-				if (auto j = mJobs.tryPop()) {
+				if (auto j = mJobs.popTimeout(std::chrono::milliseconds(100))) {
 					j->dowork();
-				} else {
-					std::this_thread::sleep_for(std::chrono::milliseconds(10));
 				}
 			}
 		}
 
 	private:
-		bool mDoWork = true;
-		Queue<Job> mJobs;
+		std::atomic<bool> mDoWork = true;
+		Queue<Job> mJobs{1024}; //shared by every instance, sets can load a file into every dataref at once
 		std::vector<std::thread> mWorkers;
 };
 
@@ -383,7 +383,10 @@ RunnerExternalDataHandler::RunnerExternalDataHandler(const std::vector<std::stri
 	mMapRequest(datarefIds.size()),
 	mMapResponse(datarefIds.size()),
 	mInfoRequest(datarefIds.size()),
-	mInfoResponse(datarefIds.size())
+	mInfoResponse(datarefIds.size()),
+	//a change and a load for each dataref can be in flight between drains
+	mSharedRefChanged(datarefIds.size() * 2 + 16),
+	mDataLoad(datarefIds.size() * 4 + 16)
 {
 	mDataLoader = DataLoadJobQueue::Get();
 
@@ -640,6 +643,9 @@ void RunnerExternalDataHandler::processEvents(std::unordered_map<std::string, os
 			}
 		}
 	}
+	if (auto dropped = mSharedRefChanged.overflowed()) {
+		std::cerr << "shared dataref change queue full, dropped " << dropped << " changes" << std::endl;
+	}
 	{
 		while (auto c = mSharedRefChanged.tryPop()) {
 			auto [key, shared] = c.get();
@@ -749,6 +755,9 @@ void RunnerExternalDataHandler::processEvents(std::unordered_map<std::string, os
 			}
 		}
 	}
+	if (auto dropped = mDataLoad.overflowed()) {
+		std::cerr << "dataref load queue full, dropped " << dropped << " loads" << std::endl;
+	}
 	{
 		while (auto c = mDataLoad.tryPop()) {
 			std::unique_lock<std::mutex> lock(mMutex);
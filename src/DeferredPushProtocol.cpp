@@ -0,0 +1,65 @@
+#include "DeferredPushProtocol.h"
+
+#include <ossia/network/base/device.hpp>
+#include <ossia/network/base/node.hpp>
+#include <ossia/network/base/parameter.hpp>
+
+namespace {
+	thread_local DeferredPushProtocol::Pushes * tCapture = nullptr;
+}
+
+DeferredPushProtocol::Capture::Capture(Pushes& pushes) : mPrevious(tCapture) {
+	tCapture = &pushes;
+}
+
+DeferredPushProtocol::Capture::~Capture() {
+	tCapture = mPrevious;
+}
+
+void DeferredPushProtocol::publish(Pushes& pushes) {
+	for (auto& p: pushes) {
+		p.first->get_node().get_device().get_protocol().push(*p.first, p.second);
+	}
+	pushes.clear();
+}
+
+DeferredPushProtocol::DeferredPushProtocol(std::unique_ptr<ossia::net::protocol_base> inner) :
+	protocol_base(flags{}),
+	mInner(std::move(inner))
+{
+}
+
+DeferredPushProtocol::~DeferredPushProtocol() { }
+
+bool DeferredPushProtocol::pull(ossia::net::parameter_base& param) {
+	return mInner->pull(param);
+}
+
+bool DeferredPushProtocol::push(const ossia::net::parameter_base& param, const ossia::value& v) {
+	if (tCapture) {
+		tCapture->emplace_back(&param, v);
+		return true;
+	}
+	return mInner->push(param, v);
+}
+
+//raw pushes have no parameter to hold on to, threads that capture must route them elsewhere
+bool DeferredPushProtocol::push_raw(const ossia::net::full_parameter_data& param) {
+	return mInner->push_raw(param);
+}
+
+bool DeferredPushProtocol::echo_incoming_message(const ossia::net::message_origin_identifier& id, const ossia::net::parameter_base& param, const ossia::value& v) {
+	return mInner->echo_incoming_message(id, param, v);
+}
+
+bool DeferredPushProtocol::observe(ossia::net::parameter_base& param, bool enable) {
+	return mInner->observe(param, enable);
+}
+
+bool DeferredPushProtocol::update(ossia::net::node_base& node_base) {
+	return mInner->update(node_base);
+}
+
+void DeferredPushProtocol::set_device(ossia::net::device_base& dev) {
+	mInner->set_device(dev);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <ossia/network/base/protocol.hpp>
+#include <ossia/network/value/value.hpp>
+
+//sits between the device and the protocol that does the actual work, usually a multiplex protocol
+//the protocols behind it aren't safe to push into from several threads at once, so threads that
+//run in parallel, like the instance event dispatcher workers, capture their pushes and the thread
+//that owns the tree publishes them afterwards
+class DeferredPushProtocol : public ossia::net::protocol_base {
+	public:
+		using Pushes = std::vector<std::pair<const ossia::net::parameter_base *, ossia::value>>;
+
+		//while in scope, pushes made in this thread are appended to pushes instead of being sent
+		class Capture {
+			public:
+				Capture(Pushes& pushes);
+				~Capture();
+				Capture(const Capture&) = delete;
+				Capture& operator=(const Capture&) = delete;
+			private:
+				Pushes * mPrevious;
+		};
+
+		//send captured pushes, in order, and clear them
+		//call from a thread that isn't capturing, with whatever lock keeps the parameters alive
+		static void publish(Pushes& pushes);
+
+		DeferredPushProtocol(std::unique_ptr<ossia::net::protocol_base> inner);
+		virtual ~DeferredPushProtocol();
+
+		DeferredPushProtocol(const DeferredPushProtocol&) = delete;
+		DeferredPushProtocol& operator=(const DeferredPushProtocol&) = delete;
+
+		virtual bool pull(ossia::net::parameter_base& param) override;
+		virtual bool push(const ossia::net::parameter_base& param, const ossia::value& v) override;
+		virtual bool push_raw(const ossia::net::full_parameter_data& param) override;
+		virtual bool echo_incoming_message(const ossia::net::message_origin_identifier& id, const ossia::net::parameter_base& param, const ossia::value& v) override;
+		virtual bool observe(ossia::net::parameter_base& param, bool enable) override;
+		virtual bool update(ossia::net::node_base& node_base) override;
+		virtual void set_device(ossia::net::device_base& dev) override;
+	private:
+		std::unique_ptr<ossia::net::protocol_base> mInner;
+};
@@ -81,6 +81,17 @@ enum class InstallProgramError : unsigned int {
 	NotEnabled = 2,
 };
 
+enum class CommandError : unsigned int {
+	Unknown = 0,
+	QueueFull = 1,
+};
+
+enum class BatchCommandError : unsigned int {
+	Unknown = 0,
+	InvalidRequestObject = 1,
+	CommandFailed = 2,
+};
+
 struct ProgramChange {
 	uint8_t chan = 0;
 	uint8_t prog = 0;
@@ -0,0 +1,88 @@
+#include "EventDispatcher.h"
+
+#include <iostream>
+#include <algorithm>
+
+namespace {
+	thread_local bool tOnWorker = false;
+	const unsigned int max_auto_workers = 4;
+}
+
+EventDispatcher::EventDispatcher(unsigned int workers) {
+	if (workers == 0) {
+		workers = std::min(std::max(std::thread::hardware_concurrency(), 1u), max_auto_workers);
+	}
+	//a single worker would just add a context switch
+	if (workers > 1) {
+		mJobs.resize(workers);
+		for (size_t i = 0; i < workers; i++) {
+			mThreads.emplace_back(&EventDispatcher::work, this, i);
+		}
+	}
+}
+
+EventDispatcher::~EventDispatcher() {
+	{
+		std::lock_guard<std::mutex> guard(mMutex);
+		mQuit = true;
+	}
+	mStartCondition.notify_all();
+	for (auto& t: mThreads) {
+		t.join();
+	}
+}
+
+bool EventDispatcher::onWorker() {
+	return tOnWorker;
+}
+
+void EventDispatcher::run(const std::vector<std::pair<unsigned int, std::function<void()>>>& jobs) {
+	if (mThreads.empty() || jobs.size() < 2) {
+		for (auto& j: jobs) {
+			j.second();
+		}
+		return;
+	}
+
+	for (auto& j: mJobs) {
+		j.clear();
+	}
+	for (auto& j: jobs) {
+		mJobs[j.first % mJobs.size()].push_back(&j.second);
+	}
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mPending = mThreads.size();
+	mGeneration++;
+	mStartCondition.notify_all();
+	mDoneCondition.wait(lock, [this] { return mPending == 0; });
+}
+
+void EventDispatcher::work(size_t index) {
+	tOnWorker = true;
+	uint64_t generation = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mStartCondition.wait(lock, [this, generation] { return mQuit || mGeneration != generation; });
+			if (mQuit) {
+				return;
+			}
+			generation = mGeneration;
+		}
+
+		for (auto j: mJobs[index]) {
+			try {
+				(*j)();
+			} catch (const std::exception& e) {
+				std::cerr << "exception in event dispatcher worker " << e.what() << std::endl;
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> guard(mMutex);
+			mPending--;
+		}
+		mDoneCondition.notify_one();
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+//runs batches of keyed jobs across a fixed pool of worker threads
+//jobs with the same key always run on the same worker, in the order they were given
+class EventDispatcher {
+	public:
+		//0 picks a count based on the hardware, 1 runs everything in the calling thread
+		EventDispatcher(unsigned int workers);
+		~EventDispatcher();
+
+		//run all the jobs, blocks until every one has completed
+		void run(const std::vector<std::pair<unsigned int, std::function<void()>>>& jobs);
+
+		//is the calling thread one of the dispatcher's workers
+		static bool onWorker();
+	private:
+		void work(size_t index);
+
+		std::vector<std::thread> mThreads;
+		std::vector<std::vector<const std::function<void()> *>> mJobs; //per worker, only touched outside of a run by the caller
+
+		std::mutex mMutex;
+		std::condition_variable mStartCondition;
+		std::condition_variable mDoneCondition;
+		uint64_t mGeneration = 0;
+		size_t mPending = 0;
+		bool mQuit = false;
+};
@@ -1,4 +1,5 @@
 #include "EventHandler.h"
+#include "Reactor.h"
 
 EventHandler::EventHandler(
 		ParameterEventCallback paramCallback,
@@ -28,7 +29,8 @@ void EventHandler::processEvents() {
 }
 
 void EventHandler::eventsAvailable() {
-	//TODO
+	//called from the audio thread, wake the main loop so it drains events
+	Reactor::wake();
 }
 
 void EventHandler::handlePresetEvent(const RNBO::PresetEvent& event) {
@@ -1,6 +1,8 @@
 #include <memory>
 #include <iostream>
 #include <functional>
+#include <algorithm>
+#include <cmath>
 
 #include <sndfile.hh>
 #include <readerwriterqueue/readerwriterqueue.h>
@@ -22,6 +24,10 @@
 #include "PatcherFactory.h"
 #include "DataHandler.h"
 #include "Util.h"
+#include "ParamBatch.h"
+#include "ShmControl.h"
+#include "EventDispatcher.h"
+#include "QuietTreeChanges.h"
 
 using RNBO::ParameterIndex;
 using RNBO::ParameterInfo;
@@ -33,6 +39,10 @@ namespace fs = boost::filesystem;
 
 namespace {
 	static const std::chrono::milliseconds command_wait_timeout(10);
+	static const std::chrono::milliseconds suppressed_report_period(1000);
+	static const std::chrono::milliseconds ingest_mirror_period(50);
+	//time given to deferred node creation each time control events are processed
+	static const std::chrono::microseconds deferred_node_budget(2000);
 	static const std::string initial_preset_key = "preset_initial";
 	static const std::string last_preset_key = "preset_last";
 	static const std::string preset_midi_channel_key = "preset_midi_channel";
@@ -111,6 +121,41 @@ namespace {
 		m->set(ossia::net::access_mode_attribute{}, ossia::access_mode::BI);
 		return std::make_pair(m, p);
 	}
+
+	//keys currently being updated in this thread, innermost last
+	thread_local std::vector<const void *> tActiveUpdates;
+
+	//tracks a key for the lifetime of the guard, evaluates false if this thread is already updating that key
+	//updates from other threads are never suppressed, only recursion within a thread
+	class ReentrancyGuard {
+		public:
+			ReentrancyGuard(const void * key, std::atomic<uint64_t>& suppressed) {
+				mEntered = std::find(tActiveUpdates.begin(), tActiveUpdates.end(), key) == tActiveUpdates.end();
+				if (mEntered) {
+					tActiveUpdates.push_back(key);
+				} else {
+					suppressed.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+			~ReentrancyGuard() {
+				if (mEntered) {
+					tActiveUpdates.pop_back();
+				}
+			}
+			ReentrancyGuard(const ReentrancyGuard&) = delete;
+			ReentrancyGuard& operator=(const ReentrancyGuard&) = delete;
+			explicit operator bool() const { return mEntered; }
+		private:
+			bool mEntered;
+	};
+
+	//wall clock time OSC updates in this thread should be scheduled for, if any
+	thread_local boost::optional<std::chrono::system_clock::time_point> tScheduledAt;
+
+	//the RNBO clock only advances per audio period so samples of the offset lag, this decides how fast we follow them down
+	const double clock_offset_smoothing = 0.01;
+	//jumps larger than this (audio restarted, wall clock changed) reset the offset
+	const double clock_offset_reset_ms = 250.0;
 }
 
 Instance::Instance(
@@ -199,6 +244,7 @@ Instance::Instance(
 				midiCallback));
 	mCore = std::make_shared<RNBO::CoreObject>(mPatcherFactory->createInstance());
 	mParamInterface = mCore->createParameterInterface(RNBO::ParameterEventInterface::MultiProducer, mEventHandler.get());
+	mIngestTarget = std::make_shared<OSCIngestTarget>(mCore, mCore->getNumParameters());
 
 
 	std::string audioName = name + "-" + std::to_string(mIndex);
@@ -222,6 +268,18 @@ Instance::Instance(
 
 	mPresetSaveQueue = RNBO::make_unique<moodycamel::ReaderWriterQueue<std::tuple<std::string, RNBO::ConstPresetPtr, std::string, int>, 32>>(32);
 
+	//every parameter, port and dataref queues a meta update while we build, none are drained until we're attached
+	//after that clients can set each of them again between drains
+	{
+		size_t entries = mCore->getNumParameters() + mCore->getNumExternalDataRefs();
+		for (auto key: {"inports", "outports"}) {
+			if (conf.contains(key) && conf[key].is_array()) {
+				entries += conf[key].size();
+			}
+		}
+		mMetaUpdateQueue = std::make_unique<Queue<MetaUpdateCommand>>(entries * 2 + 16);
+	}
+
 	mDB->presets(mName, [this](const std::string& name, bool initial, int /*presetindex*/) {
 			if (initial) {
 				mPresetInitial = name;
@@ -244,6 +302,77 @@ Instance::Instance(
 			p->push_value(conf["name"].get<std::string>());
 		}
 
+		//diagnostics
+		auto infoNode = root->create_child("info");
+		{
+			auto n = infoNode->create_child("suppressed_param_updates");
+			auto p = mSuppressedParamUpdatesParam = n->create_parameter(ossia::val_type::INT);
+			n->set(ossia::net::description_attribute{}, "Count of parameter updates suppressed to avoid feedback recursion");
+			n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+			p->push_value(0);
+
+			n = infoNode->create_child("late_osc_events");
+			p = mLateOSCEventsParam = n->create_parameter(ossia::val_type::INT);
+			n->set(ossia::net::description_attribute{}, "Count of timetagged OSC events that arrived after their scheduled time and were applied immediately");
+			n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+			p->push_value(0);
+		}
+
+		//opt in, rate limited stream of all normalized parameter values
+		{
+			auto snapshot = root->create_child("snapshot");
+			snapshot->set(ossia::net::description_attribute{}, "Compact stream of all normalized parameter values");
+
+			{
+				auto n = snapshot->create_child("enable");
+				auto p = n->create_parameter(ossia::val_type::BOOL);
+				n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::BI);
+				n->set(ossia::net::description_attribute{}, "Enable publishing parameter snapshots");
+				p->push_value(false);
+				p->add_callback([this](const ossia::value& v) {
+					if (v.get_type() == ossia::val_type::BOOL) {
+						mSnapshotEnabled = v.get<bool>();
+						//publish everything on the first snapshot
+						mSnapshotFull = true;
+					}
+				});
+			}
+
+			{
+				auto n = snapshot->create_child("rate");
+				auto p = n->create_parameter(ossia::val_type::FLOAT);
+				n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::BI);
+				n->set(ossia::net::domain_attribute{}, ossia::make_domain(1.0f, 100.0f));
+				n->set(ossia::net::bounding_mode_attribute{}, ossia::bounding_mode::CLIP);
+				n->set(ossia::net::description_attribute{}, "Snapshot publish rate in Hz");
+				p->push_value(30.0f);
+				p->add_callback([this](const ossia::value& v) {
+					if (v.get_type() == ossia::val_type::FLOAT) {
+						auto hz = std::clamp(v.get<float>(), 1.0f, 100.0f);
+						mSnapshotPeriod = std::chrono::microseconds(static_cast<int64_t>(1e6 / hz));
+					}
+				});
+			}
+
+			{
+				auto n = snapshot->create_child("count");
+				auto p = n->create_parameter(ossia::val_type::INT);
+				n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+				n->set(ossia::net::description_attribute{}, "Number of values in each snapshot, one per RNBO parameter index");
+				p->push_value(static_cast<int>(mCore->getNumParameters()));
+			}
+
+			{
+				//a list rather than a packed string: ossia sends strings as NUL terminated OSC strings (and JSON text)
+				//so the zero bytes in packed words would truncate it, incoming blobs only become strings one way
+				//OSC still encodes the list as packed 4 byte words, plus one type tag byte per value
+				auto n = snapshot->create_child("data");
+				mSnapshotParam = n->create_parameter(ossia::val_type::LIST);
+				n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+				n->set(ossia::net::description_attribute{}, "ceil(count / 32) int32 dirty bitmask words (bit i of word w set if index w * 32 + i changed), followed by count float32 normalized values ordered by parameter index");
+			}
+		}
+
 		//oscquery based configuration
 		{
 			auto config = root->create_child("config");
@@ -355,6 +484,21 @@ Instance::Instance(
 		}
 
 		params->set(ossia::net::description_attribute{}, "Parameter get/set");
+		{
+			auto n = root->create_child("params_set");
+			auto p = n->create_parameter(ossia::val_type::LIST);
+			n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::SET);
+			n->set(ossia::net::description_attribute{}, "Set many parameters at once. args: index value [index value ...] or a blob of packed little endian [uint32 index, float32 value] records");
+			p->add_callback([this](const ossia::value& v) {
+				std::vector<parambatch::Entry> values;
+				if (parambatch::decode(v, values)) {
+					setParameterValues(values);
+				} else {
+					std::cerr << "malformed params_set value" << std::endl;
+				}
+			});
+		}
+		mIndexToParam = std::vector<ParamOSCUpdateData>(mCore->getNumParameters());
 		for (RNBO::ParameterIndex index = 0; index < mCore->getNumParameters(); index++) {
 			ParameterInfo info;
 
@@ -365,25 +509,27 @@ Instance::Instance(
 			if (!(info.type == ParameterType::ParameterTypeNumber || info.type == ParameterType::ParameterTypeSignal) || !info.visible || info.debug)
 				continue;
 
-			ParamOSCUpdateData updateData;
+			auto& updateData = mIndexToParam[index];
 
 			//create comon, return normalized version
 			auto ccommon = [this, info, index](ossia::net::node_base& param) -> ossia::net::parameter_base * {
-				{
-					auto n = param.create_child("index");
+				mDeferredNodes.push_back([node = &param, index, displayName = std::string(info.displayName)]() {
+					{
+						auto n = node->create_child("index");
 
-					auto p = n->create_parameter(ossia::val_type::INT);
-					n->set(ossia::net::description_attribute{}, "RNBO parameter index");
-					n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
-					p->push_value(static_cast<int>(index));
-				}
+						auto p = n->create_parameter(ossia::val_type::INT);
+						n->set(ossia::net::description_attribute{}, "RNBO parameter index");
+						n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+						p->push_value(static_cast<int>(index));
+					}
 
-				{
-					auto n = param.create_child("display_name");
-					auto p = n->create_parameter(ossia::val_type::STRING);
-					n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
-					p->push_value(std::string(info.displayName));
-				}
+					{
+						auto n = node->create_child("display_name");
+						auto p = n->create_parameter(ossia::val_type::STRING);
+						n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+						p->push_value(displayName);
+					}
+				});
 
 				{
 					auto n = param.create_child("normalized");
@@ -418,46 +564,38 @@ Instance::Instance(
 
 					updateData.normparam = ccommon(n);
 					updateData.param = p;
+					updateData.normvalue = static_cast<float>(mCore->convertToNormalizedParameterValue(index, info.initialValue));
 					p->add_callback([this, index](const ossia::value& val) { handleFloatParamOscUpdate(index, val); });
 				}
 
 				//steps
 				if (info.steps > 0) {
-					auto s = n.create_child("steps");
-					auto p = s->create_parameter(ossia::val_type::INT);
-					s->set(ossia::net::description_attribute{}, "RNBO parameter steps");
-					s->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
-					p->push_value(info.steps);
+					mDeferredNodes.push_back([node = &n, steps = info.steps]() {
+						auto s = node->create_child("steps");
+						auto p = s->create_parameter(ossia::val_type::INT);
+						s->set(ossia::net::description_attribute{}, "RNBO parameter steps");
+						s->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+						p->push_value(steps);
+					});
 				}
 
 			} else {
-				//enumerated parameters
-				std::vector<ossia::value> values;
-
-				//build out lookup maps between strings and numbers
-				for (int e = 0; e < info.steps; e++) {
-					std::string s(info.enumValues[e]);
-					values.push_back(s);
-					updateData.nameToVal[s] = static_cast<ParameterValue>(e);
-					updateData.valToName[e] = s;
-				}
+				//enumerated parameters, the lookup tables between strings and numbers are shared with other instances of this patcher
+				updateData.enums = mPatcherFactory->attributes().enumInfo(index, info);
 
 				auto p = n.create_parameter(ossia::val_type::STRING);
 
-				auto dom = ossia::init_domain(ossia::val_type::STRING);
-				ossia::set_values(dom, values);
-				n.set(ossia::net::domain_attribute{}, dom);
+				n.set(ossia::net::domain_attribute{}, updateData.enums->domain);
 				n.set(ossia::net::bounding_mode_attribute{}, ossia::bounding_mode::CLIP);
 				p->push_value(info.enumValues[std::min(std::max(0, static_cast<int>(info.initialValue)), info.steps - 1)]);
 
 				updateData.normparam = ccommon(n);
 				updateData.param = p;
+				updateData.normvalue = static_cast<float>(mCore->convertToNormalizedParameterValue(index, info.initialValue));
 
 				p->add_callback([this, index](const ossia::value& val) { handleEnumParamOscUpdate(index, val); });
 			}
 
-			mIndexToParam[index] = updateData;
-
 			//add meta and other json derived values
 			if (paramConfig.is_array()) {
 				RNBO::Json metaoverride;
@@ -481,12 +619,12 @@ Instance::Instance(
 
 						//save default and process meta
 						if (meta.is_object()) {
-							mParamMetaDefault.insert({index, meta.dump()});
+							mParamMetaDefault.insert({index, mPatcherFactory->attributes().intern(meta.dump())});
 						}
 
 						op->add_callback([this, op, on, index](const ossia::value& val) {
 								std::string s = val.get_type() == ossia::val_type::STRING ? val.get<std::string>() : std::string();
-								mMetaUpdateQueue.push(MetaUpdateCommand(on, op, index, s));
+								mMetaUpdateQueue->push(MetaUpdateCommand(on, op, index, s));
 						});
 
 						if (metaoverride.is_object()) {
@@ -516,12 +654,14 @@ Instance::Instance(
 								}
 
 								if (displayorder.has_value()) {
-									auto dn = n.create_child("display_order");
-
-									auto dp = dn->create_parameter(ossia::val_type::INT);
-									dn->set(ossia::net::description_attribute{}, "RNBO parameter display order");
-									dn->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
-									dp->push_value(*displayorder);
+									mDeferredNodes.push_back([node = &n, order = *displayorder]() {
+										auto dn = node->create_child("display_order");
+
+										auto dp = dn->create_parameter(ossia::val_type::INT);
+										dn->set(ossia::net::description_attribute{}, "RNBO parameter display order");
+										dn->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+										dp->push_value(order);
+									});
 								}
 							} catch (const std::exception& e) {
 								std::cerr << "exception parsing param '" << mCore->getParameterId(index) << "' displayorder " << e.what() << std::endl;
@@ -530,12 +670,14 @@ Instance::Instance(
 
 						if (p.contains("unit")) {
 							if (p["unit"].is_string()) {
-								auto dn = n.create_child("unit");
+								mDeferredNodes.push_back([node = &n, unit = p["unit"].get<std::string>()]() {
+									auto dn = node->create_child("unit");
 
-								auto dp = dn->create_parameter(ossia::val_type::STRING);
-								dn->set(ossia::net::description_attribute{}, "RNBO parameter unit name");
-								dn->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
-								dp->push_value(p["unit"].get<std::string>());
+									auto dp = dn->create_parameter(ossia::val_type::STRING);
+									dn->set(ossia::net::description_attribute{}, "RNBO parameter unit name");
+									dn->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+									dp->push_value(unit);
+								});
 							}
 						}
 						break;
@@ -544,6 +686,38 @@ Instance::Instance(
 			}
 		}
 
+		//published with the other diagnostics, once construction has interned everything
+		{
+			auto n = infoNode->create_child("attribute_bytes_unshared");
+			mAttributeBytesUnsharedParam = n->create_parameter(ossia::val_type::INT);
+			n->set(ossia::net::description_attribute{}, "Approximate bytes of enum tables and meta defaults this instance would hold without sharing them with other instances of the patcher");
+			n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+
+			n = infoNode->create_child("attribute_bytes");
+			mAttributeBytesParam = n->create_parameter(ossia::val_type::INT);
+			n->set(ossia::net::description_attribute{}, "This instance's share of the enum tables and meta defaults, each divided by the number of instances using it");
+			n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+		}
+
+		//local processes can skip OSC entirely
+		if (config::get<bool>(config::key::InstanceShmControl).value_or(false)) {
+			try {
+				mShmControl = std::make_unique<ShmControl>("rnbo-ctl-" + std::to_string(mIndex), mCore->getNumParameters(), mIngestTarget);
+				for (RNBO::ParameterIndex index = 0; index < mCore->getNumParameters(); index++) {
+					auto value = mCore->getParameterValue(index);
+					mShmControl->mirror(index, value, mCore->convertToNormalizedParameterValue(index, value));
+				}
+
+				auto n = root->create_child("control_shm");
+				auto p = n->create_parameter(ossia::val_type::STRING);
+				n->set(ossia::net::description_attribute{}, "Name of the shared memory region for local parameter and inport control, see ShmControl.h for the layout");
+				n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+				p->push_value(mShmControl->name());
+			} catch (const std::exception& e) {
+				std::cerr << "failed to create control shared memory: " << e.what() << std::endl;
+			}
+		}
+
 		{
 
 			auto dataRefs = root->create_child("data_refs");
@@ -610,7 +784,7 @@ Instance::Instance(
 					auto op = param_meta.second;
 
 					if (meta.is_object()) {
-						mDataRefMetaDefault.insert({name, meta.dump()});
+						mDataRefMetaDefault.insert({name, mPatcherFactory->attributes().intern(meta.dump())});
 					}
 
 					std::string mapping;
@@ -627,7 +801,7 @@ Instance::Instance(
 
 					op->add_callback([this, op, on, name](const ossia::value& val) {
 							std::string s = val.get_type() == ossia::val_type::STRING ? val.get<std::string>() : std::string();
-							mMetaUpdateQueue.push(MetaUpdateCommand(on, op, MetaUpdateCommand::Subject::DataRef, name, s));
+							mMetaUpdateQueue->push(MetaUpdateCommand(on, op, MetaUpdateCommand::Subject::DataRef, name, s));
 					});
 
 
@@ -666,6 +840,9 @@ Instance::Instance(
 				mPresetEntries = n->create_parameter(ossia::val_type::LIST);
 				n->set(ossia::net::description_attribute{}, "A list of presets that can be loaded");
 				n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+
+				//incremental updates and paging, so clients with many presets don't need to refetch entries on every change
+				mPresetListing = std::make_unique<Listing>(n, "preset");
 			}
 
 			//save preset, pass name
@@ -918,7 +1095,7 @@ Instance::Instance(
 								auto op = param_meta.second;
 
 								if (meta.is_object()) {
-									mInportMetaDefault.insert({name, meta.dump()});
+									mInportMetaDefault.insert({name, mPatcherFactory->attributes().intern(meta.dump())});
 								}
 
 								std::string mapping;
@@ -936,13 +1113,14 @@ Instance::Instance(
 
 								op->add_callback([this, op, on, name](const ossia::value& val) {
 										std::string s = val.get_type() == ossia::val_type::STRING ? val.get<std::string>() : std::string();
-										mMetaUpdateQueue.push(MetaUpdateCommand(on, op, MetaUpdateCommand::Subject::Inport, name, s));
+										mMetaUpdateQueue->push(MetaUpdateCommand(on, op, MetaUpdateCommand::Subject::Inport, name, s));
 								});
 							}
 
 							p->add_callback([this, tag](const ossia::value& val) {
 								handleInportMessage(tag, val);
 							});
+							mIngestInports.emplace_back(&n, tag);
 						}
 					}
 					if (hasOutports) {
@@ -954,7 +1132,9 @@ Instance::Instance(
 							auto p = n.create_parameter(ossia::val_type::LIST);
 							n.set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
 
-							mOutportParam.emplace(name, p);
+							auto& outport = mOutports[RNBO::TAG(name.c_str())];
+							outport.param = p;
+							outport.list = std::vector<ossia::value>();
 
 							//add meta
 							{
@@ -965,7 +1145,7 @@ Instance::Instance(
 								auto op = param_meta.second;
 
 								if (meta.is_object()) {
-									mOutportMetaDefault.insert({name, meta.dump()});
+									mOutportMetaDefault.insert({name, mPatcherFactory->attributes().intern(meta.dump())});
 								}
 
 								std::string mapping;
@@ -983,7 +1163,7 @@ Instance::Instance(
 
 								op->add_callback([this, op, on, name](const ossia::value& val) {
 										std::string s = val.get_type() == ossia::val_type::STRING ? val.get<std::string>() : std::string();
-										mMetaUpdateQueue.push(MetaUpdateCommand(on, op, MetaUpdateCommand::Subject::Outport, name, s));
+										mMetaUpdateQueue->push(MetaUpdateCommand(on, op, MetaUpdateCommand::Subject::Outport, name, s));
 								});
 							}
 						}
@@ -1077,6 +1257,10 @@ Instance::Instance(
 }
 
 Instance::~Instance() {
+	//routing tables may still reference the target, make sure nothing else gets through
+	mShmControl.reset();
+	mIngestTarget->close();
+
 	//cleanup callbacks
 	for (auto& kv: mMetaCleanup) {
 		kv.second();
@@ -1121,11 +1305,89 @@ void Instance::registerPresetSavedCallback(std::function<void(const std::string&
 	mPresetSavedCallback = cb;
 }
 
-//build mutex is locked, we can build
+std::unique_lock<std::mutex> Instance::lockTree() {
+	return std::unique_lock<std::mutex>(mTreeMutex);
+}
+
+void Instance::detachTree() {
+	mTreeAttached = false;
+}
+
 void Instance::processEvents() {
+	processDispatchEvents();
+	processControlEvents();
+}
+
+void Instance::processControlEvents() {
+	std::lock_guard<std::mutex> guard(mTreeMutex);
+	//stopping instances still need their audio processed to finish fading out
+	mAudio->processEvents();
+	if (!mTreeAttached) {
+		mDispatchPushes.clear();
+		return;
+	}
+	DeferredPushProtocol::publish(mDispatchPushes);
+	buildDeferredNodes();
+
+	//handle meta updates
+	if (auto dropped = mMetaUpdateQueue->overflowed()) {
+		std::cerr << "instance " << mIndex << " meta update queue full, dropped " << dropped << " updates" << std::endl;
+	}
+	while (auto item = mMetaUpdateQueue->tryPop()) {
+		auto update = item.get();
+		handleMetadataUpdate(update);
+	}
+
+	const auto state = audioState();
+	if (state == AudioState::Starting || state == AudioState::Running) {
+		//see if we should signal a change
+		auto changed = false;
+		{
+			std::lock_guard<std::mutex> guard(mConfigChangedMutex);
+			changed = mConfigChanged;
+			mConfigChanged = false;
+		}
+
+		if (changed && mConfigChangeCallback != nullptr) {
+			mConfigChangeCallback();
+		}
+	}
+}
+
+bool Instance::takeNodesBuilt() {
+	bool built = mDeferredNodesBuilt;
+	mDeferredNodesBuilt = false;
+	return built;
+}
+
+void Instance::buildDeferredNodes() {
+	if (mDeferredNodes.empty()) {
+		return;
+	}
+	QuietTreeChanges quiet;
+	auto deadline = std::chrono::steady_clock::now() + deferred_node_budget;
+	do {
+		auto f = std::move(mDeferredNodes.front());
+		mDeferredNodes.pop_front();
+		f();
+	} while (!mDeferredNodes.empty() && std::chrono::steady_clock::now() < deadline);
+	mDeferredNodesBuilt = mDeferredNodes.empty();
+}
+
+void Instance::processDispatchEvents() {
+	std::lock_guard<std::mutex> guard(mTreeMutex);
+	if (!mTreeAttached) {
+		return;
+	}
+	//other workers push at the same time, leave the sending to the controller thread
+	boost::optional<DeferredPushProtocol::Capture> capture;
+	if (EventDispatcher::onWorker()) {
+		capture.emplace(mDispatchPushes);
+	}
 	const auto state = audioState();
 	const auto active = state == AudioState::Starting || state == AudioState::Running;
 	if (active) {
+		updateClockOffset();
 		mEventHandler->processEvents();
 
 		auto key = mAudio->lastMIDIKey();
@@ -1140,7 +1402,43 @@ void Instance::processEvents() {
 			}
 		}
 	}
-	mAudio->processEvents();
+
+	//report suppressed updates, throttled as this could change at a high rate
+	{
+		auto now = std::chrono::steady_clock::now();
+		if (now >= mSuppressedParamUpdatesReportNext) {
+			mSuppressedParamUpdatesReportNext = now + suppressed_report_period;
+			auto suppressed = mSuppressedParamUpdates.load(std::memory_order_relaxed);
+			if (suppressed != mSuppressedParamUpdatesReported) {
+				mSuppressedParamUpdatesReported = suppressed;
+				mSuppressedParamUpdatesParam->push_value(static_cast<int>(suppressed));
+			}
+			auto late = mLateOSCEvents.load(std::memory_order_relaxed);
+			if (late != mLateOSCEventsReported) {
+				mLateOSCEventsReported = late;
+				mLateOSCEventsParam->push_value(static_cast<int>(late));
+			}
+			//our share changes as other instances of the patcher come and go
+			reportAttributeBytes();
+		}
+	}
+
+	if (active) {
+		auto now = std::chrono::steady_clock::now();
+		if (now >= mIngestMirrorNext) {
+			mIngestMirrorNext = now + ingest_mirror_period;
+			mirrorIngested();
+		}
+	}
+
+	if (mSnapshotEnabled && active) {
+		auto now = std::chrono::steady_clock::now();
+		if (now >= mSnapshotNext) {
+			mSnapshotNext = now + mSnapshotPeriod.load();
+			publishSnapshot();
+		}
+	}
+
 	if (mDataHandler && active) {
 		mDataHandler->processEvents(mDataRefNodes);
 	}
@@ -1187,25 +1485,14 @@ void Instance::processEvents() {
 		}
 	}
 
-	//handle meta updates
-	while (auto item = mMetaUpdateQueue.tryPop()) {
-		auto update = item.get();
-		handleMetadataUpdate(update);
-	}
-
 	if (active) {
-		//see if we should signal a change
-		auto changed = false;
-		{
-			std::lock_guard<std::mutex> guard(mConfigChangedMutex);
-			changed = mConfigChanged;
-			mConfigChanged = false;
-		}
-
 		//store any presets that we got
 		bool updated = false;
 		//only process a few events
 		auto c = 0;
+		if (auto dropped = mPresetCommandQueue.overflowed()) {
+			std::cerr << "instance " << mIndex << " preset command queue full, dropped " << dropped << " commands" << std::endl;
+		}
 		while (auto item = mPresetCommandQueue.tryPop()) {
 			auto cmd = item.get();
 			switch (cmd.type) {
@@ -1275,6 +1562,7 @@ void Instance::processEvents() {
 					break;
 				case PresetCommand::CommandType::Rename:
 					mDB->presetRename(mName, cmd.preset, cmd.newname);
+					mPresetListing->rename(cmd.preset, cmd.newname);
 					{
 						mPresetsDirty = true;
 						//update our initial and latest if they match
@@ -1304,10 +1592,6 @@ void Instance::processEvents() {
 		if (updated) {
 			updatePresetEntries();
 		}
-
-		if (changed && mConfigChangeCallback != nullptr) {
-			mConfigChangeCallback();
-		}
 	}
 }
 
@@ -1533,22 +1817,31 @@ RNBO::Json Instance::presetToJSON(const RNBO::Preset& preset) {
 
 void Instance::updatePresetEntries() {
 	std::lock_guard<std::mutex> guard(mPresetMutex);
-	std::vector<ossia::value> names;
-	std::vector<ossia::value> indexes;
+	std::vector<Listing::Entry> entries;
 
 	int loadedi = -1;
-	mDB->presets(mName, [&names, &indexes, &loadedi, this](const std::string& name, bool /*initial*/, int presetindex) {
-		names.push_back(ossia::value(name));
-		indexes.push_back(ossia::value(presetindex));
+	mDB->presets(mName, [&entries, &loadedi, this](const std::string& name, bool /*initial*/, int presetindex) {
+		entries.emplace_back(name, presetindex);
 
 		if (name == mPresetNameLatest) {
 			loadedi = presetindex;
 		}
 	});
 
-	mPresetEntries->push_value(ossia::value(names));
-	mPresetCount->push_value(static_cast<int>(names.size()));
-	mPresetIndexes->push_value(ossia::value(indexes));
+	//only ship the full lists if something actually changed
+	if (mPresetListing->update(entries)) {
+		std::vector<ossia::value> names;
+		std::vector<ossia::value> indexes;
+		names.reserve(entries.size());
+		indexes.reserve(entries.size());
+		for (const auto& e: entries) {
+			names.push_back(ossia::value(e.first));
+			indexes.push_back(ossia::value(e.second));
+		}
+		mPresetEntries->push_value(ossia::value(names));
+		mPresetCount->push_value(static_cast<int>(names.size()));
+		mPresetIndexes->push_value(ossia::value(indexes));
+	}
 
 	if (loadedi < 0) {
 		if (mPresetNameLatest.size() > 0) {
@@ -1657,81 +1950,125 @@ void Instance::saveDataref(std::string id, fs::path dir, std::string filenameTem
 	});
 }
 
+Instance::ScheduledAt::ScheduledAt(std::chrono::system_clock::time_point when) : mPrevious(tScheduledAt) {
+	tScheduledAt = when;
+}
+
+Instance::ScheduledAt::~ScheduledAt() {
+	tScheduledAt = mPrevious;
+}
+
+RNBO::MillisecondTime Instance::oscEventTime() {
+	if (!tScheduledAt || !mClockOffsetValid.load(std::memory_order_relaxed)) {
+		return RNBO_TIMENOW;
+	}
+
+	const double wallms = std::chrono::duration<double, std::milli>(tScheduledAt->time_since_epoch()).count();
+	const RNBO::MillisecondTime time = wallms + mClockOffsetMs.load(std::memory_order_relaxed);
+	if (time <= mCore->getCurrentTime()) {
+		mLateOSCEvents.fetch_add(1, std::memory_order_relaxed);
+		return RNBO_TIMENOW;
+	}
+	return time;
+}
+
+void Instance::updateClockOffset() {
+	const double wallms = std::chrono::duration<double, std::milli>(std::chrono::system_clock::now().time_since_epoch()).count();
+	const double sample = mCore->getCurrentTime() - wallms;
+	const double offset = mClockOffsetMs.load(std::memory_order_relaxed);
+
+	//samples only ever lag the true offset, so follow them up immediately and down slowly to track drift
+	if (!mClockOffsetValid.load(std::memory_order_relaxed) || std::abs(sample - offset) > clock_offset_reset_ms || sample > offset) {
+		mClockOffsetMs.store(sample, std::memory_order_relaxed);
+		mClockOffsetValid.store(true, std::memory_order_relaxed);
+	} else {
+		mClockOffsetMs.store(offset + (sample - offset) * clock_offset_smoothing, std::memory_order_relaxed);
+	}
+}
+
 void Instance::handleInportMessage(RNBO::MessageTag tag, const ossia::value& val) {
+	const auto time = oscEventTime();
 	if (val.get_type() == ossia::val_type::IMPULSE) {
-		mParamInterface->sendMessage(tag);
+		mParamInterface->sendMessage(tag, static_cast<RNBO::MessageTag>(0), time);
 	} else if (val.get_type() == ossia::val_type::FLOAT) {
-		mParamInterface->sendMessage(tag, static_cast<RNBO::number>(val.get<float>()));
+		mParamInterface->sendMessage(tag, static_cast<RNBO::number>(val.get<float>()), 0, time);
 	} else if (val.get_type() == ossia::val_type::INT) {
-		mParamInterface->sendMessage(tag, static_cast<RNBO::number>(val.get<int>()));
+		mParamInterface->sendMessage(tag, static_cast<RNBO::number>(val.get<int>()), 0, time);
 	} else if (val.get_type() == ossia::val_type::BOOL) {
-		mParamInterface->sendMessage(tag, static_cast<RNBO::number>(val.get<bool>() ? 1 : 0));
+		mParamInterface->sendMessage(tag, static_cast<RNBO::number>(val.get<bool>() ? 1 : 0), 0, time);
 	} else if (val.get_type() == ossia::val_type::LIST) {
-		auto list = val.get<std::vector<ossia::value>>();
+		const auto& list = val.get<std::vector<ossia::value>>();
+		auto number = [](const ossia::value& v, RNBO::number& out) -> bool {
+			switch (v.get_type()) {
+				case ossia::val_type::INT:
+					out = static_cast<RNBO::number>(v.get<int>());
+					return true;
+				case ossia::val_type::FLOAT:
+					out = static_cast<RNBO::number>(v.get<float>());
+					return true;
+				case ossia::val_type::BOOL:
+					out = static_cast<RNBO::number>(v.get<bool>() ? 1 : 0);
+					return true;
+				default:
+					return false;
+			}
+		};
+
 		//empty list, bang
 		if (list.size() == 0 || (list.size() == 1 && list[0].get_type() == ossia::val_type::IMPULSE)) {
-			mParamInterface->sendMessage(tag);
+			mParamInterface->sendMessage(tag, static_cast<RNBO::MessageTag>(0), time);
 		} else if (list.size() == 1) {
 			RNBO::number v = 0.0;
-			if (list[0].get_type() == ossia::val_type::INT) {
-				v = static_cast<RNBO::number>(list[0].get<int>());
-			} else if (list[0].get_type() == ossia::val_type::FLOAT) {
-				v = static_cast<RNBO::number>(list[0].get<float>());
-			} else if (list[0].get_type() == ossia::val_type::BOOL) {
-				v = static_cast<RNBO::number>(list[0].get<bool>() ? 1 : 0);
-			} else {
+			if (!number(list[0], v)) {
 				std::cerr << "only numeric items are allowed in lists, aborting message" << std::endl;
 			}
-			mParamInterface->sendMessage(tag, v);
+			mParamInterface->sendMessage(tag, v, 0, time);
 		} else {
-			//construct and send list
-			auto l = RNBO::make_unique<RNBO::list>();
-			for (auto v: list) {
-				if (v.get_type() == ossia::val_type::INT)
-					l->push(static_cast<RNBO::number>(v.get<int>()));
-				else if (v.get_type() == ossia::val_type::FLOAT)
-					l->push(static_cast<RNBO::number>(v.get<float>()));
-				else if (v.get_type() == ossia::val_type::BOOL)
-					l->push(static_cast<RNBO::number>(v.get<bool>() ? 1 : 0));
-				else {
+			//validate before allocating, RNBO takes ownership of the list so it cannot come from a pool
+			RNBO::number v = 0.0;
+			for (const auto& item: list) {
+				if (!number(item, v)) {
 					std::cerr << "only numeric values are allowed in lists, aborting message" << std::endl;
 					return;
 				}
 			}
-			mParamInterface->sendMessage(tag, std::move(l));
+			auto l = RNBO::make_unique<RNBO::list>();
+			for (const auto& item: list) {
+				number(item, v);
+				l->push(v);
+			}
+			mParamInterface->sendMessage(tag, std::move(l), 0, time);
 		}
 	}
 }
 
 void Instance::handleOutportMessage(RNBO::MessageEvent e) {
-	auto tag = std::string(mCore->resolveTag(e.getTag()));
-	ossia::value val;
-
-	auto it = mOutportParam.find(tag);
-	if (it == mOutportParam.end()) {
-		std::cerr << "couldn't find outport node with tag " << tag << std::endl;
+	auto it = mOutports.find(e.getTag());
+	if (it == mOutports.end()) {
+		std::cerr << "couldn't find outport node with tag " << mCore->resolveTag(e.getTag()) << std::endl;
 		return;
 	}
+	auto& outport = it->second;
 
-
+	const ossia::value * val = nullptr;
 	switch(e.getType()) {
 		case MessageEvent::Type::Number:
-			val = static_cast<float>(e.getNumValue());
-			it->second->push_value(val);
+			outport.number = static_cast<float>(e.getNumValue());
+			val = &outport.number;
 			break;
 		case MessageEvent::Type::Bang:
-			val = ossia::impulse {};
-			it->second->push_value(val);
+			val = &outport.bang;
 			break;
 		case MessageEvent::Type::List:
 			{
-				std::vector<ossia::value> values;
+				//reuse the list storage from the previous message
+				auto values = outport.list.target<std::vector<ossia::value>>();
 				std::shared_ptr<const RNBO::list> elist = e.getListValue();
+				values->resize(elist->length);
 				for (size_t i = 0; i < elist->length; i++) {
-					values.push_back(ossia::value(elist->operator[](i)));
+					(*values)[i] = static_cast<float>(elist->operator[](i));
 				}
-				val = values;
-				it->second->push_value(val);
+				val = &outport.list;
 			}
 			break;
 		case MessageEvent::Type::Invalid:
@@ -1740,9 +2077,9 @@ void Instance::handleOutportMessage(RNBO::MessageEvent e) {
 			return; //TODO warning message?
 	}
 
-	auto oit = mOutportOSCMap.find(tag);
-	if (oit != mOutportOSCMap.end()) {
-		mOSCCallback(oit->second, val);
+	outport.param->push_value(*val);
+	if (outport.oscaddr.size()) {
+		mOSCCallback(outport.oscaddr, *val);
 	}
 }
 
@@ -1761,27 +2098,161 @@ void Instance::handleMidiCallback(RNBO::MidiEvent e) {
 //from RNBO
 void Instance::handleParamUpdate(RNBO::ParameterIndex index, RNBO::ParameterValue value) {
 	//RNBO is telling us we have a parameter update, tell ossia
-	auto it = mIndexToParam.find(index);
-	if (it == mIndexToParam.end()) {
+	auto data = paramData(index);
+	if (data == nullptr) {
 		//XXX error
 		return;
 	}
 
-	auto& info = it->second;
+	//set through the ingest port or shared memory, mirrorIngested will publish it
+	if (mIngestTarget->touched(index)) {
+		if (mShmControl) {
+			mShmControl->mirror(index, value, mCore->convertToNormalizedParameterValue(index, value));
+		}
+		return;
+	}
+
+	auto& info = *data;
 	//prevent recursion
-	if (auto _lock = std::unique_lock<std::mutex> (*info.mutex, std::try_to_lock)) {
-		auto norm = static_cast<float>(mCore->convertToNormalizedParameterValue(index, value));
-		if (info.valToName.size()) {
-			auto it2 = info.valToName.find(static_cast<int>(value));
-			if (it2 != info.valToName.end()) {
-				info.param->push_value(it2->second);
-				info.push_osc(it2->second, norm, mOSCCallback);
-			}
-		} else {
-			info.param->push_value(value);
-			info.push_osc(static_cast<float>(value), norm, mOSCCallback);
+	if (auto guard = ReentrancyGuard(&info, mSuppressedParamUpdates)) {
+		publishParamValue(info, index, value);
+	}
+}
+
+void Instance::mirrorIngested() {
+	if (!mIngestTarget->anyTouched()) {
+		return;
+	}
+	for (RNBO::ParameterIndex index = 0; index < mIngestTarget->numParams(); index++) {
+		if (!mIngestTarget->clearTouched(index)) {
+			continue;
+		}
+		auto data = paramData(index);
+		if (data == nullptr) {
+			continue;
+		}
+		auto& info = *data;
+		if (auto guard = ReentrancyGuard(&info, mSuppressedParamUpdates)) {
+			publishParamValue(info, index, mCore->getParameterValue(index));
 		}
-		info.normparam->push_value(norm);
+	}
+}
+
+void Instance::addIngestRoutes(OSCIngest::Routes& routes) {
+	for (RNBO::ParameterIndex index = 0; index < mIndexToParam.size(); index++) {
+		auto& info = mIndexToParam[index];
+		if (info.param == nullptr) {
+			continue;
+		}
+		OSCIngestRoute route;
+		route.target = mIngestTarget;
+		route.index = index;
+		route.kind = OSCIngestRoute::Kind::Param;
+		routes[info.param->get_node().osc_address()] = route;
+		route.kind = OSCIngestRoute::Kind::NormalizedParam;
+		routes[info.normparam->get_node().osc_address()] = route;
+	}
+	for (const auto& [node, tag]: mIngestInports) {
+		OSCIngestRoute route;
+		route.target = mIngestTarget;
+		route.kind = OSCIngestRoute::Kind::Inport;
+		route.tag = tag;
+		routes[node->osc_address()] = route;
+	}
+}
+
+void Instance::publishParamValue(ParamOSCUpdateData& info, RNBO::ParameterIndex index, RNBO::ParameterValue value) {
+	auto norm = static_cast<float>(mCore->convertToNormalizedParameterValue(index, value));
+	if (info.enums) {
+		if (auto name = info.enums->name(static_cast<int>(value))) {
+			info.param->push_value(*name);
+			info.push_osc(*name, norm, mOSCCallback, mSuppressedParamUpdates);
+		}
+	} else {
+		info.param->push_value(value);
+		info.push_osc(static_cast<float>(value), norm, mOSCCallback, mSuppressedParamUpdates);
+	}
+	info.normparam->push_value(norm);
+	trackParam(info, index, value, norm);
+}
+
+void Instance::trackParam(ParamOSCUpdateData& info, RNBO::ParameterIndex index, RNBO::ParameterValue value, float norm) {
+	info.track(norm);
+	if (mShmControl) {
+		mShmControl->mirror(index, value, norm);
+	}
+}
+
+void Instance::setParameterValues(const std::vector<std::pair<RNBO::ParameterIndex, RNBO::ParameterValue>>& values) {
+	//schedule everything at the same time so the values land in the same audio period
+	const auto time = mCore->getCurrentTime();
+	//RNBO echoes each value back through handleParamUpdate, which publishes it to ossia and OSC
+	for (const auto& [index, v]: values) {
+		if (paramData(index) == nullptr) {
+			continue;
+		}
+		mParamInterface->setParameterValue(index, mCore->constrainParameterValue(index, v), time);
+	}
+}
+
+void Instance::publishSnapshot() {
+	const size_t count = mIndexToParam.size();
+	const size_t words = (count + 31) / 32;
+
+	std::vector<uint32_t> mask(words, 0);
+	bool any = mSnapshotFull;
+	for (size_t i = 0; i < count; i++) {
+		auto& info = mIndexToParam[i];
+		if (info.dirty.exchange(false, std::memory_order_acquire) || (mSnapshotFull && info.param != nullptr)) {
+			mask[i / 32] |= (1u << (i % 32));
+			any = true;
+		}
+	}
+	mSnapshotFull = false;
+	if (!any) {
+		return;
+	}
+
+	//reuse the buffer, only the values change between snapshots
+	mSnapshotBuffer.resize(words + count);
+	for (size_t w = 0; w < words; w++) {
+		mSnapshotBuffer[w] = static_cast<int>(mask[w]);
+	}
+	for (size_t i = 0; i < count; i++) {
+		mSnapshotBuffer[words + i] = mIndexToParam[i].normvalue.load(std::memory_order_relaxed);
+	}
+	mSnapshotParam->push_value(mSnapshotBuffer);
+}
+
+void Instance::reportAttributeBytes() {
+	size_t unshared = 0;
+	size_t shared = 0;
+	//the attribute table holds one reference, the rest are held by instances
+	auto add = [&unshared, &shared](size_t bytes, long refs) {
+		unshared += bytes;
+		shared += bytes / static_cast<size_t>(std::max(1L, refs - 1));
+	};
+	for (const auto& info: mIndexToParam) {
+		if (info.enums) {
+			add(PatcherAttributes::bytes(*info.enums), info.enums.use_count());
+		}
+	}
+	for (auto m: {&mInportMetaDefault, &mOutportMetaDefault, &mDataRefMetaDefault}) {
+		for (const auto& kv: *m) {
+			add(PatcherAttributes::bytes(*kv.second), kv.second.use_count());
+		}
+	}
+	for (const auto& kv: mParamMetaDefault) {
+		add(PatcherAttributes::bytes(*kv.second), kv.second.use_count());
+	}
+
+	if (unshared != mAttributeBytesUnsharedReported) {
+		mAttributeBytesUnsharedReported = unshared;
+		mAttributeBytesUnsharedParam->push_value(static_cast<int>(unshared));
+	}
+	if (shared != mAttributeBytesReported) {
+		mAttributeBytesReported = shared;
+		mAttributeBytesParam->push_value(static_cast<int>(shared));
 	}
 }
 
@@ -1802,7 +2273,7 @@ void Instance::handlePresetEvent(const RNBO::PresetEvent& e) {
 }
 
 void Instance::handleMetadataUpdate(MetaUpdateCommand update) {
-	//assumes build mutex is locked which is the case in processEvents or builder
+	//assumes the tree is locked which is the case in processEvents or builder
 
 	//do we default ports named with "/" prefixes to become top level OSC messages?
 	const bool portToOSC = config::get<bool>(config::key::InstancePortToOSC).value_or(true);
@@ -1862,9 +2333,9 @@ void Instance::handleMetadataUpdate(MetaUpdateCommand update) {
 					if (it != mParamMetaDefault.end()) {
 						//push new value but let fall through to unmap meta
 						if (setDefault) {
-							update.param->push_value(it->second);
+							update.param->push_value(*it->second);
 						} else {
-							isCustom = update.meta != it->second;
+							isCustom = update.meta != *it->second;
 						}
 					}
 					if (isCustom) {
@@ -1889,9 +2360,9 @@ void Instance::handleMetadataUpdate(MetaUpdateCommand update) {
 					if (it != mInportMetaDefault.end()) {
 						//push new value but let fall through to unmap meta
 						if (setDefault) {
-							update.param->push_value(it->second);
+							update.param->push_value(*it->second);
 						} else {
-							isCustom = update.meta != it->second;
+							isCustom = update.meta != *it->second;
 						}
 					}
 					if (isCustom) {
@@ -1913,9 +2384,9 @@ void Instance::handleMetadataUpdate(MetaUpdateCommand update) {
 					if (it != mOutportMetaDefault.end()) {
 						//push new value but let fall through to unmap meta
 						if (setDefault) {
-							update.param->push_value(it->second);
+							update.param->push_value(*it->second);
 						} else {
-							isCustom = update.meta != it->second;
+							isCustom = update.meta != *it->second;
 						}
 					}
 					if (isCustom) {
@@ -1935,9 +2406,9 @@ void Instance::handleMetadataUpdate(MetaUpdateCommand update) {
 					if (it != mDataRefMetaDefault.end()) {
 						//push new value but let fall through to unmap meta
 						if (setDefault) {
-							update.param->push_value(it->second);
+							update.param->push_value(*it->second);
 						} else {
-							isCustom = update.meta != it->second;
+							isCustom = update.meta != *it->second;
 						}
 					}
 					if (isCustom) {
@@ -2151,18 +2622,18 @@ void Instance::handleMetadataUpdate(MetaUpdateCommand update) {
 					//can we do both remapping and noramlization with an input and output std::func<float(float)> ?
 
 					{
-						auto it = mIndexToParam.find(index);
-						if (it == mIndexToParam.end()) {
+						auto data = paramData(index);
+						if (data == nullptr) {
 							std::cerr << "failed to find param mapping info, aborting meta osc mapping" << std::endl;
 							return;
 						}
-						it->second.usenormalized = usenormalized;
+						data->usenormalized = usenormalized;
 
 						//if the access mode is BI or GET, this means we send messages out so set the oscaddr
 						if (oscAccessMode == ossia::access_mode::BI || oscAccessMode == ossia::access_mode::GET) {
-							it->second.oscaddr = oscAddr;
+							data->oscaddr = oscAddr;
 						} else {
-							it->second.oscaddr.clear();
+							data->oscaddr.clear();
 						}
 
 						if (oscAccessMode == ossia::access_mode::BI || oscAccessMode == ossia::access_mode::SET) {
@@ -2172,10 +2643,9 @@ void Instance::handleMetadataUpdate(MetaUpdateCommand update) {
 
 					cleanup = [this, index, oscAddr, paramAddr]() {
 						//clear out the associated oscaddr
-						auto it = mIndexToParam.find(index);
-						if (it != mIndexToParam.end()) {
+						if (auto data = paramData(index)) {
 							//this might already be empty but no issue doing that again
-							it->second.oscaddr.clear();
+							data->oscaddr.clear();
 						}
 						//remove callbacks
 						mOSCRegisterCallback(false, oscAddr, paramAddr);
@@ -2192,9 +2662,18 @@ void Instance::handleMetadataUpdate(MetaUpdateCommand update) {
 				break;
 			case MetaUpdateCommand::Subject::Outport:
 				{
-					mOutportOSCMap[name] = oscAddr;
-					cleanup = [name, this]() {
-						mOutportOSCMap.erase(name);
+					auto tag = RNBO::TAG(name.c_str());
+					auto it = mOutports.find(tag);
+					if (it == mOutports.end()) {
+						std::cerr << "failed to find outport " << name << ", aborting meta osc mapping" << std::endl;
+						return;
+					}
+					it->second.oscaddr = oscAddr;
+					cleanup = [tag, this]() {
+						auto it = mOutports.find(tag);
+						if (it != mOutports.end()) {
+							it->second.oscaddr.clear();
+						}
 					};
 				}
 				break;
@@ -2206,38 +2685,37 @@ void Instance::handleMetadataUpdate(MetaUpdateCommand update) {
 }
 
 void Instance::handleEnumParamOscUpdate(RNBO::ParameterIndex index, const ossia::value& val) {
-	auto it = mIndexToParam.find(index);
-	if (it == mIndexToParam.end()) {
+	auto data = paramData(index);
+	if (data == nullptr) {
 		//XXX ERROR
 		return;
 	}
 
-	auto& info = it->second;
+	auto& info = *data;
 
 	//TODO any other types valid?
-	if (val.get_type() == ossia::val_type::STRING) {
-		if (auto _lock = std::unique_lock<std::mutex> (*info.mutex, std::try_to_lock)) {
-			auto s = val.get<std::string>();
-			auto f = info.nameToVal.find(s);
-			if (f != info.nameToVal.end()) {
-				mParamInterface->setParameterValue(index, f->second);
-
-				auto norm = static_cast<float>(mCore->convertToNormalizedParameterValue(index, f->second));
-				info.push_osc(static_cast<float>(f->second), norm, mOSCCallback);
+	if (val.get_type() == ossia::val_type::STRING && info.enums) {
+		if (auto guard = ReentrancyGuard(&info, mSuppressedParamUpdates)) {
+			if (auto v = info.enums->value(val.get<std::string>())) {
+				mParamInterface->setParameterValue(index, *v, oscEventTime());
+
+				auto norm = static_cast<float>(mCore->convertToNormalizedParameterValue(index, *v));
+				info.push_osc(static_cast<float>(*v), norm, mOSCCallback, mSuppressedParamUpdates);
 				info.normparam->push_value(norm);
+				trackParam(info, index, *v, norm);
 			}
 		}
 	}
 }
 
 void Instance::handleFloatParamOscUpdate(RNBO::ParameterIndex index, const ossia::value& val) {
-	auto it = mIndexToParam.find(index);
-	if (it == mIndexToParam.end()) {
+	auto data = paramData(index);
+	if (data == nullptr) {
 		//XXX ERROR
 		return;
 	}
 
-	auto& info = it->second;
+	auto& info = *data;
 
 	//support other types?
 	double f = 0.0;
@@ -2255,57 +2733,65 @@ void Instance::handleFloatParamOscUpdate(RNBO::ParameterIndex index, const ossia
 			return;
 	}
 
-	if (auto _lock = std::unique_lock<std::mutex> (*info.mutex, std::try_to_lock)) {
+	if (auto guard = ReentrancyGuard(&info, mSuppressedParamUpdates)) {
 		//constrain in case we're getting this from some random OSC source
 		f = mCore->constrainParameterValue(index, f);
-		mParamInterface->setParameterValue(index, f);
+		mParamInterface->setParameterValue(index, f, oscEventTime());
 		auto norm = static_cast<float>(mCore->convertToNormalizedParameterValue(index, f));
 
-		info.push_osc(static_cast<float>(f), norm, mOSCCallback);
+		info.push_osc(static_cast<float>(f), norm, mOSCCallback, mSuppressedParamUpdates);
 		info.normparam->push_value(norm);
+		trackParam(info, index, f, norm);
 	}
 }
 
 void Instance::handleNormalizedFloatParamOscUpdate(RNBO::ParameterIndex index, const ossia::value& val) {
-	auto it = mIndexToParam.find(index);
-	if (it == mIndexToParam.end()) {
+	auto data = paramData(index);
+	if (data == nullptr) {
 		//XXX ERROR
 		return;
 	}
 
-	auto& info = it->second;
+	auto& info = *data;
 	if (val.get_type() == ossia::val_type::FLOAT) {
-		if (auto _lock = std::unique_lock<std::mutex> (*info.mutex, std::try_to_lock)) {
+		if (auto guard = ReentrancyGuard(&info, mSuppressedParamUpdates)) {
 			const double f = static_cast<double>(val.get<float>());
 
 			auto unnorm = mCore->convertFromNormalizedParameterValue(index, f);
-			mParamInterface->setParameterValue(index, unnorm);
+			mParamInterface->setParameterValue(index, unnorm, oscEventTime());
+			trackParam(info, index, unnorm, static_cast<float>(f));
 
 			//is it enum?
-			if (info.valToName.size()) {
-				auto name = info.valToName.find(static_cast<int>(std::round(unnorm)));
-				if (name != info.valToName.end()) {
-					info.param->push_value(name->second);
-					info.push_osc(name->second, f, mOSCCallback);
+			if (info.enums) {
+				if (auto name = info.enums->name(static_cast<int>(std::round(unnorm)))) {
+					info.param->push_value(*name);
+					info.push_osc(*name, f, mOSCCallback, mSuppressedParamUpdates);
 				}
 			} else {
 				info.param->push_value(static_cast<float>(unnorm));
-				info.push_osc(static_cast<float>(unnorm), f, mOSCCallback);
+				info.push_osc(static_cast<float>(unnorm), f, mOSCCallback, mSuppressedParamUpdates);
 			}
 		}
 	}
 }
 
 
-Instance::ParamOSCUpdateData::ParamOSCUpdateData() {
-	mutex = std::make_shared<std::mutex>();
-	oscmutex = std::make_shared<std::mutex>();
+Instance::ParamOSCUpdateData * Instance::paramData(RNBO::ParameterIndex index) {
+	if (index < mIndexToParam.size() && mIndexToParam[index].param != nullptr) {
+		return &mIndexToParam[index];
+	}
+	return nullptr;
 }
 
-void Instance::ParamOSCUpdateData::push_osc(ossia::value val, float normval, OSCCallback cb) {
+void Instance::ParamOSCUpdateData::push_osc(const ossia::value& val, float normval, const OSCCallback& cb, std::atomic<uint64_t>& suppressed) {
 	if (oscaddr.size()) {
-		if (auto _olock = std::unique_lock<std::mutex> (*oscmutex, std::try_to_lock)) {
+		if (auto guard = ReentrancyGuard(&oscaddr, suppressed)) {
 			cb(oscaddr, usenormalized ? ossia::value(normval) : val);
 		}
 	}
 }
+
+void Instance::ParamOSCUpdateData::track(float norm) {
+	normvalue.store(norm, std::memory_order_relaxed);
+	dirty.store(true, std::memory_order_release);
+}
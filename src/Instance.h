@@ -9,6 +9,9 @@
 #include <mutex>
 #include <functional>
 #include <set>
+#include <chrono>
+#include <deque>
+#include <cstdint>
 
 #include <boost/optional.hpp>
 #include <boost/filesystem.hpp>
@@ -22,8 +25,13 @@
 #include "Queue.h"
 #include "DB.h"
 #include "MIDIMap.h"
+#include "OSCIngest.h"
+#include "PatcherAttributes.h"
+#include "Listing.h"
+#include "DeferredPushProtocol.h"
 
 class PatcherFactory;
+class ShmControl;
 namespace moodycamel {
 template<typename T, size_t MAX_BLOCK_SIZE>
 class ReaderWriterQueue;
@@ -63,6 +71,39 @@ class Instance {
 		//process any events in the current thread
 		void processEvents();
 
+		//the parts of processEvents that only touch this instance and existing nodes, may run on a dispatcher worker
+		void processDispatchEvents();
+		//the parts of processEvents that alter the tree or call back into the controller, call from the controller thread
+		void processControlEvents();
+		//true while informational nodes are still being added to the tree by processControlEvents
+		bool buildingNodes() const { return !mDeferredNodes.empty(); }
+		//they are built under QuietTreeChanges, true once, after the last of them was added
+		bool takeNodesBuilt();
+
+		//guards this instance's subtree, held by the process methods and by the controller while it removes the subtree
+		std::unique_lock<std::mutex> lockTree();
+		//call with the tree lock held, before the subtree is removed, after this only the audio is processed
+		void detachTree();
+
+		//while in scope, OSC driven parameter and inport updates made in this thread are scheduled
+		//for the given wall clock time instead of being applied immediately
+		class ScheduledAt {
+			public:
+				ScheduledAt(std::chrono::system_clock::time_point when);
+				~ScheduledAt();
+				ScheduledAt(const ScheduledAt&) = delete;
+				ScheduledAt& operator=(const ScheduledAt&) = delete;
+			private:
+				boost::optional<std::chrono::system_clock::time_point> mPrevious;
+		};
+
+		//add routes for this instance's parameters and inports to a table for the OSC ingest port
+		//call from the controller thread
+		void addIngestRoutes(OSCIngest::Routes& routes);
+
+		//set many parameter values at once, they are applied in the same audio period and published once, when RNBO reports them
+		void setParameterValues(const std::vector<std::pair<RNBO::ParameterIndex, RNBO::ParameterValue>>& values);
+
 		void savePreset(std::string name, std::string set_name = std::string(), int index = -1);
 		//returns true if the preset was found and load is being attempted
 		bool loadPreset(std::string name, std::string set_name = std::string());
@@ -81,7 +122,7 @@ class Instance {
 		RNBO::Json currentConfig();
 
 		//register a function to be called when configuration values change
-		//this will be called in the same thread as `processEvents`
+		//this will be called in the same thread as `processControlEvents`
 		void registerConfigChangeCallback(std::function<void()> cb);
 		void registerPresetLoadedCallback(std::function<void(const std::string& presetName, const std::string& setName)> cb);
 		void registerPresetSavedCallback(std::function<void(const std::string& presetName, const std::string& setName)> cb);
@@ -170,23 +211,27 @@ class Instance {
 		};
 
 		struct ParamOSCUpdateData {
-			std::shared_ptr<std::mutex> mutex; //mutex to avoid infinite recursion
-			std::shared_ptr<std::mutex> oscmutex;
-			ossia::net::parameter_base * param = nullptr;
+			ossia::net::parameter_base * param = nullptr; //nullptr if the parameter isn't bound
 			ossia::net::parameter_base * normparam = nullptr;
 			std::string oscaddr;
 
-			//map between string enum value and numeric values, only used for enum params
-			std::unordered_map<std::string, RNBO::ParameterValue> nameToVal;
-			std::unordered_map<int, std::string> valToName;
+			//lookup tables between string enum value and numeric values, only set for enum params
+			std::shared_ptr<const PatcherAttributes::Enum> enums;
 
 			//should params map to/from normalized version?
 			bool usenormalized = false;
 
-			ParamOSCUpdateData();
-			void push_osc(ossia::value val, float normval, OSCCallback cb);
+			//most recent normalized value and whether it has changed since the last snapshot
+			std::atomic<float> normvalue = 0.0f;
+			std::atomic<bool> dirty = false;
+			void track(float norm);
+
+			void push_osc(const ossia::value& val, float normval, const OSCCallback& cb, std::atomic<uint64_t>& suppressed);
 		};
 
+		//returns nullptr if the index isn't bound
+		ParamOSCUpdateData * paramData(RNBO::ParameterIndex index);
+
 		void updatePresetEntries();
 		void handleProgramChange(ProgramChange);
 
@@ -201,10 +246,21 @@ class Instance {
 		void handleMidiCallback(RNBO::MidiEvent e);
 
 		void handleParamUpdate(RNBO::ParameterIndex index, RNBO::ParameterValue value);
+		void publishSnapshot();
+		//push a value RNBO already has to ossia and any mapped OSC, callers guard against recursion
+		void publishParamValue(ParamOSCUpdateData& info, RNBO::ParameterIndex index, RNBO::ParameterValue value);
+		//publish the current value of parameters set through the ingest port since the last call
+		void mirrorIngested();
+		//record a new value for snapshots and the shared memory mirror
+		void trackParam(ParamOSCUpdateData& info, RNBO::ParameterIndex index, RNBO::ParameterValue value, float norm);
 		void handlePresetEvent(const RNBO::PresetEvent& e);
 
 		void handleMetadataUpdate(MetaUpdateCommand update);
 
+		//the RNBO time to use for an OSC driven event, honoring any ScheduledAt in this thread
+		RNBO::MillisecondTime oscEventTime();
+		void updateClockOffset();
+
 		void handleEnumParamOscUpdate(RNBO::ParameterIndex index, const ossia::value& val);
 		void handleFloatParamOscUpdate(RNBO::ParameterIndex index, const ossia::value& val);
 		void handleNormalizedFloatParamOscUpdate(RNBO::ParameterIndex index, const ossia::value& val);
@@ -216,8 +272,44 @@ class Instance {
 		RNBO::ParameterEventInterfaceUniquePtr mParamInterface;
 
 
-		//parameter index -> update data
-		std::map<RNBO::ParameterIndex, ParamOSCUpdateData> mIndexToParam;
+		//parameter index -> update data, sized to the number of parameters at construction and never resized
+		std::vector<ParamOSCUpdateData> mIndexToParam;
+
+		//updates dropped to avoid feedback recursion, for diagnostics
+		std::atomic<uint64_t> mSuppressedParamUpdates = 0;
+		uint64_t mSuppressedParamUpdatesReported = 0;
+		std::chrono::steady_clock::time_point mSuppressedParamUpdatesReportNext;
+		ossia::net::parameter_base* mSuppressedParamUpdatesParam = nullptr;
+
+		//RNBO time minus wall clock milliseconds, for mapping OSC timetags, maintained in processDispatchEvents
+		std::atomic<double> mClockOffsetMs = 0.0;
+		std::atomic<bool> mClockOffsetValid = false;
+		//scheduled OSC events that arrived after their time, for diagnostics
+		std::atomic<uint64_t> mLateOSCEvents = 0;
+		uint64_t mLateOSCEventsReported = 0;
+		ossia::net::parameter_base* mLateOSCEventsParam = nullptr;
+
+		//memory held for the patcher attributes, before and after sharing them across instances
+		void reportAttributeBytes();
+		size_t mAttributeBytesUnsharedReported = SIZE_MAX;
+		size_t mAttributeBytesReported = SIZE_MAX;
+		ossia::net::parameter_base* mAttributeBytesUnsharedParam = nullptr;
+		ossia::net::parameter_base* mAttributeBytesParam = nullptr;
+
+		//values from the OSC ingest port go straight to RNBO, we mirror them into the tree at a low rate
+		std::shared_ptr<OSCIngestTarget> mIngestTarget;
+		std::chrono::steady_clock::time_point mIngestMirrorNext;
+		std::vector<std::pair<ossia::net::node_base *, RNBO::MessageTag>> mIngestInports;
+		//optional, for local processes
+		std::unique_ptr<ShmControl> mShmControl;
+
+		//parameter snapshot stream
+		std::atomic<bool> mSnapshotEnabled = false;
+		std::atomic<bool> mSnapshotFull = false;
+		std::atomic<std::chrono::microseconds> mSnapshotPeriod = std::chrono::microseconds(33333); //set from the network thread
+		std::chrono::steady_clock::time_point mSnapshotNext;
+		std::vector<ossia::value> mSnapshotBuffer;
+		ossia::net::parameter_base* mSnapshotParam = nullptr;
 
 		ossia::net::parameter_base* mActiveParam;
 		ossia::net::parameter_base* mMIDIOutParam;
@@ -230,7 +322,17 @@ class Instance {
 		//keep the parameters so we can clear out when files don't exist
 		std::unordered_map<std::string, ossia::net::parameter_base *> mDataRefNodes;
 
-		Queue<MetaUpdateCommand> mMetaUpdateQueue;
+		std::unique_ptr<Queue<MetaUpdateCommand>> mMetaUpdateQueue; //sized for the patcher once we know it
+
+		//read only informational nodes, index, display name etc, created in batches after construction
+		//so large patchers attach quickly, only touched in the controller thread
+		std::deque<std::function<void()>> mDeferredNodes;
+		bool mDeferredNodesBuilt = false;
+		void buildDeferredNodes();
+
+		std::mutex mTreeMutex;
+		bool mTreeAttached = true; //guarded by mTreeMutex
+		DeferredPushProtocol::Pushes mDispatchPushes; //made on a dispatcher worker, published by processControlEvents, guarded by mTreeMutex
 
 		std::mutex mMIDIMapMutex;
 		std::unordered_map<uint16_t, std::set<RNBO::ParameterIndex>> mParamMIDIMap; //ParamMIDIMap::key() -> [parameter index, param index]
@@ -242,10 +344,11 @@ class Instance {
 		bool mMIDILastReport = false; //if we publish to the above param, it is pretty noisy otherwise
 
 		//name -> value (if any)
-		std::unordered_map<std::string, std::string> mInportMetaDefault;
-		std::unordered_map<std::string, std::string> mOutportMetaDefault;
-		std::unordered_map<RNBO::ParameterIndex, std::string> mParamMetaDefault;
-		std::unordered_map<std::string, std::string> mDataRefMetaDefault;
+		//the serialized defaults are the same for every instance of a patcher so they are interned
+		std::unordered_map<std::string, std::shared_ptr<const std::string>> mInportMetaDefault;
+		std::unordered_map<std::string, std::shared_ptr<const std::string>> mOutportMetaDefault;
+		std::unordered_map<RNBO::ParameterIndex, std::shared_ptr<const std::string>> mParamMetaDefault;
+		std::unordered_map<std::string, std::shared_ptr<const std::string>> mDataRefMetaDefault;
 
 		//mappings that aren't default, to be stored with configuration
 		std::mutex mMetaMapMutex;
@@ -266,6 +369,7 @@ class Instance {
 		//presets
 		ossia::net::parameter_base * mPresetEntries;
 		ossia::net::parameter_base * mPresetIndexes;
+		std::unique_ptr<Listing> mPresetListing;
 		ossia::net::parameter_base * mPresetCount;
 		std::mutex mPresetMutex;
 
@@ -279,10 +383,19 @@ class Instance {
 		ossia::net::parameter_base* mPresetProgramChangeChannelParam;
 		int mPresetProgramChangeChannel = 0; //omni, 17 == none
 
-		Queue<PresetCommand> mPresetCommandQueue;
+		Queue<PresetCommand> mPresetCommandQueue{256};
 
-		std::unordered_map<std::string, ossia::net::parameter_base *> mOutportParam;
-		std::unordered_map<std::string, std::string> mOutportOSCMap; //outport tag -> osc addr that should get sent
+		struct OutportData {
+			ossia::net::parameter_base * param = nullptr;
+			std::string oscaddr; //osc addr that should get sent, if any
+
+			//reused values so we don't allocate per message
+			ossia::value number = 0.0f;
+			ossia::value bang = ossia::impulse {};
+			ossia::value list;
+		};
+		//built at construction, keys never change after that
+		std::unordered_map<RNBO::MessageTag, OutportData> mOutports;
 
 		RNBO::Json mConfig;
 		unsigned int mIndex = 0;
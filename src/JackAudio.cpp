@@ -2,6 +2,7 @@
 #include "JackAudioRecord.h"
 #include "Config.h"
 #include "MIDIMap.h"
+#include "Reactor.h"
 
 #include <jack/midiport.h>
 #include <jack/uuid.h>
@@ -34,6 +35,10 @@ namespace {
 	const auto stats_poll_period = std::chrono::seconds(2);
 	const auto port_poll_timeout = std::chrono::milliseconds(20);
 	const std::string persist_extra_key = "persist_extra";
+	const size_t tap_frames_default = 8192;
+	const int meter_window_ms_default = 50;
+	//UI rate for meters, with shorter windows only the latest is published
+	const auto meter_publish_period = std::chrono::milliseconds(33);
 
 	const std::string CONTROL_CLIENT_NAME("rnbo-control");
 
@@ -573,6 +578,7 @@ void ProcessAudioJack::process(jack_nframes_t nframes) {
 			jack_midi_event_get(&evt, midi_buf, i);
 			if (mProgramChangeQueue && evt.size == 2 && (evt.buffer[0] & 0xF0) == 0xC0) {
 				mProgramChangeQueue->enqueue(ProgramChange { .chan = static_cast<uint8_t>(evt.buffer[0] & 0x0F), .prog = static_cast<uint8_t>(evt.buffer[1]) });
+				Reactor::wake();
 			}
 		}
 	}
@@ -1498,6 +1504,7 @@ void ProcessAudioJack::jackPropertyChangeCallback(jack_uuid_t subject, const cha
 		if (it != mPortUUIDToName.end()) {
 			mPortPropertyUpdates.insert(it->second);
 			mPortPropertyPoll = steady_clock::now() + port_poll_timeout;
+			Reactor::wake();
 			return;
 		}
 	}
@@ -1705,12 +1712,14 @@ void ProcessAudioJack::sendReset() {
 void ProcessAudioJack::portRenamed(jack_port_id_t id, const char * /*old_name*/, const char * /*new_name*/) {
 	if (mPortQueue) {
 		mPortQueue->enqueue(std::make_pair(id, JackPortChange::Rename));
+		Reactor::wake();
 	}
 }
 
 void ProcessAudioJack::jackPortRegistration(jack_port_id_t id, int reg) {
 	if (mPortQueue) {
 		mPortQueue->enqueue(std::make_pair(id, reg != 0 ? JackPortChange::Register : JackPortChange::Unregister));
+		Reactor::wake();
 	}
 }
 
@@ -1718,6 +1727,7 @@ void ProcessAudioJack::portConnected(jack_port_id_t a, jack_port_id_t b, bool /*
 	if (mPortQueue) {
 		mPortQueue->enqueue(std::make_pair(a, JackPortChange::Connection));
 		mPortQueue->enqueue(std::make_pair(b, JackPortChange::Connection));
+		Reactor::wake();
 	}
 }
 
@@ -2176,6 +2186,95 @@ InstanceAudioJack::InstanceAudioJack(
 			}
 		}
 
+		if (config::get<bool>(config::key::InstanceMeters).value_or(false)) {
+			int windowms = std::max(1, config::get<int>(config::key::InstanceMeterWindow).value_or(meter_window_ms_default));
+			size_t window = static_cast<size_t>(static_cast<double>(jack_get_sample_rate(mJackClient)) * windowms / 1000.0);
+			mMetersIn = std::make_unique<MeterBank>(mSampleBufferPtrIn.size(), window);
+			mMetersOut = std::make_unique<MeterBank>(mSampleBufferPtrOut.size(), window);
+
+			auto meters = jack->create_child("meters");
+			meters->set(ossia::net::description_attribute{}, "Peak and RMS of the audio i/o, linear, as [peak, rms] pairs for each channel");
+			{
+				auto n = meters->create_child("in");
+				mMetersInParam = n->create_parameter(ossia::val_type::LIST);
+				n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+			}
+			{
+				auto n = meters->create_child("out");
+				mMetersOutParam = n->create_parameter(ossia::val_type::LIST);
+				n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+			}
+			{
+				auto n = meters->create_child("window_ms");
+				auto p = n->create_parameter(ossia::val_type::INT);
+				n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+				p->push_value(windowms);
+			}
+		}
+
+		//shared memory taps of our outputs, for visualizers and analysis without more jack clients
+		//[{"name": "main", "channels": [0, 1], "frames": 8192}]
+		if (mInstanceConf.contains("taps") && mInstanceConf["taps"].is_array()) {
+			mTapsConf = mInstanceConf["taps"];
+			auto taps = root->create_child("taps");
+			taps->set(ossia::net::description_attribute{}, "Shared memory copies of output channels, see AudioTap.h for the layout");
+			const double sr = static_cast<double>(jack_get_sample_rate(mJackClient));
+			for (auto& t: mTapsConf) {
+				try {
+					std::string name = "tap" + std::to_string(mTaps.size());
+					if (t.contains("name") && t["name"].is_string()) {
+						name = t["name"].get<std::string>();
+					}
+					std::vector<size_t> channels;
+					if (t.contains("channels") && t["channels"].is_array()) {
+						for (auto& c: t["channels"]) {
+							if (c.is_number()) {
+								channels.push_back(static_cast<size_t>(std::max(0, c.get<int>())));
+							}
+						}
+					} else {
+						for (size_t i = 0; i < mSampleBufferPtrOut.size(); i++) {
+							channels.push_back(i);
+						}
+					}
+					size_t frames = tap_frames_default;
+					if (t.contains("frames") && t["frames"].is_number()) {
+						frames = static_cast<size_t>(std::max(64, t["frames"].get<int>()));
+					}
+
+					auto tap = std::make_unique<AudioTap>("rnbo-tap-" + index_s + "-" + std::to_string(mTaps.size()), channels, frames, sr);
+
+					auto n = taps->create_child(name);
+					auto p = n->create_parameter(ossia::val_type::STRING);
+					n->set(ossia::net::description_attribute{}, "Shared memory name of the tap");
+					n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+					p->push_value(tap->name());
+
+					{
+						auto c = n->create_child("channels");
+						auto cp = c->create_parameter(ossia::val_type::LIST);
+						c->set(ossia::net::description_attribute{}, "Output channels in the tap, 0 based");
+						c->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+						std::vector<ossia::value> values;
+						for (auto i: tap->channels()) {
+							values.push_back(static_cast<int>(i));
+						}
+						cp->push_value(values);
+					}
+					{
+						auto f = n->create_child("frames");
+						auto fp = f->create_parameter(ossia::val_type::INT);
+						f->set(ossia::net::description_attribute{}, "Ring size in frames per channel");
+						f->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+						fp->push_value(static_cast<int>(tap->frames()));
+					}
+					mTaps.push_back(std::move(tap));
+				} catch (const std::exception& e) {
+					std::cerr << "failed to create audio tap: " << e.what() << std::endl;
+				}
+			}
+		}
+
 		{
 			mJackMidiIn = jack_port_register(mJackClient,
 					"midiin1",
@@ -2259,6 +2358,9 @@ InstanceAudioJack::~InstanceAudioJack() {
 
 void InstanceAudioJack::addConfig(RNBO::Json& conf) {
 	conf["jack"]["client_name"] = std::string(jack_get_client_name(mJackClient));
+	if (!mTapsConf.is_null()) {
+		conf["taps"] = mTapsConf;
+	}
 }
 
 void InstanceAudioJack::activate() {
@@ -2358,6 +2460,21 @@ void InstanceAudioJack::processEvents() {
 		while (mProgramChangeQueue->try_dequeue(c)) {
 			mProgramChangeCallback(c);
 		}
+
+		if (mMetersIn) {
+			auto now = std::chrono::steady_clock::now();
+			if (now >= mMetersPublishNext) {
+				mMetersPublishNext = now + meter_publish_period;
+				auto publish = [this](MeterBank& bank, ossia::net::parameter_base * param) {
+					if (bank.read(mMetersBuffer)) {
+						std::vector<ossia::value> values(mMetersBuffer.begin(), mMetersBuffer.end());
+						param->push_value(values);
+					}
+				};
+				publish(*mMetersIn, mMetersInParam);
+				publish(*mMetersOut, mMetersOutParam);
+			}
+		}
 	}
 }
 
@@ -2494,6 +2611,10 @@ void InstanceAudioJack::process(jack_nframes_t nframes) {
 	for (auto i = 0; i < mSampleBufferPtrOut.size(); i++)
 		mSampleBufferPtrOut[i] = reinterpret_cast<jack_default_audio_sample_t *>(jack_port_get_buffer(mJackAudioPortOut[i], nframes));
 
+	if (mMetersIn && mMetersIn->process(mSampleBufferPtrIn.data(), nframes)) {
+		Reactor::wake();
+	}
+
 	const auto state = mAudioState.load();
 	if (state == AudioState::Idle || state == AudioState::Stopped) {
 		for (auto i = 0; i < mSampleBufferPtrOut.size(); i++) {
@@ -2634,6 +2755,7 @@ void InstanceAudioJack::process(jack_nframes_t nframes) {
 					//look for program change to change preset
 					if (mProgramChangeQueue && evt.size == 2 && (evt.buffer[0] & 0xF0) == 0xC0) {
 						mProgramChangeQueue->enqueue(ProgramChange { .chan = static_cast<uint8_t>(evt.buffer[0] & 0x0F), .prog = static_cast<uint8_t>(evt.buffer[1]) });
+						Reactor::wake();
 					}
 				}
 
@@ -2689,6 +2811,15 @@ void InstanceAudioJack::process(jack_nframes_t nframes) {
 			}
 		}
 	}
+
+	if (mMetersOut && mMetersOut->process(mSampleBufferPtrOut.data(), nframes)) {
+		Reactor::wake();
+	}
+
+	//taps see exactly what we output, silence included
+	for (auto& tap: mTaps) {
+		tap->write(mSampleBufferPtrOut.data(), mSampleBufferPtrOut.size(), nframes);
+	}
 }
 
 void InstanceAudioJack::jackPortRegistration(jack_port_id_t id, int reg) {
@@ -2696,10 +2827,12 @@ void InstanceAudioJack::jackPortRegistration(jack_port_id_t id, int reg) {
 	//we only care about new registrations (non zero) as jack will auto disconnect unreg
 	if (mPortQueue && reg != 0 && config::get<bool>(config::key::InstanceAutoConnectMIDI)) {
 		mPortQueue->enqueue(id);
+		Reactor::wake();
 	}
 }
 
 void InstanceAudioJack::portConnected(jack_port_id_t a, jack_port_id_t b, bool /*connected*/) {
 	mPortConnectedQueue->enqueue(a);
 	mPortConnectedQueue->enqueue(b);
+	Reactor::wake();
 }
@@ -19,6 +19,8 @@
 #include "InstanceAudio.h"
 #include "ProcessAudio.h"
 #include "Defines.h"
+#include "AudioTap.h"
+#include "Meter.h"
 
 namespace moodycamel {
 template<typename T, size_t MAX_BLOCK_SIZE>
@@ -270,4 +272,16 @@ class InstanceAudioJack : public InstanceAudio {
 
 		std::unordered_map<jack_port_t *, ossia::net::parameter_base *> mPortParamMap;
 		std::function<void()> mConfigChangeCallback = nullptr;
+
+		//optional, computed in the audio thread, published from processEvents
+		std::unique_ptr<MeterBank> mMetersIn;
+		std::unique_ptr<MeterBank> mMetersOut;
+		ossia::net::parameter_base * mMetersInParam = nullptr;
+		ossia::net::parameter_base * mMetersOutParam = nullptr;
+		std::chrono::steady_clock::time_point mMetersPublishNext;
+		std::vector<float> mMetersBuffer;
+
+		//shared memory copies of selected outputs, created at construction and only read by the audio thread after that
+		std::vector<std::unique_ptr<AudioTap>> mTaps;
+		RNBO::Json mTapsConf;
 };
@@ -0,0 +1,168 @@
+#include "Listing.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <ossia/network/generic/generic_device.hpp>
+#include <ossia/network/generic/generic_parameter.hpp>
+
+namespace {
+	//keep pages to something a single websocket message or UDP packet can carry
+	const int max_page_size = 256;
+}
+
+Listing::Listing(ossia::net::node_base * parent, const std::string& what) {
+	{
+		auto n = parent->create_child("version");
+		mVersionParam = n->create_parameter(ossia::val_type::INT);
+		n->set(ossia::net::description_attribute{}, "Incremented every time the " + what + " listing changes");
+		n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+		mVersionParam->push_value(0);
+	}
+
+	{
+		auto n = parent->create_child("delta");
+		mDeltaParam = n->create_parameter(ossia::val_type::LIST);
+		n->set(ossia::net::description_attribute{}, "Changes to the " + what + " listing: from version, to version, then op name arg triples. ops: add (arg: index), remove, rename (arg: new name), index (arg: new index). If you are not at from version, fetch the full listing");
+		n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+	}
+
+	{
+		auto n = parent->create_child("page");
+		auto p = n->create_parameter(ossia::val_type::LIST);
+		n->set(ossia::net::description_attribute{}, "Request part of the " + what + " listing, arguments: offset, count. The result is published to page/data");
+		n->set(ossia::net::access_mode_attribute{}, ossia::access_mode::SET);
+		p->add_callback([this](const ossia::value& val) {
+			if (val.get_type() != ossia::val_type::LIST) {
+				return;
+			}
+			auto l = val.get<std::vector<ossia::value>>();
+			if (l.size() == 2 && l[0].get_type() == ossia::val_type::INT && l[1].get_type() == ossia::val_type::INT) {
+				std::lock_guard<std::mutex> guard(mMutex);
+				publishPage(l[0].get<int>(), l[1].get<int>());
+			}
+		});
+
+		auto d = n->create_child("data");
+		mPageDataParam = d->create_parameter(ossia::val_type::LIST);
+		d->set(ossia::net::description_attribute{}, "The latest requested page: version, offset, total count, then name index pairs");
+		d->set(ossia::net::access_mode_attribute{}, ossia::access_mode::GET);
+	}
+}
+
+bool Listing::update(const std::vector<Entry>& entries) {
+	std::lock_guard<std::mutex> guard(mMutex);
+
+	std::unordered_map<std::string, int> current;
+	current.reserve(mEntries.size());
+	for (const auto& e: mEntries) {
+		current.emplace(e.first, e.second);
+	}
+	std::unordered_map<std::string, int> next;
+	next.reserve(entries.size());
+	for (const auto& e: entries) {
+		next.emplace(e.first, e.second);
+	}
+
+	//renames can't be told apart from a delete and an insert at the same index, they come from rename
+	std::vector<Op> ops;
+	for (const auto& e: mEntries) {
+		if (next.find(e.first) == next.end()) {
+			ops.push_back({"remove", e.first, std::string(), -1});
+		}
+	}
+	for (const auto& e: entries) {
+		auto it = current.find(e.first);
+		if (it == current.end()) {
+			ops.push_back({"add", e.first, std::string(), e.second});
+		} else if (it->second != e.second) {
+			ops.push_back({"index", e.first, std::string(), e.second});
+		}
+	}
+
+	//order changes alone aren't worth a delta but are kept for paging
+	mEntries = entries;
+	if (ops.empty()) {
+		return false;
+	}
+	publish(ops);
+	return true;
+}
+
+void Listing::add(const std::string& name, int index) {
+	std::lock_guard<std::mutex> guard(mMutex);
+	auto it = std::find_if(mEntries.begin(), mEntries.end(), [&name](const Entry& e) { return e.first == name; });
+	if (it == mEntries.end()) {
+		mEntries.emplace_back(name, index);
+		publish({{"add", name, std::string(), index}});
+	} else if (it->second != index) {
+		it->second = index;
+		publish({{"index", name, std::string(), index}});
+	}
+}
+
+void Listing::remove(const std::string& name) {
+	std::lock_guard<std::mutex> guard(mMutex);
+	auto it = std::find_if(mEntries.begin(), mEntries.end(), [&name](const Entry& e) { return e.first == name; });
+	if (it != mEntries.end()) {
+		mEntries.erase(it);
+		publish({{"remove", name, std::string(), -1}});
+	}
+}
+
+void Listing::rename(const std::string& from, const std::string& to) {
+	std::lock_guard<std::mutex> guard(mMutex);
+	auto find = [this](const std::string& name) {
+		return std::find_if(mEntries.begin(), mEntries.end(), [&name](const Entry& e) { return e.first == name; });
+	};
+	if (from == to || find(from) == mEntries.end()) {
+		return;
+	}
+
+	//renaming over an existing entry replaces it
+	std::vector<Op> ops;
+	auto existing = find(to);
+	if (existing != mEntries.end()) {
+		ops.push_back({"remove", to, std::string(), -1});
+		mEntries.erase(existing);
+	}
+	find(from)->first = to;
+	ops.push_back({"rename", from, to, -1});
+	publish(ops);
+}
+
+void Listing::publish(const std::vector<Op>& ops) {
+	std::vector<ossia::value> delta;
+	delta.reserve(2 + ops.size() * 3);
+	delta.push_back(static_cast<int>(mVersion));
+	mVersion++;
+	delta.push_back(static_cast<int>(mVersion));
+	for (const auto& op: ops) {
+		delta.push_back(op.op);
+		delta.push_back(op.name);
+		if (op.op == "rename") {
+			delta.push_back(op.to);
+		} else {
+			delta.push_back(op.index);
+		}
+	}
+	mDeltaParam->push_value(std::move(delta));
+	mVersionParam->push_value(static_cast<int>(mVersion));
+}
+
+void Listing::publishPage(int offset, int count) {
+	const int total = static_cast<int>(mEntries.size());
+	offset = std::clamp(offset, 0, total);
+	count = std::clamp(count, 0, std::min(max_page_size, total - offset));
+
+	std::vector<ossia::value> page;
+	page.reserve(3 + count * 2);
+	page.push_back(static_cast<int>(mVersion));
+	page.push_back(offset);
+	page.push_back(total);
+	for (int i = offset; i < offset + count; i++) {
+		page.push_back(mEntries[i].first);
+		page.push_back(mEntries[i].second);
+	}
+	mPageDataParam->push_value(std::move(page));
+}
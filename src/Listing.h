@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ossia {
+	namespace net {
+		class node_base;
+		class parameter_base;
+	}
+}
+
+//an in memory copy of a listing (presets, patchers, sets) that publishes what changed instead of the whole thing
+//
+//children created under the given node:
+//  version: incremented with every change
+//  delta: [from version, to version, op, name, arg, ...] for each change
+//    op is "add" (arg: index), "remove" (arg: -1), "rename" (arg: new name) or "index" (arg: new index)
+//    clients that aren't at from version have missed something and should fetch the full listing
+//  page: set with [offset, count] to fill page/data with [version, offset, total, name, index, ...]
+//
+//the index is -1 for listings that aren't indexed
+class Listing {
+	public:
+		using Entry = std::pair<std::string, int>; //name, index
+
+		Listing(ossia::net::node_base * parent, const std::string& what);
+
+		Listing(const Listing&) = delete;
+		Listing& operator=(const Listing&) = delete;
+
+		//replace all the entries, in display order, returns false if nothing changed
+		//only reports adds, removes and index changes, call rename first for known renames
+		bool update(const std::vector<Entry>& entries);
+		//add an entry or update its index
+		void add(const std::string& name, int index = -1);
+		void remove(const std::string& name);
+		void rename(const std::string& from, const std::string& to);
+	private:
+		struct Op {
+			std::string op;
+			std::string name;
+			std::string to; //for renames
+			int index = -1;
+		};
+		//call with mMutex held
+		void publish(const std::vector<Op>& ops);
+		void publishPage(int offset, int count);
+
+		std::mutex mMutex;
+		std::vector<Entry> mEntries;
+		uint64_t mVersion = 0;
+
+		ossia::net::parameter_base * mVersionParam = nullptr;
+		ossia::net::parameter_base * mDeltaParam = nullptr;
+		ossia::net::parameter_base * mPageDataParam = nullptr;
+};
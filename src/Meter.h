@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RNBO_METER_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RNBO_METER_SSE 1
+#endif
+
+namespace meter {
+	//the absolute peak and sum of squares of a buffer, 4 samples at a time where we can
+	inline void peak_sumsq(const float * in, size_t n, float& peak, float& sumsq) {
+		size_t i = 0;
+		float p = 0.0f;
+		float s = 0.0f;
+#if defined(RNBO_METER_NEON)
+		float32x4_t vp = vdupq_n_f32(0.0f);
+		float32x4_t vs = vdupq_n_f32(0.0f);
+		for (; i + 4 <= n; i += 4) {
+			float32x4_t v = vld1q_f32(in + i);
+			vp = vmaxq_f32(vp, vabsq_f32(v));
+			vs = vmlaq_f32(vs, v, v);
+		}
+		float lanes[4];
+		vst1q_f32(lanes, vp);
+		p = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+		vst1q_f32(lanes, vs);
+		s = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(RNBO_METER_SSE)
+		const __m128 sign = _mm_set1_ps(-0.0f);
+		__m128 vp = _mm_setzero_ps();
+		__m128 vs = _mm_setzero_ps();
+		for (; i + 4 <= n; i += 4) {
+			__m128 v = _mm_loadu_ps(in + i);
+			vp = _mm_max_ps(vp, _mm_andnot_ps(sign, v));
+			vs = _mm_add_ps(vs, _mm_mul_ps(v, v));
+		}
+		alignas(16) float lanes[4];
+		_mm_store_ps(lanes, vp);
+		p = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+		_mm_store_ps(lanes, vs);
+		s = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+		for (; i < n; i++) {
+			p = std::max(p, std::fabs(in[i]));
+			s += in[i] * in[i];
+		}
+		peak = p;
+		sumsq = s;
+	}
+}
+
+//peak and RMS meters for a set of channels, accumulated in the audio thread over a window
+//and read from any other thread
+class MeterBank {
+	public:
+		MeterBank(size_t channels, size_t windowFrames) :
+			mChannels(channels),
+			mWindowFrames(std::max<size_t>(windowFrames, 1)),
+			mPeakAccum(channels, 0.0f),
+			mSumSqAccum(channels, 0.0),
+			mPeak(new std::atomic<float>[channels]),
+			mRMS(new std::atomic<float>[channels])
+		{
+			for (size_t c = 0; c < mChannels; c++) {
+				mPeak[c].store(0.0f, std::memory_order_relaxed);
+				mRMS[c].store(0.0f, std::memory_order_relaxed);
+			}
+		}
+
+		size_t channels() const { return mChannels; }
+
+		//called from the audio thread, returns true if a window completed
+		bool process(float * const * buffers, size_t nframes) {
+			for (size_t c = 0; c < mChannels; c++) {
+				float peak = 0.0f;
+				float sumsq = 0.0f;
+				if (buffers[c] != nullptr) {
+					meter::peak_sumsq(buffers[c], nframes, peak, sumsq);
+				}
+				mPeakAccum[c] = std::max(mPeakAccum[c], peak);
+				mSumSqAccum[c] += sumsq;
+			}
+			mFrames += nframes;
+			if (mFrames < mWindowFrames) {
+				return false;
+			}
+
+			for (size_t c = 0; c < mChannels; c++) {
+				mPeak[c].store(mPeakAccum[c], std::memory_order_relaxed);
+				mRMS[c].store(static_cast<float>(std::sqrt(mSumSqAccum[c] / static_cast<double>(mFrames))), std::memory_order_relaxed);
+				mPeakAccum[c] = 0.0f;
+				mSumSqAccum[c] = 0.0;
+			}
+			mFrames = 0;
+			mGeneration.fetch_add(1, std::memory_order_release);
+			return true;
+		}
+
+		//fill out with peak, rms pairs for each channel, returns false if there hasn't been a new window since the last read
+		//channels may come from adjacent windows if the audio thread completes one while we read
+		bool read(std::vector<float>& out) {
+			auto gen = mGeneration.load(std::memory_order_acquire);
+			if (gen == mReadGeneration) {
+				return false;
+			}
+			mReadGeneration = gen;
+			out.resize(mChannels * 2);
+			for (size_t c = 0; c < mChannels; c++) {
+				out[c * 2] = mPeak[c].load(std::memory_order_relaxed);
+				out[c * 2 + 1] = mRMS[c].load(std::memory_order_relaxed);
+			}
+			return true;
+		}
+	private:
+		size_t mChannels;
+		size_t mWindowFrames;
+
+		//only accessed in the audio thread
+		std::vector<float> mPeakAccum;
+		std::vector<double> mSumSqAccum;
+		size_t mFrames = 0;
+
+		std::unique_ptr<std::atomic<float>[]> mPeak;
+		std::unique_ptr<std::atomic<float>[]> mRMS;
+		std::atomic<uint32_t> mGeneration = 0;
+		//only accessed by the reader
+		uint32_t mReadGeneration = 0;
+};
@@ -0,0 +1,469 @@
+#include "NamespaceServer.h"
+
+#include <array>
+#include <iostream>
+#include <random>
+
+#include <boost/container/small_vector.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include <ossia/network/base/device.hpp>
+#include <ossia/network/base/node.hpp>
+#include <ossia/network/base/node_functions.hpp>
+#include <ossia/network/base/parameter.hpp>
+#include <ossia/protocols/oscquery/detail/json_writer.hpp>
+
+#include "QuietTreeChanges.h"
+
+#ifdef RNBO_USE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace http = boost::beast::http;
+using boost::asio::ip::tcp;
+
+namespace {
+	//requests bigger than this are dropped, we only answer GETs
+	const size_t max_request_bytes = 16384;
+
+	std::string make_nonce() {
+		std::random_device rd;
+		std::array<char, 17> buf;
+		snprintf(buf.data(), buf.size(), "%08x%08x", rd(), rd());
+		return std::string(buf.data());
+	}
+
+	//decode %xx escapes, returns false if malformed
+	bool url_decode(std::string_view in, std::string& out) {
+		out.clear();
+		out.reserve(in.size());
+		for (size_t i = 0; i < in.size(); i++) {
+			if (in[i] != '%') {
+				out.push_back(in[i]);
+				continue;
+			}
+			if (i + 2 >= in.size()) {
+				return false;
+			}
+			auto hex = [](char c) -> int {
+				if (c >= '0' && c <= '9') return c - '0';
+				if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+				if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+				return -1;
+			};
+			int hi = hex(in[i + 1]);
+			int lo = hex(in[i + 2]);
+			if (hi < 0 || lo < 0) {
+				return false;
+			}
+			out.push_back(static_cast<char>((hi << 4) | lo));
+			i += 2;
+		}
+		return true;
+	}
+
+#ifdef RNBO_USE_ZLIB
+	bool gzip(const std::string& in, std::string& out) {
+		z_stream zs = {};
+		//15 window bits + 16 selects the gzip wrapper
+		if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+			return false;
+		}
+		out.resize(deflateBound(&zs, static_cast<uLong>(in.size())));
+		zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in.data()));
+		zs.avail_in = static_cast<uInt>(in.size());
+		zs.next_out = reinterpret_cast<Bytef *>(out.data());
+		zs.avail_out = static_cast<uInt>(out.size());
+		int ret = deflate(&zs, Z_FINISH);
+		out.resize(zs.total_out);
+		deflateEnd(&zs);
+		return ret == Z_STREAM_END;
+	}
+#endif
+
+	bool accepts_gzip(std::string_view header) {
+#ifdef RNBO_USE_ZLIB
+		return header.find("gzip") != std::string_view::npos;
+#else
+		(void)header;
+		return false;
+#endif
+	}
+
+	class Session : public std::enable_shared_from_this<Session> {
+		public:
+			Session(tcp::socket socket, NamespaceCache& cache, std::weak_ptr<bool> alive) :
+				mStream(std::move(socket)), mCache(cache), mAlive(alive) { }
+
+			void read() {
+				mRequest = {};
+				mParser.emplace();
+				mParser->body_limit(max_request_bytes);
+				mParser->header_limit(max_request_bytes);
+				http::async_read(mStream, mBuffer, *mParser, [self = shared_from_this()](boost::beast::error_code ec, std::size_t) {
+					if (ec) {
+						self->close();
+						return;
+					}
+					self->mRequest = self->mParser->release();
+					self->respond();
+				});
+			}
+		private:
+			void respond() {
+				if (mAlive.expired()) {
+					close();
+					return;
+				}
+
+				auto& req = mRequest;
+				mResponse = {};
+				mResponse.version(req.version());
+				mResponse.keep_alive(req.keep_alive());
+				mResponse.set(http::field::server, "rnbo namespace cache");
+				mResponse.set(http::field::access_control_allow_origin, "*");
+
+				std::string_view target(req.target().data(), req.target().size());
+				std::string path;
+				if (req.method() != http::verb::get && req.method() != http::verb::head) {
+					mResponse.result(http::status::method_not_allowed);
+				} else if (target.find('?') != std::string_view::npos) {
+					//attribute queries need the live server
+					mResponse.result(http::status::bad_request);
+					mResponse.body() = "only namespace queries are served here";
+				} else if (!url_decode(target, path) || path.empty() || path[0] != '/') {
+					mResponse.result(http::status::bad_request);
+				} else {
+					auto encoding = req[http::field::accept_encoding];
+					bool gz = accepts_gzip(std::string_view(encoding.data(), encoding.size()));
+					auto entry = mCache.get(path, gz);
+					if (!entry) {
+						mResponse.result(http::status::not_found);
+					} else {
+						mResponse.set(http::field::etag, entry->etag);
+						mResponse.set(http::field::cache_control, "no-cache");
+						mResponse.set(http::field::vary, "Accept-Encoding");
+						//weak comparison ignores the W/ prefix, the header may list several tags
+						auto match = req[http::field::if_none_match];
+						if (std::string_view(match.data(), match.size()).find(std::string_view(entry->etag).substr(2)) != std::string_view::npos) {
+							mResponse.result(http::status::not_modified);
+						} else {
+							mResponse.result(http::status::ok);
+							mResponse.set(http::field::content_type, "application/json");
+							if (gz && !entry->gzip.empty()) {
+								mResponse.set(http::field::content_encoding, "gzip");
+								mResponse.body() = entry->gzip;
+							} else {
+								mResponse.body() = entry->body;
+							}
+						}
+					}
+				}
+				if (req.method() == http::verb::head) {
+					auto size = mResponse.body().size();
+					mResponse.body().clear();
+					mResponse.prepare_payload();
+					mResponse.content_length(size);
+				} else {
+					mResponse.prepare_payload();
+				}
+
+				http::async_write(mStream, mResponse, [self = shared_from_this()](boost::beast::error_code ec, std::size_t) {
+					if (ec || !self->mResponse.keep_alive()) {
+						self->close();
+						return;
+					}
+					self->read();
+				});
+			}
+
+			void close() {
+				boost::beast::error_code ec;
+				mStream.socket().shutdown(tcp::socket::shutdown_send, ec);
+			}
+
+			boost::beast::tcp_stream mStream;
+			boost::beast::flat_buffer mBuffer;
+			boost::optional<http::request_parser<http::string_body>> mParser;
+			http::request<http::string_body> mRequest;
+			http::response<http::string_body> mResponse;
+			NamespaceCache& mCache;
+			std::weak_ptr<bool> mAlive;
+	};
+}
+
+NamespaceCache::NamespaceCache(ossia::net::device_base& device) :
+	protocol_base(flags{SupportsMultiplex}),
+	mDevice(device),
+	mNonce(make_nonce())
+{
+	mDevice.on_node_created.connect<&NamespaceCache::onNodeChanged>(this);
+	mDevice.on_node_removing.connect<&NamespaceCache::onNodeChanged>(this);
+	mDevice.on_node_renamed.connect<&NamespaceCache::onNodeRenamed>(this);
+	mDevice.on_parameter_created.connect<&NamespaceCache::onParameterChanged>(this);
+	mDevice.on_parameter_removing.connect<&NamespaceCache::onParameterChanged>(this);
+	mDevice.on_attribute_modified.connect<&NamespaceCache::onAttributeModified>(this);
+}
+
+void NamespaceCache::split(const ossia::net::node_base * node) {
+	std::lock_guard<std::mutex> guard(mMutex);
+	mSplit.insert(node);
+}
+
+const ossia::net::node_base * NamespaceCache::bucketFor(const ossia::net::node_base& node) const {
+	//ancestors, node first, root last
+	boost::container::small_vector<const ossia::net::node_base *, 8> chain;
+	for (auto cur = &node; cur != nullptr; cur = cur->get_parent()) {
+		chain.push_back(cur);
+	}
+
+	//root, /rnbo, /rnbo/<bucket>
+	const size_t depth = chain.size();
+	if (depth < 3) {
+		return nullptr;
+	}
+	auto top = chain[depth - 3];
+	if (mSplit.count(top)) {
+		return depth > 3 ? chain[depth - 4] : nullptr;
+	}
+	return top;
+}
+
+void NamespaceCache::bucketsBelow(const ossia::net::node_base& node, std::vector<const ossia::net::node_base *>& buckets) const {
+	if (bucketFor(node) == &node) {
+		buckets.push_back(&node);
+		return;
+	}
+	//in the order the writer visits them
+	for (const auto& c: node.children()) {
+		bucketsBelow(*c, buckets);
+	}
+}
+
+NamespaceCache::Fragment& NamespaceCache::fragment(const ossia::net::node_base& bucket) {
+	auto values = mBucketValues[&bucket];
+	auto it = mFragments.find(&bucket);
+	if (it == mFragments.end() || it->second.values != values) {
+		auto json = ossia::oscquery::json_writer::query_namespace(bucket);
+		auto& f = mFragments[&bucket];
+		f.json.assign(json.GetString(), json.GetSize());
+		f.values = values;
+		return f;
+	}
+	return it->second;
+}
+
+void NamespaceCache::compose(const ossia::net::node_base& node, Cached& cached) {
+	auto json = ossia::oscquery::json_writer::query_namespace(node);
+	std::string body(json.GetString(), json.GetSize());
+
+	//a bucket serializes the same on its own as it does inside its parent, find where each one is
+	std::vector<const ossia::net::node_base *> buckets;
+	bucketsBelow(node, buckets);
+	cached.between.clear();
+	cached.spliced.clear();
+	size_t pos = 0;
+	for (auto bucket: buckets) {
+		auto& f = fragment(*bucket);
+		auto at = body.find(f.json, pos);
+		if (at == std::string::npos) {
+			cached.between.clear();
+			cached.spliced.clear();
+			break;
+		}
+		cached.between.emplace_back(body, pos, at - pos);
+		cached.spliced.emplace_back(bucket, f.values);
+		pos = at + f.json.size();
+	}
+	if (cached.spliced.size() == buckets.size()) {
+		cached.between.emplace_back(body, pos);
+	}
+
+	cached.entry = newEntry();
+	cached.entry->body = std::move(body);
+}
+
+std::shared_ptr<NamespaceCache::Entry> NamespaceCache::newEntry() {
+	auto entry = std::make_shared<Entry>();
+	//weak, the gzip and plain bodies share it
+	entry->etag = "W/\"" + mNonce + "-" + std::to_string(++mBodies) + "\"";
+	return entry;
+}
+
+void NamespaceCache::valueChanged(const ossia::net::node_base& node) {
+	std::lock_guard<std::mutex> guard(mMutex);
+	mValues++;
+	if (auto bucket = bucketFor(node)) {
+		mBucketValues[bucket]++;
+	} else {
+		mAboveValues++;
+	}
+}
+
+void NamespaceCache::attributeChanged(const ossia::net::node_base& node) {
+	std::lock_guard<std::mutex> guard(mMutex);
+	mValues++;
+	if (auto bucket = bucketFor(node)) {
+		mBucketValues[bucket]++;
+	} else {
+		mAboveValues++;
+	}
+}
+
+void NamespaceCache::structureChanged() {
+	//node addresses might be reused, start over
+	std::lock_guard<std::mutex> guard(mMutex);
+	mBucketValues.clear();
+	mFragments.clear();
+	mCache.clear();
+}
+
+std::shared_ptr<const NamespaceCache::Entry> NamespaceCache::get(const std::string& path, bool gzip) {
+	auto node = ossia::net::find_node(mDevice.get_root_node(), path);
+	if (node == nullptr) {
+		return nullptr;
+	}
+
+	std::shared_ptr<Entry> entry;
+	{
+		std::lock_guard<std::mutex> guard(mMutex);
+		auto bucket = bucketFor(*node);
+		auto& cached = mCache[path];
+		if (cached.entry && cached.bucket != bucket) {
+			cached = {};
+		}
+		cached.bucket = bucket;
+
+		if (bucket) {
+			auto values = mBucketValues[bucket];
+			if (!cached.entry || cached.values != values) {
+				cached.entry = newEntry();
+				if (node == bucket) {
+					cached.entry->body = fragment(*bucket).json;
+				} else {
+					auto json = ossia::oscquery::json_writer::query_namespace(*node);
+					cached.entry->body.assign(json.GetString(), json.GetSize());
+				}
+				cached.values = values;
+			}
+		} else {
+			const bool spliced = !cached.between.empty();
+			const uint64_t values = spliced ? mAboveValues : mValues;
+			if (!cached.entry || cached.values != values) {
+				compose(*node, cached);
+				cached.values = cached.between.empty() ? mValues : mAboveValues;
+			} else if (spliced) {
+				//only serialize the buckets that changed
+				bool stale = false;
+				for (const auto& s: cached.spliced) {
+					if (mBucketValues[s.first] != s.second) {
+						stale = true;
+						break;
+					}
+				}
+				if (stale) {
+					std::string body;
+					body.reserve(cached.entry->body.size());
+					for (size_t i = 0; i < cached.spliced.size(); i++) {
+						auto& f = fragment(*cached.spliced[i].first);
+						body += cached.between[i];
+						body += f.json;
+						cached.spliced[i].second = f.values;
+					}
+					body += cached.between.back();
+					cached.entry = newEntry();
+					cached.entry->body = std::move(body);
+				}
+			}
+		}
+		entry = cached.entry;
+	}
+
+#ifdef RNBO_USE_ZLIB
+	//only compress what is asked for, once
+	if (gzip && entry->gzip.empty() && !::gzip(entry->body, entry->gzip)) {
+		entry->gzip.clear();
+	}
+#else
+	(void)gzip;
+#endif
+	return entry;
+}
+
+void NamespaceCache::onNodeChanged(const ossia::net::node_base&) {
+	if (!QuietTreeChanges::active()) {
+		structureChanged();
+	}
+}
+
+void NamespaceCache::onNodeRenamed(const ossia::net::node_base&, const std::string&) {
+	if (!QuietTreeChanges::active()) {
+		structureChanged();
+	}
+}
+
+void NamespaceCache::onParameterChanged(const ossia::net::parameter_base&) {
+	if (!QuietTreeChanges::active()) {
+		structureChanged();
+	}
+}
+
+void NamespaceCache::onAttributeModified(const ossia::net::node_base& node, std::string_view) {
+	if (!QuietTreeChanges::active()) {
+		attributeChanged(node);
+	}
+}
+
+bool NamespaceCache::pull(ossia::net::parameter_base&) {
+	return false;
+}
+
+bool NamespaceCache::push(const ossia::net::parameter_base& param, const ossia::value&) {
+	valueChanged(param.get_node());
+	return true;
+}
+
+bool NamespaceCache::push_raw(const ossia::net::full_parameter_data&) {
+	//not in the tree, nothing to do
+	return true;
+}
+
+bool NamespaceCache::echo_incoming_message(const ossia::net::message_origin_identifier&, const ossia::net::parameter_base& param, const ossia::value&) {
+	valueChanged(param.get_node());
+	return true;
+}
+
+bool NamespaceCache::observe(ossia::net::parameter_base&, bool) {
+	return true;
+}
+
+bool NamespaceCache::update(ossia::net::node_base&) {
+	return false;
+}
+
+NamespaceHTTPServer::NamespaceHTTPServer(boost::asio::io_context& context, uint16_t port, NamespaceCache& cache) :
+	mAcceptor(context, tcp::endpoint(tcp::v4(), port)),
+	mCache(cache),
+	mAlive(std::make_shared<bool>(true))
+{
+	accept();
+}
+
+NamespaceHTTPServer::~NamespaceHTTPServer() {
+	mAlive.reset();
+	boost::system::error_code ec;
+	mAcceptor.close(ec);
+}
+
+void NamespaceHTTPServer::accept() {
+	mAcceptor.async_accept([this, alive = std::weak_ptr<bool>(mAlive)](boost::system::error_code ec, tcp::socket socket) {
+		if (alive.expired() || ec == boost::asio::error::operation_aborted) {
+			return;
+		}
+		if (!ec) {
+			std::make_shared<Session>(std::move(socket), mCache, alive)->read();
+		}
+		accept();
+	});
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+#include <ossia/network/base/protocol.hpp>
+
+namespace ossia {
+	namespace net {
+		class device_base;
+	}
+}
+
+//keeps serialized OSCQuery namespace replies around until something under them changes
+//changes are tracked per bucket: each child of /rnbo, except split nodes like /rnbo/inst whose children are buckets of their own
+//every bucket keeps a serialized fragment, replies above the buckets, like "/", are the fragments spliced together
+//so a value change only serializes the bucket it happened in again
+//values are seen by exposing this to the device's multiplex protocol, structure and attributes through device signals
+class NamespaceCache : public ossia::net::protocol_base {
+	public:
+		struct Entry {
+			std::string body;
+			std::string gzip; //empty until requested, or if we cannot compress
+			//names this body, values included, any change to it gets a new entry with a new tag
+			std::string etag;
+		};
+
+		//expose to the device's protocol, it must not outlive the device
+		NamespaceCache(ossia::net::device_base& device);
+
+		NamespaceCache(const NamespaceCache&) = delete;
+		NamespaceCache& operator=(const NamespaceCache&) = delete;
+
+		//children of split nodes are tracked separately, call before serving
+		void split(const ossia::net::node_base * node);
+
+		//drop everything, for changes that were made under QuietTreeChanges
+		void structureChanged();
+
+		//the namespace for path, serialized if it changed since the last call, nullptr if the path doesn't exist
+		//call from the thread that runs the ossia context
+		std::shared_ptr<const Entry> get(const std::string& path, bool gzip);
+
+		virtual bool pull(ossia::net::parameter_base&) override;
+		virtual bool push(const ossia::net::parameter_base& param, const ossia::value& v) override;
+		virtual bool push_raw(const ossia::net::full_parameter_data& param) override;
+		virtual bool echo_incoming_message(const ossia::net::message_origin_identifier& id, const ossia::net::parameter_base& param, const ossia::value& v) override;
+		virtual bool observe(ossia::net::parameter_base& param, bool) override;
+		virtual bool update(ossia::net::node_base& node_base) override;
+	private:
+		struct Fragment {
+			std::string json;
+			uint64_t values = 0;
+		};
+		struct Cached {
+			std::shared_ptr<Entry> entry;
+			const ossia::net::node_base * bucket = nullptr; //nullptr above the buckets
+			uint64_t values = 0; //of the bucket, or of the nodes above the buckets, when serialized
+			//above the buckets: the text around the bucket fragments and the fragments that go in it
+			//empty if the fragments couldn't be found, then any value change serializes it again
+			std::vector<std::string> between;
+			std::vector<std::pair<const ossia::net::node_base *, uint64_t>> spliced;
+		};
+
+		//call with mMutex held
+		const ossia::net::node_base * bucketFor(const ossia::net::node_base& node) const;
+		void bucketsBelow(const ossia::net::node_base& node, std::vector<const ossia::net::node_base *>& buckets) const;
+		Fragment& fragment(const ossia::net::node_base& bucket);
+		void compose(const ossia::net::node_base& node, Cached& cached);
+		//an empty entry with a tag no other body has had
+		std::shared_ptr<Entry> newEntry();
+
+		void valueChanged(const ossia::net::node_base& node);
+		void attributeChanged(const ossia::net::node_base& node);
+
+		void onNodeChanged(const ossia::net::node_base& node);
+		void onNodeRenamed(const ossia::net::node_base& node, const std::string&);
+		void onParameterChanged(const ossia::net::parameter_base& param);
+		void onAttributeModified(const ossia::net::node_base& node, std::string_view);
+
+		ossia::net::device_base& mDevice;
+		std::string mNonce; //so etags from a previous run never match
+
+		std::mutex mMutex;
+		std::unordered_set<const ossia::net::node_base *> mSplit;
+		std::unordered_map<const ossia::net::node_base *, uint64_t> mBucketValues;
+		std::unordered_map<const ossia::net::node_base *, Fragment> mFragments;
+		uint64_t mAboveValues = 1; //values of nodes that aren't in a bucket
+		uint64_t mValues = 1; //any value
+		uint64_t mBodies = 0; //numbers the entry bodies for their etags
+		std::unordered_map<std::string, Cached> mCache;
+};
+
+//serves cached namespace replies over HTTP with ETag/If-None-Match and gzip
+//only plain namespace queries are answered, attribute queries and websockets stay with the OSCQuery server
+class NamespaceHTTPServer {
+	public:
+		//throws if the port cannot be opened
+		//the cache must outlive the server
+		NamespaceHTTPServer(boost::asio::io_context& context, uint16_t port, NamespaceCache& cache);
+		~NamespaceHTTPServer();
+
+		NamespaceHTTPServer(const NamespaceHTTPServer&) = delete;
+		NamespaceHTTPServer& operator=(const NamespaceHTTPServer&) = delete;
+	private:
+		void accept();
+
+		boost::asio::ip::tcp::acceptor mAcceptor;
+		NamespaceCache& mCache;
+		//sessions can outlive us, they check this before touching the cache
+		std::shared_ptr<bool> mAlive;
+};
@@ -0,0 +1,658 @@
+#include "OSCBundleProtocol.h"
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <cerrno>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+#include <ossia/network/base/node.hpp>
+#include <ossia/network/base/parameter.hpp>
+#include <ossia/network/base/parameter_data.hpp>
+#include <ossia/network/value/value.hpp>
+
+#include <boost/asio/ip/multicast.hpp>
+
+namespace {
+	const std::string_view bundle_header("#bundle\0", 8);
+	//header plus timetag
+	const size_t bundle_overhead = 16;
+	//values aren't scheduled, they apply as soon as they arrive
+	const uint64_t timetag_immediate = 1;
+
+	const std::array<std::string, 3> priority_names = { "high", "normal", "low" };
+
+	//state a client needs to stay in sync gets ahead of everything else
+	const std::vector<std::pair<std::string, OSCBundleProtocol::Priority>> default_priorities = {
+		{"/rnbo/jack/transport", OSCBundleProtocol::Priority::High},
+		{"/rnbo/inst/control/sets", OSCBundleProtocol::Priority::High},
+	};
+
+	//is addr equal to or inside the subtree at prefix
+	bool in_subtree(std::string_view addr, std::string_view prefix) {
+		if (prefix.size() > 0 && prefix.back() == '/') {
+			prefix.remove_suffix(1);
+		}
+		if (addr.size() < prefix.size() || addr.compare(0, prefix.size(), prefix) != 0) {
+			return false;
+		}
+		return addr.size() == prefix.size() || addr[prefix.size()] == '/';
+	}
+
+	//is any segment of addr equal to name
+	bool has_segment(std::string_view addr, std::string_view name) {
+		size_t pos = 0;
+		while ((pos = addr.find(name, pos)) != std::string_view::npos) {
+			size_t end = pos + name.size();
+			if (pos > 0 && addr[pos - 1] == '/' && (end == addr.size() || addr[end] == '/')) {
+				return true;
+			}
+			pos = end;
+		}
+		return false;
+	}
+
+	bool accepts(const OSCBundleProtocol::Options& options, std::string_view addr) {
+		if (options.filters.empty()) {
+			return true;
+		}
+		for (const auto& f: options.filters) {
+			if (in_subtree(addr, f)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	size_t element_size(const char * data) {
+		return 4 + (
+			(static_cast<uint32_t>(static_cast<uint8_t>(data[0])) << 24) |
+			(static_cast<uint32_t>(static_cast<uint8_t>(data[1])) << 16) |
+			(static_cast<uint32_t>(static_cast<uint8_t>(data[2])) << 8) |
+			static_cast<uint32_t>(static_cast<uint8_t>(data[3])));
+	}
+
+	void write_u32(std::vector<char>& out, uint32_t v) {
+		out.push_back(static_cast<char>((v >> 24) & 0xFF));
+		out.push_back(static_cast<char>((v >> 16) & 0xFF));
+		out.push_back(static_cast<char>((v >> 8) & 0xFF));
+		out.push_back(static_cast<char>(v & 0xFF));
+	}
+
+	void write_float(std::vector<char>& out, float f) {
+		uint32_t v;
+		std::memcpy(&v, &f, sizeof(v));
+		write_u32(out, v);
+	}
+
+	//null terminated and padded to 4 bytes
+	void write_string(std::vector<char>& out, std::string_view s) {
+		out.insert(out.end(), s.begin(), s.end());
+		size_t pad = 4 - (s.size() % 4);
+		out.insert(out.end(), pad, '\0');
+	}
+
+	//append type tags and arguments, returns false for values we cannot represent
+	bool encode_value(const ossia::value& v, std::string& tags, std::vector<char>& args) {
+		switch (v.get_type()) {
+			case ossia::val_type::FLOAT:
+				tags.push_back('f');
+				write_float(args, v.get<float>());
+				return true;
+			case ossia::val_type::INT:
+				tags.push_back('i');
+				write_u32(args, static_cast<uint32_t>(v.get<int>()));
+				return true;
+			case ossia::val_type::BOOL:
+				tags.push_back(v.get<bool>() ? 'T' : 'F');
+				return true;
+			case ossia::val_type::IMPULSE:
+				tags.push_back('I');
+				return true;
+			case ossia::val_type::STRING:
+				tags.push_back('s');
+				write_string(args, v.get<std::string>());
+				return true;
+			case ossia::val_type::VEC2F:
+				for (auto f: v.get<ossia::vec2f>()) {
+					tags.push_back('f');
+					write_float(args, f);
+				}
+				return true;
+			case ossia::val_type::VEC3F:
+				for (auto f: v.get<ossia::vec3f>()) {
+					tags.push_back('f');
+					write_float(args, f);
+				}
+				return true;
+			case ossia::val_type::VEC4F:
+				for (auto f: v.get<ossia::vec4f>()) {
+					tags.push_back('f');
+					write_float(args, f);
+				}
+				return true;
+			case ossia::val_type::LIST:
+				for (const auto& e: v.get<std::vector<ossia::value>>()) {
+					//nested lists are sent as OSC 1.1 arrays
+					bool nested = e.get_type() == ossia::val_type::LIST;
+					if (nested) {
+						tags.push_back('[');
+					}
+					if (!encode_value(e, tags, args)) {
+						return false;
+					}
+					if (nested) {
+						tags.push_back(']');
+					}
+				}
+				return true;
+			default:
+				return false;
+		}
+	}
+}
+
+OSCBundleProtocol::Options OSCBundleProtocol::Options::fromJson(const RNBO::Json& json) {
+	Options options;
+	if (!json.is_object()) {
+		return options;
+	}
+	if (json.contains("max_messages_per_second") && json["max_messages_per_second"].is_number()) {
+		options.maxMessagesPerSecond = static_cast<size_t>(std::max(0.0, json["max_messages_per_second"].get<double>()));
+	}
+	if (json.contains("max_bytes_per_second") && json["max_bytes_per_second"].is_number()) {
+		options.maxBytesPerSecond = static_cast<size_t>(std::max(0.0, json["max_bytes_per_second"].get<double>()));
+	}
+	if (json.contains("max_queue") && json["max_queue"].is_number()) {
+		options.maxQueue = static_cast<size_t>(std::max(0.0, json["max_queue"].get<double>()));
+	}
+	if (json.contains("filters") && json["filters"].is_array()) {
+		for (const auto& f: json["filters"]) {
+			if (f.is_string()) {
+				options.filters.push_back(f.get<std::string>());
+			}
+		}
+	}
+	if (json.contains("multicast_ttl") && json["multicast_ttl"].is_number_integer()) {
+		options.multicastTTL = std::clamp(json["multicast_ttl"].get<int>(), 0, 255);
+	}
+	if (json.contains("priorities") && json["priorities"].is_object()) {
+		for (const auto& [addr, v]: json["priorities"].items()) {
+			if (!v.is_string()) {
+				continue;
+			}
+			auto it = std::find(priority_names.begin(), priority_names.end(), v.get<std::string>());
+			if (it != priority_names.end()) {
+				options.priorities.push_back({addr, static_cast<Priority>(std::distance(priority_names.begin(), it))});
+			}
+		}
+	}
+	return options;
+}
+
+RNBO::Json OSCBundleProtocol::Options::toJson() const {
+	RNBO::Json json = RNBO::Json::object();
+	json["max_messages_per_second"] = maxMessagesPerSecond;
+	json["max_bytes_per_second"] = maxBytesPerSecond;
+	json["max_queue"] = maxQueue;
+	json["filters"] = filters;
+	RNBO::Json p = RNBO::Json::object();
+	for (const auto& [addr, priority]: priorities) {
+		p[addr] = priority_names[static_cast<size_t>(priority)];
+	}
+	json["priorities"] = p;
+	json["multicast_ttl"] = multicastTTL;
+	return json;
+}
+
+bool OSCBundleProtocol::Options::unrestricted() const {
+	return maxMessagesPerSecond == 0 && maxBytesPerSecond == 0 && filters.empty() && priorities.empty();
+}
+
+OSCBundleProtocol::OSCBundleProtocol(boost::asio::io_context& context, size_t mtu) :
+	protocol_base(flags{SupportsMultiplex}),
+	mContext(context),
+	mSocket4(context, boost::asio::ip::udp::v4()),
+	mMTU(std::max(mtu, bundle_overhead + 64))
+{
+	mSocket4.non_blocking(true);
+}
+
+OSCBundleProtocol::~OSCBundleProtocol() {
+	boost::system::error_code ec;
+	mSocket4.close(ec);
+	if (mSocket6) {
+		mSocket6->close(ec);
+	}
+}
+
+bool OSCBundleProtocol::pull(ossia::net::parameter_base&) {
+	return false;
+}
+
+bool OSCBundleProtocol::push(const ossia::net::parameter_base& param, const ossia::value& v) {
+	return append(param.get_node().osc_address(), v);
+}
+
+bool OSCBundleProtocol::push_raw(const ossia::net::full_parameter_data& param) {
+	return append(param.address, param.value());
+}
+
+bool OSCBundleProtocol::echo_incoming_message(const ossia::net::message_origin_identifier&, const ossia::net::parameter_base& param, const ossia::value& v) {
+	return append(param.get_node().osc_address(), v);
+}
+
+bool OSCBundleProtocol::observe(ossia::net::parameter_base&, bool) {
+	return true;
+}
+
+bool OSCBundleProtocol::update(ossia::net::node_base&) {
+	return false;
+}
+
+void OSCBundleProtocol::addListener(const std::string& key, const std::string& host, uint16_t port, Options options) {
+	auto listener = std::make_shared<Listener>();
+	boost::asio::ip::udp::resolver resolver(mContext);
+	listener->endpoint = *resolver.resolve(host, std::to_string(port)).begin();
+	listener->options = options;
+	listener->unrestricted = options.unrestricted();
+	listener->budgetLast = std::chrono::steady_clock::now();
+
+	if (listener->endpoint.address().is_multicast()) {
+		listener->socket = std::make_unique<boost::asio::ip::udp::socket>(mContext, listener->endpoint.protocol());
+		listener->socket->set_option(boost::asio::ip::multicast::hops(options.multicastTTL));
+		//so displays on this machine can subscribe too
+		listener->socket->set_option(boost::asio::ip::multicast::enable_loopback(true));
+		listener->socket->non_blocking(true);
+	} else if (listener->endpoint.protocol() == boost::asio::ip::udp::v6() && !mSocket6) {
+		mSocket6.emplace(mContext, boost::asio::ip::udp::v6());
+		mSocket6->non_blocking(true);
+	}
+
+	std::lock_guard<std::mutex> guard(mMutex);
+	mListeners[key] = listener;
+}
+
+bool OSCBundleProtocol::removeListener(const std::string& key) {
+	std::lock_guard<std::mutex> guard(mMutex);
+	return mListeners.erase(key) != 0;
+}
+
+void OSCBundleProtocol::clearListeners() {
+	std::lock_guard<std::mutex> guard(mMutex);
+	mListeners.clear();
+}
+
+bool OSCBundleProtocol::setOptions(const std::string& key, Options options) {
+	std::lock_guard<std::mutex> guard(mMutex);
+	auto it = mListeners.find(key);
+	if (it == mListeners.end()) {
+		return false;
+	}
+	auto& listener = *it->second;
+	if (listener.socket && listener.options.multicastTTL != options.multicastTTL) {
+		boost::system::error_code ec;
+		listener.socket->set_option(boost::asio::ip::multicast::hops(options.multicastTTL), ec);
+	}
+	listener.options = options;
+	listener.unrestricted = options.unrestricted();
+	if (listener.unrestricted) {
+		for (auto& lane: listener.lanes) {
+			lane.data.clear();
+			lane.count = 0;
+		}
+	}
+	return true;
+}
+
+std::vector<std::pair<std::string, OSCBundleProtocol::Stats>> OSCBundleProtocol::stats() {
+	std::vector<std::pair<std::string, Stats>> stats;
+	std::lock_guard<std::mutex> guard(mMutex);
+	for (const auto& [key, listener]: mListeners) {
+		Stats s;
+		s.sent = listener->sent.load(std::memory_order_relaxed);
+		s.bytes = listener->bytes.load(std::memory_order_relaxed);
+		s.dropped = listener->dropped.load(std::memory_order_relaxed);
+		for (const auto& lane: listener->lanes) {
+			s.queued += lane.count;
+		}
+		stats.push_back({key, s});
+	}
+	return stats;
+}
+
+OSCBundleProtocol::Priority OSCBundleProtocol::classify(const Options& options, std::string_view addr) const {
+	size_t longest = 0;
+	bool found = false;
+	Priority priority = Priority::Normal;
+	auto match = [&](const std::vector<std::pair<std::string, Priority>>& entries) {
+		for (const auto& [prefix, p]: entries) {
+			if ((!found || prefix.size() > longest) && in_subtree(addr, prefix)) {
+				found = true;
+				longest = prefix.size();
+				priority = p;
+			}
+		}
+	};
+	match(options.priorities);
+	if (found) {
+		return priority;
+	}
+	match(default_priorities);
+	if (found) {
+		return priority;
+	}
+	if (has_segment(addr, "presets")) {
+		return Priority::High;
+	}
+	if (has_segment(addr, "snapshot")) {
+		return Priority::Low;
+	}
+	return Priority::Normal;
+}
+
+bool OSCBundleProtocol::append(std::string_view addr, const ossia::value& v) {
+	//encode once, outside of the lock, values may be pushed from instance event workers
+	thread_local std::string tags;
+	thread_local std::vector<char> args;
+	thread_local std::vector<char> element;
+	tags.assign(1, ',');
+	args.clear();
+	if (!encode_value(v, tags, args)) {
+		return false;
+	}
+	element.clear();
+	write_u32(element, 0); //size, filled in below
+	write_string(element, addr);
+	write_string(element, tags);
+	element.insert(element.end(), args.begin(), args.end());
+	uint32_t size = static_cast<uint32_t>(element.size() - 4);
+	for (size_t i = 0; i < 4; i++) {
+		element[i] = static_cast<char>((size >> (24 - 8 * i)) & 0xFF);
+	}
+
+	auto queued = [](const Lanes& lanes) -> size_t {
+		return lanes[0].count + lanes[1].count + lanes[2].count;
+	};
+	auto add = [](Lane& lane) {
+		lane.data.insert(lane.data.end(), element.begin(), element.end());
+		lane.count++;
+	};
+
+	std::lock_guard<std::mutex> guard(mMutex);
+	bool shared = false;
+	bool added = false;
+	for (auto& [key, listener]: mListeners) {
+		if (listener->unrestricted) {
+			shared = true;
+			continue;
+		}
+		if (!accepts(listener->options, addr)) {
+			continue;
+		}
+		if (queued(listener->lanes) >= listener->options.maxQueue) {
+			listener->dropped++;
+			continue;
+		}
+		add(listener->lanes[static_cast<size_t>(classify(listener->options, addr))]);
+		added = true;
+	}
+
+	//shared messages never wait for a budget, so order doesn't matter and a single lane does
+	if (shared) {
+		if (queued(mShared) >= Options().maxQueue) {
+			for (auto& [key, listener]: mListeners) {
+				if (listener->unrestricted) {
+					listener->dropped++;
+				}
+			}
+		} else {
+			add(mShared[static_cast<size_t>(Priority::Normal)]);
+			added = true;
+		}
+	}
+
+	if (added) {
+		mPending.store(true, std::memory_order_relaxed);
+	}
+	return true;
+}
+
+size_t OSCBundleProtocol::packetize(Lanes& lanes, Listener * budget) {
+	size_t maxMessages = budget ? budget->options.maxMessagesPerSecond : 0;
+	size_t maxBytes = budget ? budget->options.maxBytesPerSecond : 0;
+
+	//token buckets, allowing up to a second of burst
+	if (budget) {
+		auto now = std::chrono::steady_clock::now();
+		double elapsed = std::chrono::duration<double>(now - budget->budgetLast).count();
+		budget->budgetLast = now;
+		budget->messageTokens = std::min(static_cast<double>(maxMessages), budget->messageTokens + elapsed * maxMessages);
+		budget->byteTokens = std::min(static_cast<double>(maxBytes), budget->byteTokens + elapsed * maxBytes);
+	}
+
+	//there is no meaningful time to stamp, our wall clock means nothing to the receiver, so every bundle is immediate
+	auto begin = [this]() -> std::vector<char>& {
+		if (mPacketCount == mPackets.size()) {
+			mPackets.emplace_back();
+			mPacketMessages.push_back(0);
+		}
+		mPacketMessages[mPacketCount] = 0;
+		auto& packet = mPackets[mPacketCount++];
+		packet.clear();
+		packet.insert(packet.end(), bundle_header.begin(), bundle_header.end());
+		write_u32(packet, static_cast<uint32_t>(timetag_immediate >> 32));
+		write_u32(packet, static_cast<uint32_t>(timetag_immediate & 0xFFFFFFFF));
+		return packet;
+	};
+
+	std::vector<char> * packet = nullptr;
+	bool overbudget = false;
+	size_t consumed = 0;
+	for (auto& lane: lanes) {
+		if (overbudget) {
+			break;
+		}
+		size_t offset = 0;
+		size_t count = 0;
+		while (offset < lane.data.size()) {
+			size_t element = element_size(lane.data.data() + offset);
+
+			//keep order, lower classes wait until higher ones are sent
+			if ((maxMessages > 0 && budget->messageTokens < 1.0) || (maxBytes > 0 && budget->byteTokens < element)) {
+				overbudget = true;
+				break;
+			}
+			if (maxMessages > 0) {
+				budget->messageTokens -= 1.0;
+			}
+			if (maxBytes > 0) {
+				budget->byteTokens -= element;
+			}
+
+			//start a new packet if this one would go over, an oversized element goes out alone
+			if (packet == nullptr || (packet->size() > bundle_overhead && packet->size() + element > mMTU)) {
+				packet = &begin();
+			}
+			packet->insert(packet->end(), lane.data.begin() + offset, lane.data.begin() + offset + element);
+			mPacketMessages[mPacketCount - 1]++;
+			offset += element;
+			count++;
+		}
+		lane.data.erase(lane.data.begin(), lane.data.begin() + offset);
+		lane.count -= count;
+		consumed += count;
+	}
+	return consumed;
+}
+
+void OSCBundleProtocol::flush() {
+	{
+		std::lock_guard<std::mutex> guard(mMutex);
+		if (!mPending.load(std::memory_order_relaxed)) {
+			return;
+		}
+		mPending.store(false, std::memory_order_relaxed);
+		std::swap(mShared, mSharedFlushing);
+		for (auto& [key, listener]: mListeners) {
+			if (!listener->unrestricted) {
+				std::swap(listener->lanes, listener->flushing);
+			}
+		}
+	}
+
+	//listeners are only added and removed in the flushing thread so we can iterate without the lock
+	mPacketCount = 0;
+	mSends.clear();
+
+	//shared packets are built once and sent to every unrestricted listener
+	//messages are counted as sent by sendQueued, once the socket has taken them
+	packetize(mSharedFlushing, nullptr);
+	size_t sharedPackets = mPacketCount;
+	for (auto& [key, listener]: mListeners) {
+		if (listener->unrestricted) {
+			for (size_t i = 0; i < sharedPackets; i++) {
+				mSends.push_back({i, listener.get()});
+			}
+		} else {
+			size_t start = mPacketCount;
+			packetize(listener->flushing, listener.get());
+			for (size_t i = start; i < mPacketCount; i++) {
+				mSends.push_back({i, listener.get()});
+			}
+		}
+	}
+	sendQueued();
+
+	//put back anything we couldn't send ahead of what has been pushed since
+	std::lock_guard<std::mutex> guard(mMutex);
+	for (auto& [key, listener]: mListeners) {
+		if (listener->unrestricted) {
+			continue;
+		}
+		for (size_t l = 0; l < listener->flushing.size(); l++) {
+			auto& left = listener->flushing[l];
+			auto& lane = listener->lanes[l];
+			if (left.count > 0) {
+				left.data.insert(left.data.end(), lane.data.begin(), lane.data.end());
+				std::swap(left.data, lane.data);
+				lane.count += left.count;
+				mPending.store(true, std::memory_order_relaxed);
+			}
+			left.data.clear();
+			left.count = 0;
+		}
+	}
+}
+
+void OSCBundleProtocol::sendQueued() {
+	auto failed = [this](Listener * listener, size_t index, const std::string& msg) {
+		listener->dropped.fetch_add(mPacketMessages[index], std::memory_order_relaxed);
+		//listeners come and go, only report the first failure
+		if (!listener->reportedError) {
+			listener->reportedError = true;
+			std::cerr << "error sending to OSC listener " << listener->endpoint << ": " << msg << std::endl;
+		}
+	};
+	//the sockets are non blocking, a full send buffer is expected under load and isn't worth a report
+	auto full = [this](Listener * listener, size_t index) {
+		listener->dropped.fetch_add(mPacketMessages[index], std::memory_order_relaxed);
+	};
+	auto sent = [this](Listener * listener, size_t index, size_t bytes) {
+		listener->reportedError = false;
+		listener->sent.fetch_add(mPacketMessages[index], std::memory_order_relaxed);
+		listener->bytes.fetch_add(bytes, std::memory_order_relaxed);
+	};
+
+#ifdef __linux__
+	//one system call per batch rather than per packet and destination, batched per socket
+	thread_local std::vector<int> fds;
+	thread_local std::vector<mmsghdr> msgs;
+	thread_local std::vector<iovec> iovs;
+	thread_local std::vector<Listener *> dests;
+	thread_local std::vector<size_t> indexes;
+	fds.clear();
+	for (const auto& [index, listener]: mSends) {
+		int fd = socketFor(*listener).native_handle();
+		if (std::find(fds.begin(), fds.end(), fd) == fds.end()) {
+			fds.push_back(fd);
+		}
+	}
+	for (int fd: fds) {
+		msgs.clear();
+		iovs.clear();
+		dests.clear();
+		indexes.clear();
+		for (const auto& [index, listener]: mSends) {
+			if (socketFor(*listener).native_handle() != fd) {
+				continue;
+			}
+			auto& packet = mPackets[index];
+			iovs.push_back({packet.data(), packet.size()});
+			dests.push_back(listener);
+			indexes.push_back(index);
+		}
+		msgs.resize(iovs.size());
+		for (size_t i = 0; i < msgs.size(); i++) {
+			std::memset(&msgs[i], 0, sizeof(mmsghdr));
+			msgs[i].msg_hdr.msg_name = dests[i]->endpoint.data();
+			msgs[i].msg_hdr.msg_namelen = static_cast<socklen_t>(dests[i]->endpoint.size());
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		size_t i = 0;
+		while (i < msgs.size()) {
+			int r = ::sendmmsg(fd, msgs.data() + i, static_cast<unsigned int>(msgs.size() - i), 0);
+			if (r < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				//the socket buffer is full, the rest would fail the same way so they're dropped
+				if (errno == EAGAIN || errno == EWOULDBLOCK) {
+					for (; i < msgs.size(); i++) {
+						full(dests[i], indexes[i]);
+					}
+					break;
+				}
+				//skip the packet that failed and carry on with the rest
+				failed(dests[i], indexes[i], std::strerror(errno));
+				i++;
+			} else {
+				for (int j = 0; j < r; j++) {
+					sent(dests[i + j], indexes[i + j], msgs[i + j].msg_len);
+				}
+				i += r;
+			}
+		}
+	}
+#else
+	for (const auto& [index, listener]: mSends) {
+		auto& packet = mPackets[index];
+		boost::system::error_code ec;
+		socketFor(*listener).send_to(boost::asio::buffer(packet), listener->endpoint, 0, ec);
+		if (ec == boost::asio::error::would_block) {
+			full(listener, index);
+		} else if (ec) {
+			failed(listener, index, ec.message());
+		} else {
+			sent(listener, index, packet.size());
+		}
+	}
+#endif
+}
+
+boost::asio::ip::udp::socket& OSCBundleProtocol::socketFor(Listener& listener) {
+	if (listener.socket) {
+		return *listener.socket;
+	}
+	if (listener.endpoint.protocol() == boost::asio::ip::udp::v6()) {
+		return mSocket6.get();
+	}
+	return mSocket4;
+}
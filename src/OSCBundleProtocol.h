@@ -0,0 +1,138 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+
+#include <boost/optional.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/udp.hpp>
+
+#include <ossia/network/base/protocol.hpp>
+
+#include "RNBO.h"
+
+//sends values to OSC listeners, aggregating everything pushed between flushes into immediate bundles
+//that fit in a single UDP packet, rather than sending a packet per value
+//each value is encoded once, listeners without filters or budgets share the same packets which are sent
+//to all of them with batched system calls
+//a listener with a multicast address sends the feed once on the wire for every subscriber of the group
+class OSCBundleProtocol : public ossia::net::protocol_base {
+	public:
+		//messages in higher classes are sent first when a listener is over budget
+		enum class Priority {
+			High = 0, //transport, preset and set state
+			Normal,
+			Low //high rate streams like snapshots
+		};
+
+		struct Options {
+			size_t maxMessagesPerSecond = 0; //0 is unlimited
+			size_t maxBytesPerSecond = 0; //0 is unlimited
+			size_t maxQueue = 4096; //messages held while over budget, more than this are dropped
+			std::vector<std::string> filters; //address subtrees to send, empty sends everything
+			std::vector<std::pair<std::string, Priority>> priorities; //address subtree -> class, longest match wins, overrides the defaults
+			int multicastTTL = 1; //hops for multicast listeners, 1 keeps packets on the local network
+
+			static Options fromJson(const RNBO::Json& json);
+			RNBO::Json toJson() const;
+
+			//can this listener share packets with everyone else
+			bool unrestricted() const;
+		};
+
+		struct Stats {
+			uint64_t sent = 0; //messages
+			uint64_t bytes = 0;
+			uint64_t dropped = 0; //over maxQueue, or the socket couldn't take them
+			size_t queued = 0;
+		};
+
+		OSCBundleProtocol(boost::asio::io_context& context, size_t mtu);
+		virtual ~OSCBundleProtocol();
+
+		OSCBundleProtocol(const OSCBundleProtocol&) = delete;
+		OSCBundleProtocol& operator=(const OSCBundleProtocol&) = delete;
+
+		virtual bool pull(ossia::net::parameter_base&) override;
+		virtual bool push(const ossia::net::parameter_base& param, const ossia::value& v) override;
+		virtual bool push_raw(const ossia::net::full_parameter_data& param) override;
+		virtual bool echo_incoming_message(const ossia::net::message_origin_identifier& id, const ossia::net::parameter_base& param, const ossia::value& v) override;
+		virtual bool observe(ossia::net::parameter_base& param, bool) override;
+		virtual bool update(ossia::net::node_base& node_base) override;
+
+		//key is used to refer to the listener later, throws if the host cannot be resolved
+		void addListener(const std::string& key, const std::string& host, uint16_t port, Options options);
+		//returns false if the key isn't found
+		bool removeListener(const std::string& key);
+		void clearListeners();
+		bool setOptions(const std::string& key, Options options);
+
+		//key -> stats
+		std::vector<std::pair<std::string, Stats>> stats();
+
+		//send what has been pushed since the last flush, as budgets allow, anything left stays queued
+		void flush();
+		//is there anything waiting for a flush
+		bool pending() const { return mPending.load(std::memory_order_relaxed); }
+	private:
+		//encoded messages, each prefixed by their size, as they appear in a bundle
+		struct Lane {
+			std::vector<char> data;
+			size_t count = 0;
+		};
+		using Lanes = std::array<Lane, 3>;
+
+		struct Listener {
+			boost::asio::ip::udp::endpoint endpoint;
+			Options options;
+			bool unrestricted = true;
+
+			//only used if restricted
+			Lanes lanes;
+			Lanes flushing;
+			std::chrono::steady_clock::time_point budgetLast;
+			double messageTokens = 0.0;
+			double byteTokens = 0.0;
+
+			std::atomic<uint64_t> dropped = 0;
+			std::atomic<uint64_t> sent = 0;
+			std::atomic<uint64_t> bytes = 0;
+			bool reportedError = false;
+
+			//multicast listeners get their own socket so the TTL doesn't affect anyone else
+			std::unique_ptr<boost::asio::ip::udp::socket> socket;
+		};
+
+		bool append(std::string_view addr, const ossia::value& v);
+		Priority classify(const Options& options, std::string_view addr) const;
+
+		//packetize lanes into mPackets from mPacketCount onward, consuming as budget allows, returns messages consumed
+		size_t packetize(Lanes& lanes, Listener * budget);
+		void sendQueued();
+		boost::asio::ip::udp::socket& socketFor(Listener& listener);
+
+		boost::asio::io_context& mContext;
+		boost::asio::ip::udp::socket mSocket4;
+		boost::optional<boost::asio::ip::udp::socket> mSocket6;
+		size_t mMTU;
+
+		std::mutex mMutex;
+		std::unordered_map<std::string, std::shared_ptr<Listener>> mListeners;
+		Lanes mShared; //for unrestricted listeners
+		std::atomic<bool> mPending = false;
+
+		//only accessed in flush
+		Lanes mSharedFlushing;
+		std::vector<std::vector<char>> mPackets; //reused buffers, only the first mPacketCount are valid
+		std::vector<size_t> mPacketMessages; //messages in each packet
+		size_t mPacketCount = 0;
+		//packet index, destination
+		std::vector<std::pair<size_t, Listener *>> mSends;
+};
@@ -0,0 +1,230 @@
+#include "OSCIngest.h"
+#include "OSCPacket.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include <boost/asio/post.hpp>
+#include <boost/container/small_vector.hpp>
+
+using namespace oscpacket;
+
+OSCIngestTarget::OSCIngestTarget(std::shared_ptr<RNBO::CoreObject> core, size_t numParams) :
+	mCore(core),
+	mNumParams(numParams),
+	mTouched(new std::atomic<bool>[numParams])
+{
+	mInterface = mCore->createParameterInterface(RNBO::ParameterEventInterface::MultiProducer, nullptr);
+	for (size_t i = 0; i < mNumParams; i++) {
+		mTouched[i].store(false, std::memory_order_relaxed);
+	}
+}
+
+OSCIngestTarget::~OSCIngestTarget() {
+	close();
+}
+
+void OSCIngestTarget::close() {
+	mClosed.store(true, std::memory_order_seq_cst);
+	while (mInFlight.load(std::memory_order_seq_cst) > 0) {
+		std::this_thread::yield();
+	}
+}
+
+bool OSCIngestTarget::enter() {
+	mInFlight.fetch_add(1, std::memory_order_seq_cst);
+	if (mClosed.load(std::memory_order_seq_cst)) {
+		leave();
+		return false;
+	}
+	return true;
+}
+
+void OSCIngestTarget::leave() {
+	mInFlight.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+void OSCIngestTarget::touch(RNBO::ParameterIndex index) {
+	mTouched[index].store(true, std::memory_order_relaxed);
+	mAnyTouched.store(true, std::memory_order_release);
+}
+
+void OSCIngestTarget::setParameterValue(RNBO::ParameterIndex index, RNBO::ParameterValue value) {
+	if (index >= mNumParams || !enter()) {
+		return;
+	}
+	//mark first so the instance holds off publishing the change RNBO reports back
+	touch(index);
+	mInterface->setParameterValue(index, mCore->constrainParameterValue(index, value), RNBO_TIMENOW);
+	leave();
+}
+
+void OSCIngestTarget::setNormalizedParameterValue(RNBO::ParameterIndex index, RNBO::ParameterValue value) {
+	if (index >= mNumParams || !enter()) {
+		return;
+	}
+	touch(index);
+	value = mCore->convertFromNormalizedParameterValue(index, std::clamp(value, 0.0, 1.0));
+	mInterface->setParameterValue(index, mCore->constrainParameterValue(index, value), RNBO_TIMENOW);
+	leave();
+}
+
+void OSCIngestTarget::sendMessage(RNBO::MessageTag tag, const RNBO::number * values, size_t count) {
+	if (!enter()) {
+		return;
+	}
+	if (count == 0) {
+		mInterface->sendMessage(tag, static_cast<RNBO::MessageTag>(0), RNBO_TIMENOW);
+	} else if (count == 1) {
+		mInterface->sendMessage(tag, values[0], 0, RNBO_TIMENOW);
+	} else {
+		auto l = RNBO::make_unique<RNBO::list>();
+		for (size_t i = 0; i < count; i++) {
+			l->push(values[i]);
+		}
+		mInterface->sendMessage(tag, std::move(l), 0, RNBO_TIMENOW);
+	}
+	leave();
+}
+
+OSCIngest::OSCIngest(uint16_t port) :
+	mSocket(mContext, boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), port))
+{
+	//sensors send in bursts, give the kernel room to hold them while we catch up
+	boost::system::error_code ec;
+	mSocket.set_option(boost::asio::socket_base::receive_buffer_size(1 << 20), ec);
+
+	receive();
+	mThread = std::thread([this]() {
+		mContext.run();
+	});
+}
+
+OSCIngest::~OSCIngest() {
+	mContext.stop();
+	if (mThread.joinable()) {
+		mThread.join();
+	}
+	boost::system::error_code ec;
+	mSocket.close(ec);
+}
+
+void OSCIngest::setRoutes(std::shared_ptr<const Routes> routes) {
+	boost::asio::post(mContext, [this, routes]() {
+		mRoutes = routes;
+	});
+}
+
+void OSCIngest::receive() {
+	mSocket.async_receive_from(boost::asio::buffer(mBuffer), mSender, [this](const boost::system::error_code& ec, std::size_t size) {
+		if (ec == boost::asio::error::operation_aborted) {
+			return;
+		}
+		if (!ec && mRoutes && !parsePacket(mBuffer.data(), size, *mRoutes, 0)) {
+			std::cerr << "malformed OSC packet from " << mSender << std::endl;
+		}
+		receive();
+	});
+}
+
+bool OSCIngest::parsePacket(const char * data, size_t size, const Routes& routes, int depth) {
+	if (size < 4 || size % 4 != 0) {
+		return false;
+	}
+	if (!is_bundle(data, size)) {
+		return parseMessage(data, size, routes);
+	}
+	if (depth >= max_bundle_depth || size < 16) {
+		return false;
+	}
+
+	//timetags are ignored, everything is applied as it arrives
+	size_t offset = 16;
+	while (offset + 4 <= size) {
+		size_t element = read_u32(data + offset);
+		offset += 4;
+		if (element > size - offset || !parsePacket(data + offset, element, routes, depth + 1)) {
+			return false;
+		}
+		offset += element;
+	}
+	return offset == size;
+}
+
+bool OSCIngest::parseMessage(const char * data, size_t size, const Routes& routes) {
+	size_t offset = 0;
+	std::string_view addr;
+	if (!read_string(data, size, offset, addr) || addr.empty() || addr[0] != '/') {
+		return false;
+	}
+
+	auto it = routes.find(addr);
+	if (it == routes.end()) {
+		return true;
+	}
+
+	//no type tags, treat as a bang
+	std::string_view tags(",");
+	if (offset < size && !read_string(data, size, offset, tags)) {
+		return false;
+	}
+	if (tags.empty() || tags[0] != ',') {
+		return false;
+	}
+
+	boost::container::small_vector<RNBO::number, 16> values;
+	for (size_t i = 1; i < tags.size(); i++) {
+		switch (tags[i]) {
+			case 'i':
+				if (offset + 4 > size) return false;
+				values.push_back(static_cast<RNBO::number>(static_cast<int32_t>(read_u32(data + offset))));
+				offset += 4;
+				break;
+			case 'f':
+				if (offset + 4 > size) return false;
+				values.push_back(static_cast<RNBO::number>(read_f32(data + offset)));
+				offset += 4;
+				break;
+			case 'h':
+				if (offset + 8 > size) return false;
+				values.push_back(static_cast<RNBO::number>(static_cast<int64_t>(read_u64(data + offset))));
+				offset += 8;
+				break;
+			case 'd':
+				if (offset + 8 > size) return false;
+				values.push_back(static_cast<RNBO::number>(read_f64(data + offset)));
+				offset += 8;
+				break;
+			case 'T':
+				values.push_back(1.0);
+				break;
+			case 'F':
+				values.push_back(0.0);
+				break;
+			case 'I':
+			case 'N':
+				break;
+			default:
+				//only numbers are accepted here, anything richer should use the regular OSC port
+				return true;
+		}
+	}
+
+	const auto& route = it->second;
+	switch (route.kind) {
+		case OSCIngestRoute::Kind::Param:
+			if (!values.empty()) {
+				route.target->setParameterValue(route.index, values.front());
+			}
+			break;
+		case OSCIngestRoute::Kind::NormalizedParam:
+			if (!values.empty()) {
+				route.target->setNormalizedParameterValue(route.index, values.front());
+			}
+			break;
+		case OSCIngestRoute::Kind::Inport:
+			route.target->sendMessage(route.tag, values.data(), values.size());
+			break;
+	}
+	return true;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/udp.hpp>
+
+#include "RNBO.h"
+
+//the destination of ingested values for a single instance
+//shared between the instance and any routing table so it stays valid while the ingest thread is using it
+class OSCIngestTarget {
+	public:
+		OSCIngestTarget(std::shared_ptr<RNBO::CoreObject> core, size_t numParams);
+		~OSCIngestTarget();
+
+		OSCIngestTarget(const OSCIngestTarget&) = delete;
+		OSCIngestTarget& operator=(const OSCIngestTarget&) = delete;
+
+		//called from the ingest thread
+		void setParameterValue(RNBO::ParameterIndex index, RNBO::ParameterValue value);
+		void setNormalizedParameterValue(RNBO::ParameterIndex index, RNBO::ParameterValue value);
+		void sendMessage(RNBO::MessageTag tag, const RNBO::number * values, size_t count);
+
+		//stop accepting values, waits for any in flight calls to finish, called by the owning instance
+		void close();
+
+		//for mirroring values back to ossia, called from the owning instance
+		bool anyTouched() { return mAnyTouched.exchange(false, std::memory_order_acquire); }
+		bool touched(RNBO::ParameterIndex index) const { return index < mNumParams && mTouched[index].load(std::memory_order_relaxed); }
+		bool clearTouched(RNBO::ParameterIndex index) { return mTouched[index].exchange(false, std::memory_order_relaxed); }
+		size_t numParams() const { return mNumParams; }
+	private:
+		//returns false if closed
+		bool enter();
+		void leave();
+		void touch(RNBO::ParameterIndex index);
+
+		//declared before the interface so the core outlives it
+		std::shared_ptr<RNBO::CoreObject> mCore;
+		//a producer of its own, RNBO's lock free event queue carries the values to the audio thread
+		RNBO::ParameterEventInterfaceUniquePtr mInterface;
+
+		size_t mNumParams;
+		//parameters set since the last mirror
+		std::unique_ptr<std::atomic<bool>[]> mTouched;
+		std::atomic<bool> mAnyTouched = false;
+
+		std::atomic<bool> mClosed = false;
+		std::atomic<int> mInFlight = 0;
+};
+
+struct OSCIngestRoute {
+	enum class Kind {
+		Param,
+		NormalizedParam,
+		Inport
+	};
+
+	std::shared_ptr<OSCIngestTarget> target;
+	Kind kind = Kind::Param;
+	RNBO::ParameterIndex index = 0; //for params
+	RNBO::MessageTag tag = 0; //for inports
+};
+
+//receives OSC over UDP in its own thread and applies it directly to instances with a precompiled routing table,
+//skipping the ossia tree, for high rate control like sensors
+//values are mirrored back into the tree by the instances at a low rate
+class OSCIngest {
+	public:
+		struct StringHash {
+			using is_transparent = void;
+			size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+		};
+		//OSC address -> destination
+		using Routes = std::unordered_map<std::string, OSCIngestRoute, StringHash, std::equal_to<>>;
+
+		//throws if the port cannot be opened
+		OSCIngest(uint16_t port);
+		~OSCIngest();
+
+		OSCIngest(const OSCIngest&) = delete;
+		OSCIngest& operator=(const OSCIngest&) = delete;
+
+		//replace the routing table, may be called from any thread
+		void setRoutes(std::shared_ptr<const Routes> routes);
+	private:
+		void receive();
+		bool parsePacket(const char * data, size_t size, const Routes& routes, int depth);
+		bool parseMessage(const char * data, size_t size, const Routes& routes);
+
+		boost::asio::io_context mContext;
+		boost::asio::ip::udp::socket mSocket;
+		boost::asio::ip::udp::endpoint mSender;
+		std::array<char, 65536> mBuffer;
+		std::thread mThread;
+
+		//only accessed in the ingest thread, replacements are posted to it
+		std::shared_ptr<const Routes> mRoutes;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#include <boost/optional.hpp>
+
+//helpers for reading OSC packets
+namespace oscpacket {
+	const std::string_view bundle_header("#bundle\0", 8);
+	//seconds between the NTP epoch (1900) and the unix epoch
+	const uint64_t ntp_unix_offset = 2208988800ULL;
+	//bundles may nest, but not forever
+	const int max_bundle_depth = 8;
+
+	inline uint32_t read_u32(const char * data) {
+		return
+			(static_cast<uint32_t>(static_cast<uint8_t>(data[0])) << 24) |
+			(static_cast<uint32_t>(static_cast<uint8_t>(data[1])) << 16) |
+			(static_cast<uint32_t>(static_cast<uint8_t>(data[2])) << 8) |
+			static_cast<uint32_t>(static_cast<uint8_t>(data[3]));
+	}
+
+	inline uint64_t read_u64(const char * data) {
+		return (static_cast<uint64_t>(read_u32(data)) << 32) | read_u32(data + 4);
+	}
+
+	inline float read_f32(const char * data) {
+		uint32_t v = read_u32(data);
+		float f;
+		std::memcpy(&f, &v, sizeof(f));
+		return f;
+	}
+
+	inline double read_f64(const char * data) {
+		uint64_t v = read_u64(data);
+		double d;
+		std::memcpy(&d, &v, sizeof(d));
+		return d;
+	}
+
+	//reads a padded, null terminated string, advancing offset, returns false if it runs off the end
+	inline bool read_string(const char * data, size_t size, size_t& offset, std::string_view& out) {
+		const char * start = data + offset;
+		const char * end = static_cast<const char *>(std::memchr(start, '\0', size - offset));
+		if (end == nullptr) {
+			return false;
+		}
+		out = std::string_view(start, end - start);
+		offset += (out.size() / 4 + 1) * 4;
+		return offset <= size;
+	}
+
+	inline bool is_bundle(const char * data, size_t size) {
+		return size >= bundle_header.size() && std::string_view(data, bundle_header.size()) == bundle_header;
+	}
+
+	//the immediate timetag, or anything we can't place, has no time
+	inline boost::optional<std::chrono::system_clock::time_point> timetag_to_time(uint64_t timetag) {
+		uint64_t secs = timetag >> 32;
+		if (timetag <= 1 || secs < ntp_unix_offset) {
+			return boost::none;
+		}
+		uint64_t nanos = ((timetag & 0xFFFFFFFF) * 1000000000ULL) >> 32;
+		auto since = std::chrono::seconds(secs - ntp_unix_offset) + std::chrono::nanoseconds(nanos);
+		return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(since));
+	}
+}
@@ -0,0 +1,28 @@
+#include "OSCRouteCache.h"
+
+#include <ossia/network/base/node.hpp>
+#include <ossia/network/base/node_functions.hpp>
+#include <ossia/network/base/parameter.hpp>
+
+OSCRouteCache::OSCRouteCache(ossia::net::node_base& root, size_t max) : mRoot(root), mMax(max) {
+}
+
+const std::vector<ossia::net::parameter_base *>& OSCRouteCache::resolve(std::string_view addr) {
+	if (mInvalid.exchange(false) || mCache.size() >= mMax) {
+		mCache.clear();
+	}
+
+	auto it = mCache.find(addr);
+	if (it != mCache.end()) {
+		return it->second;
+	}
+
+	//based on code example from jcelerier
+	std::vector<ossia::net::parameter_base *> params;
+	for (auto n: ossia::net::find_nodes(mRoot, addr)) {
+		if (auto param = n->get_parameter()) {
+			params.push_back(param);
+		}
+	}
+	return mCache.emplace(std::string(addr), std::move(params)).first->second;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ossia {
+	namespace net {
+		class node_base;
+		class parameter_base;
+	}
+}
+
+//resolves OSC addresses and patterns to the parameters they match under a node
+//results are kept until invalidated, the owner invalidates whenever the tree under the node changes
+class OSCRouteCache {
+	public:
+		//root must outlive the cache, max bounds the number of addresses kept as they come from the network
+		OSCRouteCache(ossia::net::node_base& root, size_t max);
+
+		OSCRouteCache(const OSCRouteCache&) = delete;
+		OSCRouteCache& operator=(const OSCRouteCache&) = delete;
+
+		//only call from one thread, copy the result before pushing values as that may invalidate it
+		const std::vector<ossia::net::parameter_base *>& resolve(std::string_view addr);
+
+		//forget everything resolved so far, can be called from any thread
+		void invalidate() { mInvalid = true; }
+	private:
+		//hash that allows std::string_view lookups in std::string keyed maps
+		struct StringHash {
+			using is_transparent = void;
+			size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+		};
+
+		ossia::net::node_base& mRoot;
+		const size_t mMax;
+		std::unordered_map<std::string, std::vector<ossia::net::parameter_base *>, StringHash, std::equal_to<>> mCache;
+		std::atomic<bool> mInvalid = false;
+};
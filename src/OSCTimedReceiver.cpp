@@ -0,0 +1,163 @@
+#include "OSCTimedReceiver.h"
+#include "OSCPacket.h"
+
+#include <iostream>
+#include <vector>
+
+using namespace oscpacket;
+
+OSCTimedReceiver::OSCTimedReceiver(boost::asio::io_context& context, uint16_t port, Callback cb) :
+	mSocket(context, boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), port)),
+	mCallback(cb)
+{
+	receive();
+}
+
+OSCTimedReceiver::~OSCTimedReceiver() {
+	boost::system::error_code ec;
+	mSocket.cancel(ec);
+	mSocket.close(ec);
+}
+
+void OSCTimedReceiver::receive() {
+	mSocket.async_receive_from(boost::asio::buffer(mBuffer), mSender, [this](const boost::system::error_code& ec, std::size_t size) {
+		if (ec == boost::asio::error::operation_aborted) {
+			return;
+		}
+		if (!ec && !parsePacket(mBuffer.data(), size, boost::none, 0)) {
+			std::cerr << "malformed OSC packet from " << mSender << std::endl;
+		}
+		receive();
+	});
+}
+
+bool OSCTimedReceiver::parsePacket(const char * data, size_t size, boost::optional<std::chrono::system_clock::time_point> when, int depth) {
+	if (size < 4 || size % 4 != 0) {
+		return false;
+	}
+	if (!is_bundle(data, size)) {
+		return parseMessage(data, size, when);
+	}
+	if (depth >= max_bundle_depth || size < 16) {
+		return false;
+	}
+
+	//a nested bundle may have its own time
+	auto t = timetag_to_time(read_u64(data + 8));
+	if (t) {
+		when = t;
+	}
+
+	size_t offset = 16;
+	while (offset + 4 <= size) {
+		size_t element = read_u32(data + offset);
+		offset += 4;
+		if (element > size - offset || !parsePacket(data + offset, element, when, depth + 1)) {
+			return false;
+		}
+		offset += element;
+	}
+	return offset == size;
+}
+
+bool OSCTimedReceiver::parseMessage(const char * data, size_t size, boost::optional<std::chrono::system_clock::time_point> when) {
+	size_t offset = 0;
+	std::string_view addr;
+	if (!read_string(data, size, offset, addr) || addr.empty() || addr[0] != '/') {
+		return false;
+	}
+
+	//no type tags, treat as a bang
+	std::string_view tags(",");
+	if (offset < size && !read_string(data, size, offset, tags)) {
+		return false;
+	}
+	if (tags.empty() || tags[0] != ',') {
+		return false;
+	}
+
+	//stack of lists, OSC 1.1 arrays nest
+	std::vector<std::vector<ossia::value>> lists(1);
+	for (size_t i = 1; i < tags.size(); i++) {
+		auto& list = lists.back();
+		switch (tags[i]) {
+			case 'i':
+				if (offset + 4 > size) return false;
+				list.push_back(static_cast<int>(static_cast<int32_t>(read_u32(data + offset))));
+				offset += 4;
+				break;
+			case 'f':
+				{
+					if (offset + 4 > size) return false;
+					uint32_t v = read_u32(data + offset);
+					float f;
+					std::memcpy(&f, &v, sizeof(f));
+					list.push_back(f);
+					offset += 4;
+				}
+				break;
+			case 'h':
+				if (offset + 8 > size) return false;
+				list.push_back(static_cast<int>(static_cast<int64_t>(read_u64(data + offset))));
+				offset += 8;
+				break;
+			case 'd':
+				{
+					if (offset + 8 > size) return false;
+					uint64_t v = read_u64(data + offset);
+					double d;
+					std::memcpy(&d, &v, sizeof(d));
+					list.push_back(static_cast<float>(d));
+					offset += 8;
+				}
+				break;
+			case 's':
+			case 'S':
+				{
+					std::string_view s;
+					if (offset >= size || !read_string(data, size, offset, s)) return false;
+					list.push_back(std::string(s));
+				}
+				break;
+			case 'T':
+				list.push_back(true);
+				break;
+			case 'F':
+				list.push_back(false);
+				break;
+			case 'I':
+				list.push_back(ossia::impulse {});
+				break;
+			case 'N':
+				break;
+			case '[':
+				lists.emplace_back();
+				break;
+			case ']':
+				{
+					if (lists.size() < 2) return false;
+					ossia::value nested(std::move(lists.back()));
+					lists.pop_back();
+					lists.back().push_back(std::move(nested));
+				}
+				break;
+			default:
+				//blobs, midi, etc aren't mapped to parameters, skip the message
+				return true;
+		}
+	}
+	if (lists.size() != 1) {
+		return false;
+	}
+
+	auto& args = lists.front();
+	mAddr.assign(addr);
+	if (args.empty()) {
+		mCallback(mAddr, ossia::value(ossia::impulse {}), when);
+	} else if (args.size() == 1) {
+		mCallback(mAddr, args.front(), when);
+	} else {
+		mCallback(mAddr, ossia::value(std::move(args)), when);
+	}
+	return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <string>
+
+#include <boost/optional.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/udp.hpp>
+
+#include <ossia/network/value/value.hpp>
+
+//receives OSC over UDP, keeping the bundle timetags that ossia's OSC server discards
+//handlers run in the thread that runs the io_context
+class OSCTimedReceiver {
+	public:
+		//when is none for messages that should be applied immediately
+		using Callback = std::function<void(const std::string& addr, const ossia::value& v, boost::optional<std::chrono::system_clock::time_point> when)>;
+
+		OSCTimedReceiver(boost::asio::io_context& context, uint16_t port, Callback cb);
+		~OSCTimedReceiver();
+
+		OSCTimedReceiver(const OSCTimedReceiver&) = delete;
+		OSCTimedReceiver& operator=(const OSCTimedReceiver&) = delete;
+	private:
+		void receive();
+		bool parsePacket(const char * data, size_t size, boost::optional<std::chrono::system_clock::time_point> when, int depth);
+		bool parseMessage(const char * data, size_t size, boost::optional<std::chrono::system_clock::time_point> when);
+
+		boost::asio::ip::udp::socket mSocket;
+		boost::asio::ip::udp::endpoint mSender;
+		std::array<char, 65536> mBuffer;
+		Callback mCallback;
+		std::string mAddr;
+};
@@ -0,0 +1,123 @@
+#include "ParamBatch.h"
+
+#include <cstring>
+#include <string>
+
+namespace {
+	const std::string * blob(const ossia::value& v) {
+		if (v.get_type() == ossia::val_type::STRING) {
+			return &v.get<std::string>();
+		}
+		if (v.get_type() == ossia::val_type::LIST) {
+			const auto& l = v.get<std::vector<ossia::value>>();
+			if (l.size() == 1 && l[0].get_type() == ossia::val_type::STRING) {
+				return &l[0].get<std::string>();
+			}
+		}
+		return nullptr;
+	}
+
+	bool number(const ossia::value& v, double& out) {
+		switch (v.get_type()) {
+			case ossia::val_type::FLOAT:
+				out = static_cast<double>(v.get<float>());
+				return true;
+			case ossia::val_type::INT:
+				out = static_cast<double>(v.get<int>());
+				return true;
+			case ossia::val_type::BOOL:
+				out = v.get<bool>() ? 1.0 : 0.0;
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	uint32_t read_u32(const char * data) {
+		const auto b = reinterpret_cast<const uint8_t *>(data);
+		return static_cast<uint32_t>(b[0]) | (static_cast<uint32_t>(b[1]) << 8) | (static_cast<uint32_t>(b[2]) << 16) | (static_cast<uint32_t>(b[3]) << 24);
+	}
+
+	float read_f32(const char * data) {
+		uint32_t bits = read_u32(data);
+		float f;
+		std::memcpy(&f, &bits, sizeof(f));
+		return f;
+	}
+
+	//flatten a list of numbers, requiring a multiple of stride entries
+	bool numbers(const ossia::value& v, size_t stride, std::vector<double>& out) {
+		if (v.get_type() != ossia::val_type::LIST) {
+			return false;
+		}
+		const auto& l = v.get<std::vector<ossia::value>>();
+		if (l.size() % stride != 0) {
+			return false;
+		}
+		out.resize(l.size());
+		for (size_t i = 0; i < l.size(); i++) {
+			if (!number(l[i], out[i])) {
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+namespace parambatch {
+	bool decode(const ossia::value& v, std::vector<Entry>& out) {
+		out.clear();
+		if (auto b = blob(v)) {
+			const size_t record = 8;
+			if (b->size() % record != 0) {
+				return false;
+			}
+			out.reserve(b->size() / record);
+			for (size_t i = 0; i < b->size(); i += record) {
+				out.emplace_back(read_u32(b->data() + i), read_f32(b->data() + i + 4));
+			}
+			return true;
+		}
+
+		std::vector<double> values;
+		if (!numbers(v, 2, values)) {
+			return false;
+		}
+		out.reserve(values.size() / 2);
+		for (size_t i = 0; i < values.size(); i += 2) {
+			if (values[i] < 0.0) {
+				return false;
+			}
+			out.emplace_back(static_cast<RNBO::ParameterIndex>(values[i]), values[i + 1]);
+		}
+		return true;
+	}
+
+	bool decode(const ossia::value& v, std::vector<InstanceEntry>& out) {
+		out.clear();
+		if (auto b = blob(v)) {
+			const size_t record = 12;
+			if (b->size() % record != 0) {
+				return false;
+			}
+			out.reserve(b->size() / record);
+			for (size_t i = 0; i < b->size(); i += record) {
+				out.emplace_back(read_u32(b->data() + i), read_u32(b->data() + i + 4), read_f32(b->data() + i + 8));
+			}
+			return true;
+		}
+
+		std::vector<double> values;
+		if (!numbers(v, 3, values)) {
+			return false;
+		}
+		out.reserve(values.size() / 3);
+		for (size_t i = 0; i < values.size(); i += 3) {
+			if (values[i] < 0.0 || values[i + 1] < 0.0) {
+				return false;
+			}
+			out.emplace_back(static_cast<unsigned int>(values[i]), static_cast<RNBO::ParameterIndex>(values[i + 1]), values[i + 2]);
+		}
+		return true;
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+#include <tuple>
+#include <ossia/network/value/value.hpp>
+#include "RNBO.h"
+
+//decoding of bulk parameter updates
+//values can be a list of numbers or a blob (delivered by ossia as a string) of packed little endian records
+namespace parambatch {
+	using Entry = std::pair<RNBO::ParameterIndex, RNBO::ParameterValue>;
+	//instance index, parameter index, value
+	using InstanceEntry = std::tuple<unsigned int, RNBO::ParameterIndex, RNBO::ParameterValue>;
+
+	//list: index value [index value ...]
+	//blob: [uint32 index, float32 value] ...
+	//returns false if the input is malformed
+	bool decode(const ossia::value& v, std::vector<Entry>& out);
+
+	//list: instance index value [instance index value ...]
+	//blob: [uint32 instance, uint32 index, float32 value] ...
+	//returns false if the input is malformed
+	bool decode(const ossia::value& v, std::vector<InstanceEntry>& out);
+};
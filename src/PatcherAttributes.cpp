@@ -0,0 +1,72 @@
+#include "PatcherAttributes.h"
+
+#include <algorithm>
+
+#include <ossia/network/generic/generic_parameter.hpp>
+
+const std::string * PatcherAttributes::Enum::name(int value) const {
+	if (value >= 0 && static_cast<size_t>(value) < valToName.size()) {
+		return &valToName[value];
+	}
+	return nullptr;
+}
+
+boost::optional<RNBO::ParameterValue> PatcherAttributes::Enum::value(const std::string& name) const {
+	auto it = std::lower_bound(nameToVal.begin(), nameToVal.end(), name, [](const auto& entry, const std::string& n) { return entry.first < n; });
+	if (it != nameToVal.end() && it->first == name) {
+		return it->second;
+	}
+	return boost::none;
+}
+
+std::shared_ptr<const PatcherAttributes::Enum> PatcherAttributes::enumInfo(RNBO::ParameterIndex index, const RNBO::ParameterInfo& info) {
+	std::lock_guard<std::mutex> guard(mMutex);
+	auto it = mEnums.find(index);
+	if (it != mEnums.end()) {
+		return it->second;
+	}
+
+	auto e = std::make_shared<Enum>();
+	std::vector<ossia::value> values;
+	values.reserve(info.steps);
+	e->valToName.reserve(info.steps);
+	e->nameToVal.reserve(info.steps);
+	for (int i = 0; i < info.steps; i++) {
+		std::string s(info.enumValues[i]);
+		values.push_back(s);
+		e->nameToVal.emplace_back(s, static_cast<RNBO::ParameterValue>(i));
+		e->valToName.push_back(s);
+	}
+	std::sort(e->nameToVal.begin(), e->nameToVal.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	e->domain = ossia::init_domain(ossia::val_type::STRING);
+	ossia::set_values(e->domain, values);
+
+	mEnums.emplace(index, e);
+	return e;
+}
+
+std::shared_ptr<const std::string> PatcherAttributes::intern(const std::string& s) {
+	std::lock_guard<std::mutex> guard(mMutex);
+	auto it = mStrings.find(s);
+	if (it != mStrings.end()) {
+		return it->second;
+	}
+	auto v = std::make_shared<const std::string>(s);
+	mStrings.emplace(std::string_view(*v), v);
+	return v;
+}
+
+size_t PatcherAttributes::bytes(const Enum& e) {
+	size_t total = 0;
+	for (const auto& s: e.valToName) {
+		//once for each table, the domain holds a third copy
+		total += 3 * bytes(s);
+	}
+	total += sizeof(RNBO::ParameterValue) * e.nameToVal.size();
+	return total;
+}
+
+size_t PatcherAttributes::bytes(const std::string& s) {
+	return sizeof(std::string) + s.capacity();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/optional.hpp>
+#include <ossia/network/domain/domain.hpp>
+
+#include "RNBO.h"
+
+//immutable data that is identical for every instance of a patcher
+//built by the first instance that asks for it and shared by all the others
+class PatcherAttributes {
+	public:
+		struct Enum {
+			std::vector<std::string> valToName; //indexed by enum value
+			std::vector<std::pair<std::string, RNBO::ParameterValue>> nameToVal; //sorted by name
+			ossia::domain domain; //string domain of the names
+
+			const std::string * name(int value) const;
+			boost::optional<RNBO::ParameterValue> value(const std::string& name) const;
+		};
+
+		//lookup tables for an enum parameter, info must describe the parameter at index
+		std::shared_ptr<const Enum> enumInfo(RNBO::ParameterIndex index, const RNBO::ParameterInfo& info);
+
+		//a single shared copy of s, for serialized meta defaults and the like
+		std::shared_ptr<const std::string> intern(const std::string& s);
+
+		//approximate heap bytes of one table or string, for diagnostics
+		static size_t bytes(const Enum& e);
+		static size_t bytes(const std::string& s);
+	private:
+		std::mutex mMutex;
+		std::unordered_map<RNBO::ParameterIndex, std::shared_ptr<const Enum>> mEnums;
+		std::unordered_map<std::string_view, std::shared_ptr<const std::string>> mStrings; //keys view the values
+};
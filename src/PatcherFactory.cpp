@@ -2,6 +2,8 @@
 #include <dlfcn.h>
 #include <iostream>
 #include <exception>
+#include <mutex>
+#include <unordered_map>
 #include <boost/filesystem.hpp>
 
 using std::endl;
@@ -10,6 +12,12 @@ using std::runtime_error;
 
 namespace fs = boost::filesystem;
 
+namespace {
+	//instances of the same library share a factory, and with it the patcher's attributes
+	std::mutex factories_mutex;
+	std::unordered_map<std::string, std::weak_ptr<PatcherFactory>> factories;
+}
+
 #ifndef RNBO_OSCQUERY_BUILTIN_PATCHER
 RNBO::PatcherFactoryFunctionPtr GetPatcherFactoryFunction() {
 	throw new std::runtime_error("global factory allocation not supported");
@@ -44,6 +52,15 @@ RNBO::UniquePtr<RNBO::PatcherInterface> PatcherFactory::createInstance() {
 }
 
 std::shared_ptr<PatcherFactory> PatcherFactory::CreateFactory(const std::string& dllPath) {
+	std::lock_guard<std::mutex> guard(factories_mutex);
+	auto it = factories.find(dllPath);
+	if (it != factories.end()) {
+		if (auto f = it->second.lock()) {
+			return f;
+		}
+		factories.erase(it);
+	}
+
 	if (!fs::exists(dllPath)) {
 		throw new runtime_error("dynamic library file does not exist: " + dllPath);
 	}
@@ -70,5 +87,7 @@ std::shared_ptr<PatcherFactory> PatcherFactory::CreateFactory(const std::string&
 		setLoggerFunc(&RNBO::Logger::getInstance());
 	}
 
-	return std::shared_ptr<PatcherFactory>(new PatcherFactory(handle, factory));
+	auto f = std::shared_ptr<PatcherFactory>(new PatcherFactory(handle, factory));
+	factories[dllPath] = f;
+	return f;
 }
@@ -4,10 +4,11 @@
 
 #include <memory>
 #include "RNBO.h"
+#include "PatcherAttributes.h"
 
 class PatcherFactory {
 	public:
-		/// Create a factory with the DLL at the given path.
+		/// Create a factory with the DLL at the given path, or get the existing one if it is still in use.
 		/// Throws on error, returns on success.
 		static std::shared_ptr<PatcherFactory> CreateFactory(const std::string& dllPath) noexcept(false);
 
@@ -17,6 +18,8 @@ class PatcherFactory {
 
 		/// Create an instance.
 		RNBO::UniquePtr<RNBO::PatcherInterface> createInstance();
+		/// Data shared by every instance created by this factory.
+		PatcherAttributes& attributes() { return mAttributes; }
 		~PatcherFactory();
 	protected:
 		PatcherFactory(void * handle, RNBO::PatcherFactoryFunctionPtr factory);
@@ -28,4 +31,5 @@ class PatcherFactory {
 
 		RNBO::PatcherFactoryFunctionPtr mFactory;
 		void * mHandle;
+		PatcherAttributes mAttributes;
 };
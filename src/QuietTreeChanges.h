@@ -0,0 +1,18 @@
+#pragma once
+
+//while in scope, nodes and parameters created or removed by this thread aren't reported to the runner's own
+//tree listeners: the OSC route cache, the ingest routes and the namespace cache
+//for building a subtree in bulk, report a single change once it is done
+//ossia's OSCQuery server listens to the same device signals and still sees every one of them
+class QuietTreeChanges {
+	public:
+		QuietTreeChanges() : mPrevious(tActive) { tActive = true; }
+		~QuietTreeChanges() { tActive = mPrevious; }
+		QuietTreeChanges(const QuietTreeChanges&) = delete;
+		QuietTreeChanges& operator=(const QuietTreeChanges&) = delete;
+
+		static bool active() { return tActive; }
+	private:
+		static inline thread_local bool tActive = false;
+		bool mPrevious;
+};
@@ -0,0 +1,100 @@
+#include "Reactor.h"
+
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+namespace {
+	std::atomic<int> wake_fd(-1);
+	//set while a wakeup is outstanding so we only write to the wake descriptor once per loop iteration
+	std::atomic<bool> wake_pending(false);
+
+	//returns the read end, write is set to the end that wake writes to
+	//linux gets an eventfd, everything else a non blocking self pipe
+	int open_wake_fd(int& write) {
+#ifdef __linux__
+		int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		write = fd;
+		return fd;
+#else
+		int fds[2] = {-1, -1};
+		if (::pipe(fds) != 0) {
+			std::cerr << "failed to create reactor wake pipe" << std::endl;
+			write = -1;
+			return -1;
+		}
+		for (auto fd: fds) {
+			::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+			::fcntl(fd, F_SETFD, FD_CLOEXEC);
+		}
+		write = fds[1];
+		return fds[0];
+#endif
+	}
+}
+
+Reactor::Reactor(boost::asio::io_context& context) :
+	mContext(context),
+	mDescriptor(context, open_wake_fd(mWriteFd))
+{
+	wake_fd.store(mWriteFd);
+}
+
+Reactor::~Reactor() {
+	wake_fd.store(-1);
+	boost::system::error_code ec;
+	mDescriptor.cancel(ec);
+	//the eventfd is both ends, the descriptor closes it
+	if (mWriteFd >= 0 && mWriteFd != mDescriptor.native_handle()) {
+		::close(mWriteFd);
+	}
+}
+
+void Reactor::wake() {
+	if (!wake_pending.exchange(true)) {
+		int fd = wake_fd.load();
+		if (fd >= 0) {
+			uint64_t v = 1;
+			//nothing to do on failure, the descriptor is already readable
+			auto r = ::write(fd, &v, sizeof(v));
+			(void)r;
+		}
+	}
+}
+
+void Reactor::arm() {
+	if (mArmed) {
+		return;
+	}
+	mArmed = true;
+	mDescriptor.async_wait(boost::asio::posix::stream_descriptor::wait_read, [this](const boost::system::error_code& ec) {
+		if (ec == boost::asio::error::operation_aborted) {
+			return;
+		}
+		mArmed = false;
+		//an eventfd reads its whole counter at once, a pipe may hold several writes
+		uint64_t v;
+		while (::read(mDescriptor.native_handle(), &v, sizeof(v)) > 0) { }
+	});
+}
+
+bool Reactor::wait(std::chrono::steady_clock::time_point deadline) {
+	arm();
+	if (mContext.stopped()) {
+		mContext.restart();
+	}
+
+	size_t handled = 0;
+	//don't block if a wakeup came in while we were processing
+	if (!wake_pending.load()) {
+		handled = mContext.run_one_until(deadline);
+	}
+	//run anything else that is ready
+	handled += mContext.poll();
+
+	return wake_pending.exchange(false) || handled > 0;
+}
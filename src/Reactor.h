@@ -0,0 +1,30 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+
+//blocks the main loop until there is work to do
+//waits on the ossia io_context (so network traffic wakes it) with an eventfd (a pipe off linux) registered for explicit wakeups
+class Reactor {
+	public:
+		Reactor(boost::asio::io_context& context);
+		~Reactor();
+
+		//wake the main loop, safe to call from any thread, including the audio thread and signal handlers
+		//queue work before calling so the woken loop sees it
+		static void wake();
+
+		//run io_context handlers in the calling thread until woken or the deadline passes
+		//returns true if anything happened, false if the deadline passed
+		bool wait(std::chrono::steady_clock::time_point deadline);
+	private:
+		void arm();
+
+		boost::asio::io_context& mContext;
+		int mWriteFd = -1;
+		boost::asio::posix::stream_descriptor mDescriptor;
+		bool mArmed = false;
+};
@@ -0,0 +1,150 @@
+#include "ShmControl.h"
+#include "OSCIngest.h"
+
+#include <new>
+
+#include <unistd.h>
+
+#ifdef __linux__
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+using namespace shmcontrol;
+
+namespace {
+	//how long the command thread sleeps without a doorbell, so it notices shutdown
+	const long idle_wait_ns = 100000000;
+
+	size_t align_up(size_t v, size_t a) {
+		return (v + a - 1) / a * a;
+	}
+
+	//wait for the doorbell to change from value, spurious returns are fine
+	void wait_doorbell(std::atomic<uint32_t>& doorbell, uint32_t value) {
+#ifdef __linux__
+		struct timespec ts;
+		ts.tv_sec = 0;
+		ts.tv_nsec = idle_wait_ns;
+		//shared with another process so this cannot be the private variant
+		syscall(SYS_futex, reinterpret_cast<uint32_t *>(&doorbell), FUTEX_WAIT, value, &ts, nullptr, 0);
+#else
+		(void)doorbell;
+		(void)value;
+		usleep(250);
+#endif
+	}
+}
+
+ShmControl::ShmControl(const std::string& prefix, size_t numParams, std::shared_ptr<OSCIngestTarget> target, size_t commandCapacity) :
+	mTarget(target),
+	mNumParams(numParams)
+{
+	size_t capacity = 2;
+	while (capacity < commandCapacity) {
+		capacity <<= 1;
+	}
+
+	const size_t paramsOffset = align_up(sizeof(Header), 64);
+	const size_t commandsOffset = align_up(paramsOffset + numParams * sizeof(ParamSlot), 64);
+	const size_t size = commandsOffset + capacity * sizeof(Command);
+	mCommandCapacity = capacity;
+
+	mRegion = std::make_unique<ShmRegion>(prefix, size);
+	mData = mRegion->data();
+
+	//the region is zero filled, construct the atomics in place
+	mHeader = new (mData) Header();
+	mParams = reinterpret_cast<ParamSlot *>(mData + paramsOffset);
+	for (size_t i = 0; i < numParams; i++) {
+		new (mParams + i) ParamSlot();
+	}
+	mCommands = reinterpret_cast<Command *>(mData + commandsOffset);
+
+	mHeader->version = version;
+	mHeader->numParams = static_cast<uint32_t>(numParams);
+	mHeader->commandCapacity = static_cast<uint32_t>(capacity);
+	mHeader->paramsOffset = static_cast<uint32_t>(paramsOffset);
+	mHeader->commandsOffset = static_cast<uint32_t>(commandsOffset);
+	//written last so clients know the rest is valid
+	std::atomic_thread_fence(std::memory_order_release);
+	mHeader->magic = magic;
+
+	mThread = std::thread(&ShmControl::run, this);
+}
+
+ShmControl::~ShmControl() {
+	mRunning = false;
+	if (mThread.joinable()) {
+		mThread.join();
+	}
+}
+
+void ShmControl::mirror(RNBO::ParameterIndex index, RNBO::ParameterValue value, RNBO::ParameterValue normalized) {
+	if (index >= mNumParams) {
+		return;
+	}
+	auto& slot = mParams[index];
+
+	//there may be more than one writer, take the slot by making the sequence odd
+	uint32_t seq = slot.sequence.load(std::memory_order_relaxed);
+	while (true) {
+		if (seq & 1) {
+			seq = slot.sequence.load(std::memory_order_relaxed);
+			continue;
+		}
+		if (slot.sequence.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+			break;
+		}
+	}
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.value.store(value, std::memory_order_relaxed);
+	slot.normalized.store(normalized, std::memory_order_relaxed);
+	slot.sequence.store(seq + 2, std::memory_order_release);
+}
+
+void ShmControl::run() {
+	const uint64_t mask = mCommandCapacity - 1;
+	while (mRunning) {
+		uint32_t doorbell = mHeader->doorbell.load(std::memory_order_acquire);
+		uint64_t read = mHeader->commandRead.load(std::memory_order_relaxed);
+		uint64_t write = mHeader->commandWrite.load(std::memory_order_acquire);
+
+		if (read == write) {
+			wait_doorbell(mHeader->doorbell, doorbell);
+			continue;
+		}
+
+		//a misbehaving client could move write anywhere, never read more than the ring holds
+		if (write - read > mCommandCapacity) {
+			read = write - mCommandCapacity;
+		}
+		for (; read != write; read++) {
+			apply(mCommands[read & mask]);
+		}
+		mHeader->commandRead.store(read, std::memory_order_release);
+	}
+}
+
+void ShmControl::apply(const Command& cmd) {
+	switch (static_cast<CommandKind>(cmd.kind)) {
+		case CommandKind::Param:
+			mTarget->setParameterValue(cmd.target, cmd.value);
+			break;
+		case CommandKind::NormalizedParam:
+			mTarget->setNormalizedParameterValue(cmd.target, cmd.value);
+			break;
+		case CommandKind::Inport:
+			{
+				RNBO::number v = cmd.value;
+				mTarget->sendMessage(cmd.target, &v, 1);
+			}
+			break;
+		case CommandKind::InportBang:
+			mTarget->sendMessage(cmd.target, nullptr, 0);
+			break;
+		default:
+			break;
+	}
+}
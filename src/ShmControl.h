@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "RNBO.h"
+#include "ShmRegion.h"
+
+class OSCIngestTarget;
+
+//layout of the shared memory control region, for processes on the same machine that want to skip OSC
+//
+//the region starts with a Header, followed by numParams ParamSlots at paramsOffset and
+//commandCapacity Commands at commandsOffset, all offsets are in bytes from the start of the region
+//
+//commands: a single producer, single consumer ring, the client is the only producer
+//  write the command at commands[commandWrite % commandCapacity] if commandWrite - commandRead < commandCapacity,
+//  then store commandWrite + 1 with release semantics and increment doorbell
+//  the runner may be sleeping on doorbell, wake it with FUTEX_WAKE (not the private variant) on linux
+//
+//parameters: each slot is protected by a seqlock
+//  read sequence, retry while it is odd, read the values, read sequence again and retry if it changed
+namespace shmcontrol {
+	const uint32_t magic = 0x524e4243; //"RNBC"
+	const uint32_t version = 1;
+
+	enum class CommandKind : uint32_t {
+		Param = 0, //target is the parameter index, value is in the parameter's range
+		NormalizedParam = 1, //target is the parameter index, value is 0..1
+		Inport = 2, //target is the inport message tag, value is sent as a single number
+		InportBang = 3 //target is the inport message tag, value is ignored
+	};
+
+	struct Command {
+		uint32_t kind;
+		uint32_t target;
+		double value;
+	};
+	static_assert(sizeof(Command) == 16);
+
+	struct ParamSlot {
+		std::atomic<uint32_t> sequence;
+		uint32_t reserved0;
+		std::atomic<double> value;
+		std::atomic<double> normalized;
+		uint64_t reserved1;
+	};
+	static_assert(sizeof(ParamSlot) == 32);
+
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t numParams;
+		uint32_t commandCapacity; //a power of 2
+		uint32_t paramsOffset;
+		uint32_t commandsOffset;
+
+		//written by the client
+		alignas(64) std::atomic<uint64_t> commandWrite;
+		std::atomic<uint32_t> doorbell;
+
+		//written by the runner
+		alignas(64) std::atomic<uint64_t> commandRead;
+	};
+
+	static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<double>::is_always_lock_free, "shared atomics must not need locks");
+}
+
+//a shared memory region that lets a local process set parameters, send to inports and read back parameter values
+//commands are applied from a thread of our own through the same path as the OSC ingest port
+class ShmControl {
+	public:
+		//the region is named after prefix, see ShmRegion, throws if it cannot be created
+		ShmControl(const std::string& prefix, size_t numParams, std::shared_ptr<OSCIngestTarget> target, size_t commandCapacity = 1024);
+		~ShmControl();
+
+		ShmControl(const ShmControl&) = delete;
+		ShmControl& operator=(const ShmControl&) = delete;
+
+		//the name to pass to shm_open
+		const std::string& name() const { return mRegion->name(); }
+
+		//update the value mirror, may be called from multiple threads
+		void mirror(RNBO::ParameterIndex index, RNBO::ParameterValue value, RNBO::ParameterValue normalized);
+	private:
+		void run();
+		void apply(const shmcontrol::Command& cmd);
+
+		std::shared_ptr<OSCIngestTarget> mTarget;
+
+		std::unique_ptr<ShmRegion> mRegion;
+		char * mData = nullptr;
+		//local copies, the client can write to the header
+		size_t mNumParams = 0;
+		uint64_t mCommandCapacity = 0;
+		shmcontrol::Header * mHeader = nullptr;
+		shmcontrol::ParamSlot * mParams = nullptr;
+		shmcontrol::Command * mCommands = nullptr;
+
+		std::atomic<bool> mRunning = true;
+		std::thread mThread;
+};
@@ -0,0 +1,65 @@
+#include "ShmRegion.h"
+
+#include <atomic>
+#include <cerrno>
+#include <stdexcept>
+
+//shm
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+	std::atomic<uint64_t> name_counter = 0;
+	//a name is only taken if a previous process with our pid didn't clean up, skip those rather than remove them
+	const int max_name_attempts = 16;
+}
+
+ShmRegion::ShmRegion(const std::string& prefix, size_t size) : mSize(size) {
+	int fd = -1;
+	for (int i = 0; i < max_name_attempts && fd < 0; i++) {
+		mName = prefix + "-" + std::to_string(getpid()) + "-" + std::to_string(name_counter.fetch_add(1));
+		fd = shm_open(mName.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+		if (fd < 0 && errno != EEXIST) {
+			break;
+		}
+	}
+	if (fd < 0) {
+		throw std::runtime_error("cannot open shared memory with name " + mName);
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) == 0) {
+		mDevice = static_cast<uint64_t>(st.st_dev);
+		mInode = static_cast<uint64_t>(st.st_ino);
+	}
+	if (ftruncate(fd, mSize) == -1) {
+		close(fd);
+		shm_unlink(mName.c_str());
+		throw std::runtime_error("cannot resize shared memory with name " + mName);
+	}
+	void * mapped = mmap(NULL, mSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED) {
+		shm_unlink(mName.c_str());
+		throw std::runtime_error("cannot mmap shared memory with name " + mName);
+	}
+	mData = reinterpret_cast<char *>(mapped);
+}
+
+ShmRegion::~ShmRegion() {
+	munmap(mData, mSize);
+
+	//only unlink the name if it still refers to the object we created
+	int fd = shm_open(mName.c_str(), O_RDONLY, 0);
+	if (fd < 0) {
+		return;
+	}
+	struct stat st;
+	const bool ours = fstat(fd, &st) == 0 && static_cast<uint64_t>(st.st_dev) == mDevice && static_cast<uint64_t>(st.st_ino) == mInode;
+	close(fd);
+	if (ours) {
+		shm_unlink(mName.c_str());
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//a POSIX shared memory region, created zero filled under a name nothing else is using and unlinked on destruction
+class ShmRegion {
+	public:
+		//the name is prefix followed by our process id and a counter, so regions of two runners on one host,
+		//or of an instance and the one replacing it, never share a name, publish name() so others can find it
+		//throws if the region cannot be created
+		ShmRegion(const std::string& prefix, size_t size);
+		~ShmRegion();
+
+		ShmRegion(const ShmRegion&) = delete;
+		ShmRegion& operator=(const ShmRegion&) = delete;
+
+		//the name to pass to shm_open
+		const std::string& name() const { return mName; }
+		char * data() const { return mData; }
+		size_t size() const { return mSize; }
+	private:
+		std::string mName;
+		char * mData = nullptr;
+		size_t mSize = 0;
+		//identify the object we created so we never unlink one we don't own
+		uint64_t mDevice = 0;
+		uint64_t mInode = 0;
+};
@@ -7,6 +7,7 @@
 #include "Controller.h"
 #include "Config.h"
 #include "Util.h"
+#include "Reactor.h"
 
 //for gethostname
 #include <unistd.h>
@@ -28,6 +29,7 @@ namespace {
 
 void signal_handler(int signal) {
 	mRun.store(false);
+	Reactor::wake();
 }
 
 int main(int argc, const char * argv[]) {
@@ -136,11 +138,12 @@ int main(int argc, const char * argv[]) {
 		auto config_timeout = std::chrono::seconds(1);
 		std::chrono::time_point<std::chrono::steady_clock> config_poll_next = steady_clock::now() + config_timeout;
 		while (c.processEvents() && mRun.load()) {
-			std::this_thread::sleep_for(std::chrono::milliseconds(2));
 			if (config_poll_next <= steady_clock::now()) {
 				config_poll_next = steady_clock::now() + config_timeout;
 				config::write_if_dirty();
 			}
+			//sleep until there is work to do or the config flush is due
+			c.waitForEvents(config_poll_next);
 		}
 	}
 	return 0;
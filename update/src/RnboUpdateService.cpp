@@ -269,7 +269,10 @@ bool RnboUpdateService::QueueInstall(const std::string& packageName, const std::
 	//make sure the version string is valid (so we don't allow injection)
 	if (!validation::version(version))
 		return false;
-	mInstallQueue.push(packageName + "=" + version);
+	if (!mInstallQueue.push(packageName + "=" + version)) {
+		std::cerr << "install queue full, dropping install of " << packageName << std::endl;
+		return false;
+	}
 	return true;
 }
 
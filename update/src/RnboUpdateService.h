@@ -18,7 +18,7 @@ class RnboUpdateService : public sdbus::AdaptorInterfaces<com::cycling74::rnbo_a
 	private:
 		bool mInit = true;
 		bool mUpdateOutdated = true;
-		Queue<std::string> mInstallQueue;
+		Queue<std::string> mInstallQueue{16}; //installs are rare and slow, callers are told when it is full
 
 		//return true on success
 		bool updatePackages();